@@ -0,0 +1,53 @@
+#include "AdaptivePollInterval.h"
+#include "Config.h"
+
+void AdaptivePollInterval::setBaseInterval(const unsigned long interval)
+{
+    _baseInterval = interval;
+    _factor = 1;
+}
+
+unsigned long AdaptivePollInterval::interval() const
+{
+    return _baseInterval * _factor;
+}
+
+void AdaptivePollInterval::onPoll(const bool changed)
+{
+    _polls++;
+
+    if(changed)
+    {
+        _changed++;
+        _factor = 1;
+    }
+    else if(_factor < NUKI_POLL_BACKOFF_MAX_FACTOR)
+    {
+        _factor *= 2;
+    }
+}
+
+void AdaptivePollInterval::tighten()
+{
+    _factor = 1;
+}
+
+uint32_t AdaptivePollInterval::pollCount() const
+{
+    return _polls;
+}
+
+uint32_t AdaptivePollInterval::changedCount() const
+{
+    return _changed;
+}
+
+void AdaptivePollInterval::getText(String& text) const
+{
+    text.concat(_changed);
+    text.concat(" of ");
+    text.concat(_polls);
+    text.concat(" polls returned new data, interval ");
+    text.concat(interval() / 1000);
+    text.concat(" s");
+}
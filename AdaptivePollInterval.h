@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Arduino.h>
+
+// Poll interval that doubles (up to NUKI_POLL_BACKOFF_MAX_FACTOR times the configured interval) every time a poll
+// returns the same data, and falls back to the configured interval when the data changed or an event suggests it will.
+// Also counts how many polls returned new data. Written by the nuki task only.
+class AdaptivePollInterval
+{
+public:
+    void setBaseInterval(const unsigned long interval); // ms
+
+    unsigned long interval() const; // ms
+    void onPoll(const bool changed);
+    void tighten();
+
+    uint32_t pollCount() const;
+    uint32_t changedCount() const;
+
+    void getText(String& text) const;
+
+private:
+    unsigned long _baseInterval = 0;
+    uint8_t _factor = 1;
+    uint32_t _polls = 0;
+    uint32_t _changed = 0;
+};
@@ -0,0 +1,81 @@
+#include "BleScanScheduler.h"
+#include "Logger.h"
+
+BleScanScheduler::BleScanScheduler(BleScanner::Scanner* scanner)
+: _scanner(scanner)
+{
+}
+
+void BleScanScheduler::initialize(const bool presenceDetectionEnabled)
+{
+    uint16_t interval = presenceDetectionEnabled ? BLE_SCAN_INTERVAL_PRESENCE : BLE_SCAN_INTERVAL_BEACONS;
+    uint16_t window = presenceDetectionEnabled ? BLE_SCAN_WINDOW_PRESENCE : BLE_SCAN_WINDOW_BEACONS;
+
+    _scanner->setScanParameters(interval, window);
+    _dutyCycle = window * 100 / interval;
+    _lastTs = millis();
+
+    LOG_INFO("BLE scan duty cycle: %u%%", _dutyCycle);
+}
+
+void BleScanScheduler::pause()
+{
+    account(millis());
+
+    if(_paused) return;
+
+    _paused = true;
+    _pauseCount++;
+    _scanner->enableScanning(false);
+    _scanning = false;
+}
+
+void BleScanScheduler::resume()
+{
+    account(millis());
+
+    if(_paused)
+    {
+        _paused = false;
+        _scanner->enableScanning(true);
+    }
+
+    _scanner->update();
+    _scanning = _scanner->isScanning();
+}
+
+// Books the time since the last call to the state the scheduler was left in
+void BleScanScheduler::account(const unsigned long ts)
+{
+    unsigned long elapsed = ts - _lastTs;
+    _lastTs = ts;
+
+    if(_paused)
+    {
+        _pausedTime += elapsed;
+    }
+    else if(_scanning)
+    {
+        _scanTime += elapsed * _dutyCycle / 100;
+    }
+}
+
+unsigned long BleScanScheduler::scanTime() const
+{
+    return _scanTime;
+}
+
+unsigned long BleScanScheduler::pausedTime() const
+{
+    return _pausedTime;
+}
+
+uint32_t BleScanScheduler::pauseCount() const
+{
+    return _pauseCount;
+}
+
+uint8_t BleScanScheduler::dutyCycle() const
+{
+    return _dutyCycle;
+}
@@ -0,0 +1,42 @@
+#pragma once
+
+#include "BleScanner.h"
+
+// Continuous scan while presence detection needs every advertisement
+#define BLE_SCAN_INTERVAL_PRESENCE 23 // ms
+#define BLE_SCAN_WINDOW_PRESENCE 23 // ms
+// Only the Nuki beacons are of interest otherwise, leave the radio idle half of the time
+#define BLE_SCAN_INTERVAL_BEACONS 100 // ms
+#define BLE_SCAN_WINDOW_BEACONS 50 // ms
+
+// Arbitrates the radio between the BLE scanner and the GATT connections to the lock and opener. The nuki task
+// pauses scanning while it talks to a device and resumes it afterwards, so commands don't compete with
+// scan windows. Only to be used from the nuki task, the metrics may be read from any task.
+class BleScanScheduler
+{
+public:
+    explicit BleScanScheduler(BleScanner::Scanner* scanner);
+
+    void initialize(const bool presenceDetectionEnabled);
+
+    void pause(); // stops a running scan until resume()
+    void resume(); // restarts the scan if it isn't running
+
+    // Time the radio spent scanning (by duty cycle) and paused for device communication since boot
+    unsigned long scanTime() const; // ms
+    unsigned long pausedTime() const; // ms
+    uint32_t pauseCount() const;
+    uint8_t dutyCycle() const; // percent
+
+private:
+    void account(const unsigned long ts);
+
+    BleScanner::Scanner* _scanner;
+    bool _paused = false;
+    bool _scanning = false;
+    uint8_t _dutyCycle = 100;
+    unsigned long _lastTs = 0;
+    unsigned long _scanTime = 0;
+    unsigned long _pausedTime = 0;
+    uint32_t _pauseCount = 0;
+};
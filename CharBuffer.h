@@ -1,13 +0,0 @@
-#pragma once
-
-#define CHAR_BUFFER_SIZE 4096
-
-class CharBuffer
-{
-public:
-    static void initialize();
-    static char* get();
-
-private:
-    static char* _buffer;
-};
\ No newline at end of file
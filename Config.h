@@ -5,4 +5,38 @@
 #define MQTT_QOS_LEVEL 1
 #define MQTT_CLEAN_SESSIONS false
 
-#define GPIO_DEBOUNCE_TIME 200
\ No newline at end of file
+#define GPIO_DEBOUNCE_TIME 200
+
+// Upper bound for the nuki task idle wait, keeps the BLE scanner and the beacon watchdog serviced
+#define NUKI_TASK_MAX_IDLE_TIME 1000
+
+// Disconnect timeout (ms) of the nuki library, used again when a BLE session ends
+#define NUKI_BLE_DISCONNECT_TIMEOUT 1000
+
+// Once a status refresh is due, the ones due within this window (ms) are run in the same connection
+#define NUKI_REFRESH_BATCH_WINDOW 60000
+// Polls that return unchanged data double the interval, up to this factor of the configured interval (power of two)
+#define NUKI_POLL_BACKOFF_MAX_FACTOR 4
+// Battery voltage difference (mV) that counts as a new battery report
+#define NUKI_BATTERY_VOLTAGE_STEP 20
+// State refresh after a successful lock action (ms)
+#define NUKI_LOCK_ACTION_REFRESH_DELAY 5000
+// Waits (ms) for the log entry count and the log entries to arrive, polled in small steps
+#define NUKI_LOG_COUNT_TIMEOUT 100
+#define NUKI_LOG_ENTRIES_TIMEOUT 1000
+#define NUKI_LOG_POLL_INTERVAL 10
+
+// Time (ms) the web task waits for the nuki task to remove the HASS discovery configs
+#define NUKI_DISABLE_HASS_TIMEOUT 5000
+
+// Pause (ms) between two web server polls of the web task, a slow client never holds up the network task
+#define WEB_CFG_TASK_INTERVAL 10
+
+// Number of pending lock actions, keypad commands and config updates per device, must be a power of two
+#define NUKI_COMMAND_QUEUE_SIZE 8
+
+// Largest inbound MQTT payload (after reassembly of fragments) passed to the receivers, larger messages are dropped
+#define MQTT_INBOUND_PAYLOAD_SIZE 4096
+
+// Maximum number of entries in a bulk keypad command (keypad/commandJson)
+#define NUKI_KEYPAD_BATCH_MAX_OPERATIONS 32
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define FNV1A_OFFSET_BASIS 2166136261u
+
+// 32 bit FNV-1a, pass the previous result as hash to continue over several strings
+inline uint32_t fnv1a(const char* str, uint32_t hash = FNV1A_OFFSET_BASIS)
+{
+    while(*str != 0)
+    {
+        hash ^= (uint8_t)*str;
+        hash *= 16777619u;
+        ++str;
+    }
+    return hash;
+}
+
+inline uint32_t fnv1aBytes(const void* data, const size_t length, uint32_t hash = FNV1A_OFFSET_BASIS)
+{
+    const uint8_t* bytes = (const uint8_t*)data;
+    for(size_t i = 0; i < length; ++i)
+    {
+        hash ^= bytes[i];
+        hash *= 16777619u;
+    }
+    return hash;
+}
@@ -0,0 +1,165 @@
+#include "HassDiscovery.h"
+#include "Logger.h"
+#include <algorithm>
+
+HassDiscovery::HassDiscovery(Network* network, Preferences* preferences, const char* hashPreferenceKey)
+: _network(network),
+  _preferences(preferences),
+  _hashPreferenceKey(hashPreferenceKey)
+{
+    memset(&_device, 0, sizeof(_device));
+}
+
+void HassDiscovery::begin(const char* deviceType, const char* baseTopic, const char* name, const char* uidString,
+                          const char* lockAction, const char* unlockAction, const char* openAction, const char* lockedState, const char* unlockedState)
+{
+    if(!_hashesLoaded)
+    {
+        loadHashes();
+    }
+
+    memset(&_device, 0, sizeof(_device));
+    strncpy(_device.deviceType, deviceType, sizeof(_device.deviceType) - 1);
+    strncpy(_device.baseTopic, baseTopic, sizeof(_device.baseTopic) - 1);
+    strncpy(_device.name, name, sizeof(_device.name) - 1);
+    strncpy(_device.uidString, uidString, sizeof(_device.uidString) - 1);
+    strncpy(_device.lockAction, lockAction, sizeof(_device.lockAction) - 1);
+    strncpy(_device.unlockAction, unlockAction, sizeof(_device.unlockAction) - 1);
+    strncpy(_device.openAction, openAction, sizeof(_device.openAction) - 1);
+    strncpy(_device.lockedState, lockedState, sizeof(_device.lockedState) - 1);
+    strncpy(_device.unlockedState, unlockedState, sizeof(_device.unlockedState) - 1);
+
+    _stepCount = 0;
+    _currentStep = 0;
+    addStep(&hassLock, StepAction::PublishLock);
+}
+
+void HassDiscovery::addPublish(const HassEntity& entity)
+{
+    addStep(&entity, StepAction::Publish);
+}
+
+void HassDiscovery::addRemove(const HassEntity& entity)
+{
+    addStep(&entity, StepAction::Remove);
+}
+
+void HassDiscovery::addStep(const HassEntity* entity, const StepAction action)
+{
+    if(_stepCount >= HASS_DISCOVERY_MAX_STEPS)
+    {
+        Log->print(F("HASS discovery step limit reached, dropping "));
+        Log->println(entity->objectId);
+        return;
+    }
+
+    _steps[_stepCount].entity = entity;
+    _steps[_stepCount].action = action;
+    ++_stepCount;
+}
+
+void HassDiscovery::update()
+{
+    if(!pending() || millis() < _retryTs)
+    {
+        return;
+    }
+
+    uint32_t freeHeap = esp_get_free_heap_size();
+    if(freeHeap < HASS_DISCOVERY_MIN_FREE_HEAP)
+    {
+        if(!_lowHeapLogged)
+        {
+            Log->print(F("HASS discovery deferred, free heap: "));
+            Log->println(freeHeap);
+            _lowHeapLogged = true;
+        }
+        _retryTs = millis() + HASS_DISCOVERY_LOW_HEAP_RETRY_INTERVAL;
+        return;
+    }
+    _lowHeapLogged = false;
+    _retryTs = 0;
+
+    uint8_t published = 0;
+
+    while(_currentStep < _stepCount && published < HASS_DISCOVERY_STEPS_PER_TICK)
+    {
+        const Step& step = _steps[_currentStep];
+        uint32_t& hash = _hashes[step.entity->hashSlot];
+        HassPublishResult result;
+
+        switch(step.action)
+        {
+            case StepAction::PublishLock:
+                result = _network->publishHassLock(_device, hash);
+                break;
+            case StepAction::Publish:
+                result = _network->publishHassEntity(*step.entity, _device, hash);
+                break;
+            case StepAction::Remove:
+            default:
+                result = _network->removeHassEntity(*step.entity, _device, hash);
+                break;
+        }
+
+        if(result == HassPublishResult::Failed)
+        {
+            return;
+        }
+        if(result == HassPublishResult::Published)
+        {
+            _hashesChanged = true;
+            ++published;
+        }
+
+        ++_currentStep;
+    }
+
+    if(_currentStep >= _stepCount)
+    {
+        saveHashes();
+        Log->print(F("HASS setup for "));
+        Log->print(_device.deviceType);
+        Log->println(F(" completed."));
+    }
+}
+
+bool HassDiscovery::pending() const
+{
+    return _currentStep < _stepCount;
+}
+
+unsigned long HassDiscovery::nextUpdateTs() const
+{
+    return std::max(millis() + HASS_DISCOVERY_TICK_INTERVAL, _retryTs);
+}
+
+void HassDiscovery::clearHashes()
+{
+    _stepCount = 0;
+    _currentStep = 0;
+    memset(_hashes, 0, sizeof(_hashes));
+    _hashesLoaded = true;
+    _hashesChanged = true;
+    saveHashes();
+}
+
+void HassDiscovery::loadHashes()
+{
+    if(_preferences->getBytesLength(_hashPreferenceKey) == sizeof(_hashes))
+    {
+        _preferences->getBytes(_hashPreferenceKey, _hashes, sizeof(_hashes));
+    }
+    _hashesLoaded = true;
+}
+
+void HassDiscovery::saveHashes()
+{
+    if(!_hashesChanged)
+    {
+        return;
+    }
+
+    _preferences->putBytes(_hashPreferenceKey, _hashes, sizeof(_hashes));
+    _hashesChanged = false;
+}
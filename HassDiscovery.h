@@ -0,0 +1,66 @@
+#pragma once
+
+#include <Preferences.h>
+#include "Network.h"
+#include "HassEntities.h"
+
+#define HASS_DISCOVERY_MAX_STEPS 24
+#define HASS_DISCOVERY_STEPS_PER_TICK 2
+#define HASS_DISCOVERY_TICK_INTERVAL 50
+#define HASS_DISCOVERY_MIN_FREE_HEAP 30000
+#define HASS_DISCOVERY_LOW_HEAP_RETRY_INTERVAL 5000 // ms, retry delay while free heap is below the minimum
+
+// Publishes the Home Assistant discovery configs of one device a few entities per update() call, so the calling task
+// stays responsive. A failed publish (e.g. broker disconnected) leaves the run at the current step to be resumed on the
+// next call. The hash of every published config is persisted per entity, entities whose config didn't change are skipped.
+// The hashes are cleared when the broker comes back without a session, as its retained configs may be lost.
+class HassDiscovery
+{
+public:
+    explicit HassDiscovery(Network* network, Preferences* preferences, const char* hashPreferenceKey);
+
+    // Starts a new run with the lock entity as the first step, add the remaining entities before calling update()
+    void begin(const char* deviceType, const char* baseTopic, const char* name, const char* uidString,
+               const char* lockAction, const char* unlockAction, const char* openAction, const char* lockedState, const char* unlockedState);
+    void addPublish(const HassEntity& entity);
+    void addRemove(const HassEntity& entity);
+
+    void update();
+    bool pending() const;
+    unsigned long nextUpdateTs() const; // when update() should be called next while pending
+
+    // Cancels a run in progress and forgets all published configs. Call from the task that calls update().
+    void clearHashes();
+
+private:
+    enum class StepAction : uint8_t
+    {
+        PublishLock,
+        Publish,
+        Remove
+    };
+
+    struct Step
+    {
+        const HassEntity* entity;
+        StepAction action;
+    };
+
+    void addStep(const HassEntity* entity, const StepAction action);
+    void loadHashes();
+    void saveHashes();
+
+    Network* _network;
+    Preferences* _preferences;
+    const char* _hashPreferenceKey;
+
+    HassDevice _device;
+    Step _steps[HASS_DISCOVERY_MAX_STEPS];
+    uint32_t _hashes[HASS_ENTITY_SLOTS] = {0}; // indexed by HassEntity::hashSlot
+    uint8_t _stepCount = 0;
+    uint8_t _currentStep = 0;
+    bool _hashesLoaded = false;
+    bool _hashesChanged = false;
+    unsigned long _retryTs = 0;
+    bool _lowHeapLogged = false;
+};
@@ -0,0 +1,112 @@
+#pragma once
+
+#include <Arduino.h>
+#include "MqttTopics.h"
+
+// Home Assistant discovery descriptors. Everything except the device specific values (base topic, name, uid)
+// is known at compile time, Network::publishHassEntity streams a config payload straight from these.
+
+struct HassAttribute
+{
+    const char* key;
+    const char* value; // "true" and "false" are written as JSON booleans
+};
+
+struct HassEntity
+{
+    const char* component;
+    const char* objectId;
+    const char* uidPostfix;
+    const char* displayName;
+    const char* stateTopic;
+    const char* deviceClass;
+    const char* stateClass;
+    const char* entityCategory;
+    const char* commandTopic;
+    const HassAttribute* attributes;
+    uint8_t attributeCount;
+    uint8_t hashSlot; // index of the persisted config hash, fixed per entity
+};
+
+// Device specific values, copied so a discovery run can outlive the caller's buffers
+struct HassDevice
+{
+    char deviceType[21];
+    char baseTopic[181];
+    char name[33];
+    char uidString[20];
+    char lockAction[31];
+    char unlockAction[31];
+    char openAction[31];
+    char lockedState[21];
+    char unlockedState[21];
+};
+
+enum class HassPublishResult
+{
+    Published,
+    Unchanged,
+    Failed
+};
+
+// Size of the persisted config hash array, keep it and the existing slots stable, new entities take a free slot
+#define HASS_ENTITY_SLOTS 24
+
+#define HASS_ATTRIBUTES(attributes) attributes, sizeof(attributes) / sizeof(attributes[0])
+
+constexpr HassAttribute hassBinaryOnOffAttributes[] = { { "pl_on", "1" }, { "pl_off", "0" } };
+constexpr HassAttribute hassVoltageAttributes[] = { { "unit_of_meas", "V" } };
+constexpr HassAttribute hassPercentAttributes[] = { { "unit_of_meas", "%" } };
+constexpr HassAttribute hassSignalStrengthAttributes[] = { { "unit_of_meas", "dBm" } };
+constexpr HassAttribute hassEnabledByDefaultAttributes[] = { { "enabled_by_default", "true" } };
+constexpr HassAttribute hassVersionAttributes[] = { { "enabled_by_default", "true" }, { "ic", "mdi:counter" } };
+constexpr HassAttribute hassMqttConnectedAttributes[] = { { "pl_on", "online" }, { "pl_off", "offline" }, { "ic", "mdi:lan-connect" } };
+constexpr HassAttribute hassResetAttributes[] = { { "ic", "mdi:restart" }, { "pl_on", "1" }, { "pl_off", "0" }, { "state_on", "1" }, { "state_off", "0" } };
+constexpr HassAttribute hassLedEnabledAttributes[] = { { "ic", "mdi:led-variant-on" }, { "pl_on", "1" }, { "pl_off", "0" }, { "state_on", "1" }, { "state_off", "0" } };
+constexpr HassAttribute hassButtonEnabledAttributes[] = { { "ic", "mdi:radiobox-marked" }, { "pl_on", "1" }, { "pl_off", "0" }, { "state_on", "1" }, { "state_off", "0" } };
+constexpr HassAttribute hassDoorSensorAttributes[] = { { "pl_on", "doorOpened" }, { "pl_off", "doorClosed" }, { "pl_not_avail", "unavailable" } };
+constexpr HassAttribute hassRingDetectAttributes[] = { { "pl_on", "ring" }, { "pl_off", "locked" } };
+constexpr HassAttribute hassLedBrightnessAttributes[] = { { "ic", "mdi:brightness-6" }, { "min", "0" }, { "max", "5" } };
+constexpr HassAttribute hassSoundLevelAttributes[] = { { "ic", "mdi:volume-source" }, { "min", "0" }, { "max", "255" } };
+constexpr HassAttribute hassAccessLogAttributes[] = { { "ic", "mdi:format-list-bulleted" },
+    { "value_template", "{{ (value_json|selectattr('type', 'eq', 'LockAction')|selectattr('action', 'in', ['Lock', 'Unlock', 'Unlatch'])|first).authorizationName }}" } };
+constexpr HassAttribute hassKeypadAttemptAttributes[] = { { "ic", "mdi:drag-vertical" },
+    { "value_template", "{{ (value_json|selectattr('type', 'eq', 'KeypadAction')|first).completionStatus }}" } };
+
+// The lock entity carries the device specific actions and states, see Network::publishHassLock
+constexpr HassEntity hassLock = { "lock", "smartlock", "_lock", "", mqtt_topic_lock_binary_state, "", "", "", mqtt_topic_lock_action, nullptr, 0, 0 };
+constexpr HassEntity hassBatteryLow = { "binary_sensor", "battery_low", "_battery_low", "battery low", mqtt_topic_battery_critical, "battery", "", "diagnostic", "", HASS_ATTRIBUTES(hassBinaryOnOffAttributes), 1 };
+constexpr HassEntity hassKeypadBatteryLow = { "binary_sensor", "keypad_battery_low", "_keypad_battery_low", "keypad battery low", mqtt_topic_battery_keypad_critical, "battery", "", "diagnostic", "", HASS_ATTRIBUTES(hassBinaryOnOffAttributes), 2 };
+constexpr HassEntity hassBatteryVoltage = { "sensor", "battery_voltage", "_battery_voltage", "battery voltage", mqtt_topic_battery_voltage, "voltage", "measurement", "diagnostic", "", HASS_ATTRIBUTES(hassVoltageAttributes), 3 };
+constexpr HassEntity hassTrigger = { "sensor", "trigger", "_trigger", "trigger", mqtt_topic_lock_trigger, "", "", "diagnostic", "", HASS_ATTRIBUTES(hassEnabledByDefaultAttributes), 4 };
+constexpr HassEntity hassMqttConnected = { "binary_sensor", "mqtt_connected", "_mqtt_connected", "MQTT connected", mqtt_topic_mqtt_connection_state, "", "", "diagnostic", "", HASS_ATTRIBUTES(hassMqttConnectedAttributes), 5 };
+constexpr HassEntity hassReset = { "switch", "reset", "_reset", "Restart NUKI Hub", mqtt_topic_reset, "", "", "diagnostic", mqtt_topic_reset, HASS_ATTRIBUTES(hassResetAttributes), 6 };
+constexpr HassEntity hassFirmwareVersion = { "sensor", "firmware_version", "_firmware_version", "Firmware version", mqtt_topic_info_firmware_version, "", "", "diagnostic", "", HASS_ATTRIBUTES(hassVersionAttributes), 7 };
+constexpr HassEntity hassHardwareVersion = { "sensor", "hardware_version", "_hardware_version", "Hardware version", mqtt_topic_info_hardware_version, "", "", "diagnostic", "", HASS_ATTRIBUTES(hassVersionAttributes), 8 };
+constexpr HassEntity hassNukiHubVersion = { "sensor", "nuki_hub_version", "_nuki_hub__version", "NUKI Hub version", mqtt_topic_info_nuki_hub_version, "", "", "diagnostic", "", HASS_ATTRIBUTES(hassVersionAttributes), 9 };
+constexpr HassEntity hassLedEnabled = { "switch", "led_enabled", "_led_enabled", "LED enabled", mqtt_topic_config_led_enabled, "", "", "config", mqtt_topic_config_led_enabled, HASS_ATTRIBUTES(hassLedEnabledAttributes), 10 };
+constexpr HassEntity hassButtonEnabled = { "switch", "button_enabled", "_button_enabled", "Button enabled", mqtt_topic_config_button_enabled, "", "", "config", mqtt_topic_config_button_enabled, HASS_ATTRIBUTES(hassButtonEnabledAttributes), 11 };
+constexpr HassEntity hassBatteryLevel = { "sensor", "battery_level", "_battery_level", "battery level", mqtt_topic_battery_level, "battery", "measurement", "diagnostic", "", HASS_ATTRIBUTES(hassPercentAttributes), 12 };
+constexpr HassEntity hassDoorSensor = { "binary_sensor", "door_sensor", "_door_sensor", "door sensor", mqtt_topic_lock_door_sensor_state, "door", "", "", "", HASS_ATTRIBUTES(hassDoorSensorAttributes), 13 };
+constexpr HassEntity hassRingDetect = { "binary_sensor", "ring", "_ring_detect", "ring detect", mqtt_topic_lock_state, "sound", "", "", "", HASS_ATTRIBUTES(hassRingDetectAttributes), 14 };
+constexpr HassEntity hassLedBrightness = { "number", "led_brightness", "_led_brightness", "LED brightness", mqtt_topic_config_led_brightness, "", "", "config", mqtt_topic_config_led_brightness, HASS_ATTRIBUTES(hassLedBrightnessAttributes), 15 };
+constexpr HassEntity hassSoundLevel = { "sensor", "sound_level", "_sound_level", "Sound level", mqtt_topic_config_sound_level, "", "", "config", mqtt_topic_config_sound_level, HASS_ATTRIBUTES(hassSoundLevelAttributes), 16 };
+constexpr HassEntity hassAccessLog = { "sensor", "last_action_authorization", "_last_action_authorization", "Last action authorization", mqtt_topic_lock_log, "", "", "diagnostic", "", HASS_ATTRIBUTES(hassAccessLogAttributes), 17 };
+constexpr HassEntity hassKeypadAttemptInfo = { "sensor", "keypad_status", "_keypad_stats", "Keypad status", mqtt_topic_lock_log, "", "", "diagnostic", "", HASS_ATTRIBUTES(hassKeypadAttemptAttributes), 18 };
+constexpr HassEntity hassWifiSignalStrength = { "sensor", "wifi_signal_strength", "_wifi_signal_strength", "wifi signal strength", mqtt_topic_wifi_rssi, "signal_strength", "measurement", "diagnostic", "", HASS_ATTRIBUTES(hassSignalStrengthAttributes), 19 };
+constexpr HassEntity hassBleSignalStrength = { "sensor", "bluetooth_signal_strength", "_bluetooth_signal_strength", "bluetooth signal strength", mqtt_topic_lock_rssi, "signal_strength", "measurement", "diagnostic", "", HASS_ATTRIBUTES(hassSignalStrengthAttributes), 20 };
+static_assert(hassBleSignalStrength.hashSlot < HASS_ENTITY_SLOTS, "HASS_ENTITY_SLOTS too small");
+
+// Config topics cleared by Network::removeHASSConfig, { component, object id }
+constexpr const char* hassRemovedConfigs[][2] =
+{
+    { "lock", "smartlock" },
+    { "binary_sensor", "battery_low" },
+    { "sensor", "battery_voltage" },
+    { "sensor", "trigger" },
+    { "sensor", "battery_level" },
+    { "binary_sensor", "door_sensor" },
+    { "binary_sensor", "ring" },
+    { "sensor", "wifi_signal_strength" },
+    { "sensor", "bluetooth_signal_strength" }
+};
@@ -0,0 +1,93 @@
+#include "HtmlResponse.h"
+
+HtmlResponse::HtmlResponse(WebServer& server, const int code, const char* contentType)
+: _server(server)
+{
+    _buffer = new char[HTML_RESPONSE_CHUNK_SIZE];
+    _server.setContentLength(CONTENT_LENGTH_UNKNOWN);
+    _server.send(code, contentType, "");
+}
+
+HtmlResponse::~HtmlResponse()
+{
+    end();
+    delete[] _buffer;
+    _buffer = nullptr;
+}
+
+void HtmlResponse::concat(const char* str)
+{
+    append(str, strlen(str));
+}
+
+void HtmlResponse::concat(const String& str)
+{
+    append(str.c_str(), str.length());
+}
+
+void HtmlResponse::concat(const unsigned char value)
+{
+    concat((unsigned long)value);
+}
+
+void HtmlResponse::concat(const int value)
+{
+    concat((long)value);
+}
+
+void HtmlResponse::concat(const unsigned int value)
+{
+    concat((unsigned long)value);
+}
+
+void HtmlResponse::concat(const long value)
+{
+    char str[12];
+    ltoa(value, str, 10);
+    concat(str);
+}
+
+void HtmlResponse::concat(const unsigned long value)
+{
+    char str[11];
+    ultoa(value, str, 10);
+    concat(str);
+}
+
+void HtmlResponse::end()
+{
+    if(_ended) return;
+
+    flush();
+    // empty chunk terminates a chunked response
+    _server.sendContent("", 0);
+    _ended = true;
+}
+
+void HtmlResponse::append(const char* data, size_t length)
+{
+    if(_ended) return;
+
+    while(length > 0)
+    {
+        size_t free = HTML_RESPONSE_CHUNK_SIZE - _length;
+        size_t count = length < free ? length : free;
+        memcpy(_buffer + _length, data, count);
+        _length += count;
+        data += count;
+        length -= count;
+
+        if(_length == HTML_RESPONSE_CHUNK_SIZE)
+        {
+            flush();
+        }
+    }
+}
+
+void HtmlResponse::flush()
+{
+    if(_length == 0) return;
+
+    _server.sendContent(_buffer, _length);
+    _length = 0;
+}
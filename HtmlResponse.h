@@ -0,0 +1,38 @@
+#pragma once
+
+#include <Arduino.h>
+#include <WebServer.h>
+
+#define HTML_RESPONSE_CHUNK_SIZE 1024
+
+// Streams a page to the client in fixed size chunks instead of building it in one String. The response is sent
+// with unknown content length (chunked transfer encoding for HTTP/1.1 clients), so the heap used for a page is
+// bounded by the chunk size. Headers are sent on construction, end() (or the destructor) finishes the response.
+class HtmlResponse
+{
+public:
+    explicit HtmlResponse(WebServer& server, const int code = 200, const char* contentType = "text/html");
+    ~HtmlResponse();
+
+    HtmlResponse(const HtmlResponse&) = delete;
+    HtmlResponse& operator=(const HtmlResponse&) = delete;
+
+    void concat(const char* str);
+    void concat(const String& str);
+    void concat(const unsigned char value);
+    void concat(const int value);
+    void concat(const unsigned int value);
+    void concat(const long value);
+    void concat(const unsigned long value);
+
+    void end();
+
+private:
+    void append(const char* data, size_t length);
+    void flush();
+
+    WebServer& _server;
+    char* _buffer;
+    size_t _length = 0;
+    bool _ended = false;
+};
@@ -0,0 +1,175 @@
+#include "JsonWriter.h"
+
+JsonWriter::JsonWriter(char* buffer, const size_t size)
+: _buffer(buffer),
+  _size(size)
+{
+    if(_size > 0)
+    {
+        _buffer[0] = 0;
+    }
+    else
+    {
+        _overflow = true;
+    }
+}
+
+void JsonWriter::beginObject(const char* key)
+{
+    writeSeparator();
+    writeKey(key);
+    writeChar('{');
+    _first = true;
+}
+
+void JsonWriter::endObject()
+{
+    writeChar('}');
+    _first = false;
+}
+
+void JsonWriter::beginArray(const char* key)
+{
+    writeSeparator();
+    writeKey(key);
+    writeChar('[');
+    _first = true;
+}
+
+void JsonWriter::endArray()
+{
+    writeChar(']');
+    _first = false;
+}
+
+void JsonWriter::add(const char* key, const char* value)
+{
+    addConcat(key, { value });
+}
+
+void JsonWriter::add(const char* key, const bool value)
+{
+    writeSeparator();
+    writeKey(key);
+    writeRaw(value ? "true" : "false");
+}
+
+void JsonWriter::addInt(const char* key, const long value)
+{
+    char str[12];
+    ltoa(value, str, 10);
+
+    writeSeparator();
+    writeKey(key);
+    writeRaw(str);
+}
+
+void JsonWriter::addConcat(const char* key, std::initializer_list<const char*> values)
+{
+    writeSeparator();
+    writeKey(key);
+    writeChar('"');
+    for(const char* value : values)
+    {
+        writeEscaped(value);
+    }
+    writeChar('"');
+}
+
+void JsonWriter::addValue(const char* value)
+{
+    addConcat(nullptr, { value });
+}
+
+bool JsonWriter::ok() const
+{
+    return !_overflow;
+}
+
+size_t JsonWriter::length() const
+{
+    return _length;
+}
+
+void JsonWriter::writeSeparator()
+{
+    if(!_first)
+    {
+        writeChar(',');
+    }
+    _first = false;
+}
+
+void JsonWriter::writeKey(const char* key)
+{
+    if(key == nullptr)
+    {
+        return;
+    }
+
+    writeChar('"');
+    writeEscaped(key);
+    writeChar('"');
+    writeChar(':');
+}
+
+void JsonWriter::writeEscaped(const char* str)
+{
+    while(*str != 0)
+    {
+        const char c = *str;
+        switch(c)
+        {
+            case '"':
+            case '\\':
+                writeChar('\\');
+                writeChar(c);
+                break;
+            case '\n':
+                writeRaw("\\n");
+                break;
+            case '\r':
+                writeRaw("\\r");
+                break;
+            case '\t':
+                writeRaw("\\t");
+                break;
+            default:
+                if((uint8_t)c < 0x20)
+                {
+                    // \u00XX, without snprintf to keep the stack usage of small tasks (prdet) low
+                    static const char hex[] = "0123456789abcdef";
+                    char escaped[7] = { '\\', 'u', '0', '0', hex[(uint8_t)c >> 4], hex[c & 0x0f], 0 };
+                    writeRaw(escaped);
+                }
+                else
+                {
+                    writeChar(c);
+                }
+                break;
+        }
+        ++str;
+    }
+}
+
+void JsonWriter::writeRaw(const char* str)
+{
+    while(*str != 0)
+    {
+        writeChar(*str);
+        ++str;
+    }
+}
+
+void JsonWriter::writeChar(const char c)
+{
+    if(_length + 1 >= _size)
+    {
+        _overflow = true;
+        return;
+    }
+
+    _buffer[_length] = c;
+    ++_length;
+    _buffer[_length] = 0;
+}
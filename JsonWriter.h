@@ -0,0 +1,39 @@
+#pragma once
+
+#include <Arduino.h>
+#include <initializer_list>
+
+// Streams a JSON document into a caller provided buffer, escaping keys and values in place. No DOM and no heap
+// allocation is involved. The buffer is kept NUL terminated, running out of space is sticky and reported by ok().
+class JsonWriter
+{
+public:
+    JsonWriter(char* buffer, const size_t size);
+
+    void beginObject(const char* key = nullptr);
+    void endObject();
+    void beginArray(const char* key = nullptr);
+    void endArray();
+
+    void add(const char* key, const char* value);
+    void add(const char* key, const bool value);
+    void addInt(const char* key, const long value);
+    void addConcat(const char* key, std::initializer_list<const char*> values);
+    void addValue(const char* value);
+
+    bool ok() const;
+    size_t length() const;
+
+private:
+    void writeSeparator();
+    void writeKey(const char* key);
+    void writeEscaped(const char* str);
+    void writeRaw(const char* str);
+    void writeChar(const char c);
+
+    char* _buffer;
+    const size_t _size;
+    size_t _length = 0;
+    bool _first = true;
+    bool _overflow = false;
+};
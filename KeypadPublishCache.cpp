@@ -0,0 +1,49 @@
+#include "KeypadPublishCache.h"
+#include "Fnv1a.h"
+
+bool KeypadPublishCache::update(const uint index, const NukiLock::KeypadEntry& entry)
+{
+    if(index >= _hashes.size())
+    {
+        // 0 is never remembered, a new slot is always published
+        _hashes.resize(index + 1, 0);
+    }
+
+    uint32_t entryHash = hash(entry);
+    if(entryHash == 0)
+    {
+        entryHash = 1;
+    }
+    if(_hashes[index] == entryHash)
+    {
+        return false;
+    }
+
+    _hashes[index] = entryHash;
+    return true;
+}
+
+uint32_t KeypadPublishCache::revision() const
+{
+    return fnv1aBytes(_hashes.data(), _hashes.size() * sizeof(uint32_t));
+}
+
+void KeypadPublishCache::clear()
+{
+    _hashes.clear();
+}
+
+uint32_t KeypadPublishCache::hash(const NukiLock::KeypadEntry& entry)
+{
+    // Only the published fields are hashed, the struct itself may contain padding
+    uint32_t h = fnv1aBytes(&entry.codeId, sizeof(entry.codeId));
+    h = fnv1aBytes(&entry.enabled, sizeof(entry.enabled), h);
+    h = fnv1aBytes(entry.name, sizeof(entry.name), h);
+    h = fnv1aBytes(&entry.dateCreatedYear, sizeof(entry.dateCreatedYear), h);
+    h = fnv1aBytes(&entry.dateCreatedMonth, sizeof(entry.dateCreatedMonth), h);
+    h = fnv1aBytes(&entry.dateCreatedDay, sizeof(entry.dateCreatedDay), h);
+    h = fnv1aBytes(&entry.dateCreatedHour, sizeof(entry.dateCreatedHour), h);
+    h = fnv1aBytes(&entry.dateCreatedMin, sizeof(entry.dateCreatedMin), h);
+    h = fnv1aBytes(&entry.dateCreatedSec, sizeof(entry.dateCreatedSec), h);
+    return fnv1aBytes(&entry.lockCount, sizeof(entry.lockCount), h);
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <vector>
+#include "NukiLockConstants.h"
+
+// Remembers a hash of every keypad code slot (keypad/code_x) as it was last published, so a keypad refresh
+// only publishes the slots that were added, removed or changed. The revision is a hash over all slot hashes, derived
+// from the content so it stays stable across restarts. It identifies a state, it doesn't increase.
+class KeypadPublishCache
+{
+public:
+    // Returns true if the entry differs from what was last published for this slot, the new state is remembered
+    bool update(const uint index, const NukiLock::KeypadEntry& entry);
+    uint32_t revision() const;
+    void clear();
+
+private:
+    static uint32_t hash(const NukiLock::KeypadEntry& entry);
+
+    std::vector<uint32_t> _hashes;
+};
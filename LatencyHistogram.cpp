@@ -0,0 +1,53 @@
+#include "LatencyHistogram.h"
+
+const uint16_t LatencyHistogram::_bounds[LATENCY_HISTOGRAM_BUCKETS - 1] = { 100, 250, 500, 1000, 2000, 4000, 8000 };
+
+void LatencyHistogram::add(const unsigned long duration)
+{
+    uint8_t bucket = 0;
+    while(bucket < LATENCY_HISTOGRAM_BUCKETS - 1 && duration >= _bounds[bucket])
+    {
+        ++bucket;
+    }
+
+    _buckets[bucket]++;
+    _count++;
+    _sum += duration;
+    if(duration > _max)
+    {
+        _max = duration;
+    }
+}
+
+uint32_t LatencyHistogram::count() const
+{
+    return _count;
+}
+
+unsigned long LatencyHistogram::average() const
+{
+    return _count > 0 ? _sum / _count : 0;
+}
+
+unsigned long LatencyHistogram::max() const
+{
+    return _max;
+}
+
+void LatencyHistogram::getText(String& text) const
+{
+    text.concat(_count);
+    text.concat(" samples, avg ");
+    text.concat(average());
+    text.concat(" ms, max ");
+    text.concat(_max);
+    text.concat(" ms |");
+
+    for(uint8_t i = 0; i < LATENCY_HISTOGRAM_BUCKETS; i++)
+    {
+        text.concat(i < LATENCY_HISTOGRAM_BUCKETS - 1 ? " <" : " >=");
+        text.concat(_bounds[i < LATENCY_HISTOGRAM_BUCKETS - 1 ? i : i - 1]);
+        text.concat(": ");
+        text.concat(_buckets[i]);
+    }
+}
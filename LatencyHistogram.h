@@ -0,0 +1,27 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define LATENCY_HISTOGRAM_BUCKETS 8
+
+// Counts durations in fixed buckets (ms): <100, <250, <500, <1000, <2000, <4000, <8000 and above.
+// Written by one task, other tasks may read it for display.
+class LatencyHistogram
+{
+public:
+    void add(const unsigned long duration); // ms
+
+    uint32_t count() const;
+    unsigned long average() const; // ms
+    unsigned long max() const; // ms
+
+    void getText(String& text) const;
+
+private:
+    static const uint16_t _bounds[LATENCY_HISTOGRAM_BUCKETS - 1];
+
+    uint32_t _buckets[LATENCY_HISTOGRAM_BUCKETS] = {0};
+    uint32_t _count = 0;
+    unsigned long _sum = 0;
+    unsigned long _max = 0;
+};
@@ -5,5 +5,6 @@ enum class LockActionResult
     Success,
     UnknownAction,
     AccessDenied,
-    Failed
+    Failed,
+    QueueFull
 };
\ No newline at end of file
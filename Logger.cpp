@@ -1,3 +1,26 @@
 #include "Logger.h"
+#include <stdarg.h>
 
 Print* Log = nullptr;
+
+void logRecord(const char* format, ...)
+{
+    if(Log == nullptr) return;
+
+    char record[LOG_RECORD_SIZE];
+
+    va_list args;
+    va_start(args, format);
+    int len = vsnprintf(record, sizeof(record) - 2, format, args);
+    va_end(args);
+
+    if(len < 0) return;
+    if(len > (int)sizeof(record) - 3)
+    {
+        len = sizeof(record) - 3;
+    }
+    record[len++] = '\r';
+    record[len++] = '\n';
+
+    Log->write((const uint8_t*)record, len);
+}
@@ -4,4 +4,38 @@
 #include "MqttLogger.h"
 extern Print* Log;
 
-#endif
\ No newline at end of file
+// Leveled logging. Records above NUKI_HUB_LOG_LEVEL (ARDUHAL_LOG_LEVEL_* values, set in CMakeLists.txt) are removed
+// at compile time, arguments included. A record is formatted once and passed to Log in a single write.
+#ifndef NUKI_HUB_LOG_LEVEL
+#define NUKI_HUB_LOG_LEVEL ARDUHAL_LOG_LEVEL_INFO
+#endif
+
+#define LOG_RECORD_SIZE 192
+
+void logRecord(const char* format, ...) __attribute__((format(printf, 1, 2)));
+
+#if NUKI_HUB_LOG_LEVEL >= ARDUHAL_LOG_LEVEL_ERROR
+#define LOG_ERROR(format, ...) logRecord(format, ##__VA_ARGS__)
+#else
+#define LOG_ERROR(format, ...) do {} while(0)
+#endif
+
+#if NUKI_HUB_LOG_LEVEL >= ARDUHAL_LOG_LEVEL_WARN
+#define LOG_WARN(format, ...) logRecord(format, ##__VA_ARGS__)
+#else
+#define LOG_WARN(format, ...) do {} while(0)
+#endif
+
+#if NUKI_HUB_LOG_LEVEL >= ARDUHAL_LOG_LEVEL_INFO
+#define LOG_INFO(format, ...) logRecord(format, ##__VA_ARGS__)
+#else
+#define LOG_INFO(format, ...) do {} while(0)
+#endif
+
+#if NUKI_HUB_LOG_LEVEL >= ARDUHAL_LOG_LEVEL_DEBUG
+#define LOG_DEBUG(format, ...) logRecord(format, ##__VA_ARGS__)
+#else
+#define LOG_DEBUG(format, ...) do {} while(0)
+#endif
+
+#endif
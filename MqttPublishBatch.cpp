@@ -0,0 +1,52 @@
+#include "MqttPublishBatch.h"
+
+void MqttPublishBatch::clear()
+{
+    _count = 0;
+    _valuesLen = 0;
+}
+
+bool MqttPublishBatch::addString(const char* path, const char* value)
+{
+    size_t len = strlen(value) + 1;
+
+    if(path == nullptr || _count >= MQTT_PUBLISH_BATCH_MAX_ENTRIES || _valuesLen + len > MQTT_PUBLISH_BATCH_BUFFER_SIZE)
+    {
+        return false;
+    }
+
+    memcpy(_values + _valuesLen, value, len);
+    _entries[_count].path = path;
+    _entries[_count].valueOffset = _valuesLen;
+    _valuesLen += len;
+    ++_count;
+
+    return true;
+}
+
+bool MqttPublishBatch::addBool(const char* path, const bool value)
+{
+    return addString(path, value ? "1" : "0");
+}
+
+bool MqttPublishBatch::addInt(const char* path, const int value)
+{
+    char str[12];
+    itoa(value, str, 10);
+    return addString(path, str);
+}
+
+size_t MqttPublishBatch::size() const
+{
+    return _count;
+}
+
+const char* MqttPublishBatch::path(const size_t index) const
+{
+    return _entries[index].path;
+}
+
+const char* MqttPublishBatch::value(const size_t index) const
+{
+    return _values + _entries[index].valueOffset;
+}
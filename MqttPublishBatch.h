@@ -0,0 +1,34 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define MQTT_PUBLISH_BATCH_MAX_ENTRIES 16
+#define MQTT_PUBLISH_BATCH_BUFFER_SIZE 768
+
+// Collects the topic updates of one state transition so they can be handed to the MQTT client in a single pass.
+// Paths are expected to point to a MqttTopicTable and aren't copied, values are copied into a fixed buffer.
+class MqttPublishBatch
+{
+public:
+    void clear();
+
+    bool addString(const char* path, const char* value);
+    bool addBool(const char* path, const bool value);
+    bool addInt(const char* path, const int value);
+
+    size_t size() const;
+    const char* path(const size_t index) const;
+    const char* value(const size_t index) const;
+
+private:
+    struct Entry
+    {
+        const char* path;
+        uint16_t valueOffset;
+    };
+
+    Entry _entries[MQTT_PUBLISH_BATCH_MAX_ENTRIES];
+    size_t _count = 0;
+    char _values[MQTT_PUBLISH_BATCH_BUFFER_SIZE];
+    size_t _valuesLen = 0;
+};
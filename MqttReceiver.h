@@ -1,9 +1,10 @@
 #pragma once
 
 #include <Arduino.h>
+#include "MqttTopicTable.h"
 
 class MqttReceiver
 {
 public:
-    virtual void onMqttDataReceived(const char* topic, byte* payload, const unsigned int length) = 0;
-};
\ No newline at end of file
+    virtual void onMqttDataReceived(const MqttTopic& topic, byte* payload, const unsigned int length) = 0;
+};
@@ -0,0 +1,62 @@
+#include "MqttTopicDispatcher.h"
+#include "Logger.h"
+#include "Fnv1a.h"
+
+static_assert((MQTT_DISPATCHER_TABLE_SIZE & (MQTT_DISPATCHER_TABLE_SIZE - 1)) == 0, "MQTT_DISPATCHER_TABLE_SIZE must be a power of two");
+
+bool MqttTopicDispatcher::add(const char* path, MqttReceiver* receiver, const MqttTopic& topic)
+{
+    if(path == nullptr)
+    {
+        return false;
+    }
+
+    uint32_t h = fnv1a(path);
+    size_t index = h & (MQTT_DISPATCHER_TABLE_SIZE - 1);
+
+    while(_entries[index].path != nullptr)
+    {
+        if(_entries[index].hash == h && strcmp(_entries[index].path, path) == 0)
+        {
+            // Every topic has a single receiver, a second registration means two devices share an MQTT path
+            Log->print(F("MQTT topic already registered, ignoring "));
+            Log->println(path);
+            return false;
+        }
+        index = (index + 1) & (MQTT_DISPATCHER_TABLE_SIZE - 1);
+    }
+
+    if(_count >= MQTT_DISPATCHER_MAX_ENTRIES)
+    {
+        Log->print(F("MQTT dispatcher full, dropping topic "));
+        Log->println(path);
+        return false;
+    }
+
+    _entries[index].path = path;
+    _entries[index].hash = h;
+    _entries[index].receiver = receiver;
+    _entries[index].topic = topic;
+    ++_count;
+
+    return true;
+}
+
+bool MqttTopicDispatcher::dispatch(const char* path, byte* payload, const unsigned int length)
+{
+    uint32_t h = fnv1a(path);
+    size_t index = h & (MQTT_DISPATCHER_TABLE_SIZE - 1);
+
+    while(_entries[index].path != nullptr)
+    {
+        const Entry& entry = _entries[index];
+        if(entry.hash == h && strcmp(entry.path, path) == 0)
+        {
+            entry.receiver->onMqttDataReceived(entry.topic, payload, length);
+            return true;
+        }
+        index = (index + 1) & (MQTT_DISPATCHER_TABLE_SIZE - 1);
+    }
+
+    return false;
+}
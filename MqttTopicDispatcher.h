@@ -0,0 +1,30 @@
+#pragma once
+
+#include <Arduino.h>
+#include "MqttReceiver.h"
+
+#define MQTT_DISPATCHER_TABLE_SIZE 64 // must be a power of two
+#define MQTT_DISPATCHER_MAX_ENTRIES (MQTT_DISPATCHER_TABLE_SIZE * 3 / 4)
+
+// Routes an incoming message to the receiver that subscribed the topic. Full topic paths are hashed once on
+// registration into an open addressing table, so an incoming topic costs one hash pass and a single strcmp.
+// Paths are expected to point to a MqttTopicTable and aren't copied.
+class MqttTopicDispatcher
+{
+public:
+    // False if the path is already registered (the first receiver is kept) or the table is full
+    bool add(const char* path, MqttReceiver* receiver, const MqttTopic& topic);
+    bool dispatch(const char* path, byte* payload, const unsigned int length);
+
+private:
+    struct Entry
+    {
+        const char* path = nullptr;
+        uint32_t hash = 0;
+        MqttReceiver* receiver = nullptr;
+        MqttTopic topic = MqttTopic::Count;
+    };
+
+    Entry _entries[MQTT_DISPATCHER_TABLE_SIZE];
+    size_t _count = 0;
+};
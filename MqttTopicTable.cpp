@@ -0,0 +1,72 @@
+#include "MqttTopicTable.h"
+
+static const char* const mqttTopicSubPaths[] =
+{
+#define MQTT_TOPIC_PATH(id, path) path,
+    MQTT_TOPICS(MQTT_TOPIC_PATH)
+#undef MQTT_TOPIC_PATH
+};
+
+static_assert(sizeof(mqttTopicSubPaths) / sizeof(mqttTopicSubPaths[0]) == (size_t)MqttTopic::Count, "Topic path table out of sync with MqttTopic");
+
+MqttTopicTable::MqttTopicTable()
+{
+    memset(_offsets, 0xff, sizeof(_offsets));
+}
+
+MqttTopicTable::~MqttTopicTable()
+{
+    delete[] _arena;
+    _arena = nullptr;
+}
+
+void MqttTopicTable::initialize(const char* prefix, std::initializer_list<MqttTopic> topics)
+{
+    delete[] _arena;
+    memset(_offsets, 0xff, sizeof(_offsets));
+
+    size_t prefixLen = strlen(prefix);
+
+    _arenaSize = 0;
+    for(const auto& topic : topics)
+    {
+        _arenaSize += prefixLen + strlen(subPath(topic)) + 1;
+    }
+
+    _arena = new char[_arenaSize];
+
+    size_t offset = 0;
+    for(const auto& topic : topics)
+    {
+        if(_offsets[(size_t)topic] != NoOffset)
+        {
+            continue;
+        }
+
+        _offsets[(size_t)topic] = offset;
+
+        memcpy(_arena + offset, prefix, prefixLen);
+        offset += prefixLen;
+
+        const char* path = subPath(topic);
+        size_t pathLen = strlen(path);
+        memcpy(_arena + offset, path, pathLen + 1);
+        offset += pathLen + 1;
+    }
+}
+
+const char* MqttTopicTable::get(const MqttTopic& topic) const
+{
+    uint16_t offset = _offsets[(size_t)topic];
+    return offset == NoOffset ? nullptr : _arena + offset;
+}
+
+bool MqttTopicTable::contains(const MqttTopic& topic) const
+{
+    return _offsets[(size_t)topic] != NoOffset;
+}
+
+const char* MqttTopicTable::subPath(const MqttTopic& topic)
+{
+    return mqttTopicSubPaths[(size_t)topic];
+}
@@ -0,0 +1,35 @@
+#pragma once
+
+#include <Arduino.h>
+#include <initializer_list>
+#include "MqttTopics.h"
+
+enum class MqttTopic : uint8_t
+{
+#define MQTT_TOPIC_ID(id, path) id,
+    MQTT_TOPICS(MQTT_TOPIC_ID)
+#undef MQTT_TOPIC_ID
+    Count
+};
+
+// Full topic paths (prefix + subtopic) built once into a single arena, looked up by MqttTopic id
+class MqttTopicTable
+{
+public:
+    MqttTopicTable();
+    virtual ~MqttTopicTable();
+
+    void initialize(const char* prefix, std::initializer_list<MqttTopic> topics);
+
+    const char* get(const MqttTopic& topic) const; // nullptr if the topic isn't part of the table
+    bool contains(const MqttTopic& topic) const;
+
+    static const char* subPath(const MqttTopic& topic);
+
+private:
+    static const uint16_t NoOffset = 0xffff;
+
+    char* _arena = nullptr;
+    size_t _arenaSize = 0;
+    uint16_t _offsets[(size_t)MqttTopic::Count];
+};
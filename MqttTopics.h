@@ -23,11 +23,14 @@
 #define mqtt_topic_lock_auth_name "/lock/authorizationName"
 #define mqtt_topic_lock_completionStatus "/lock/completionStatus"
 #define mqtt_topic_lock_action_command_result "/lock/commandResult"
+#define mqtt_topic_lock_command_id "/lock/commandId"
+#define mqtt_topic_lock_command_result_json "/lock/commandResultJson"
 #define mqtt_topic_lock_door_sensor_state "/lock/doorSensorState"
 #define mqtt_topic_lock_action "/lock/action"
 #define mqtt_topic_lock_rssi "/lock/rssi"
 #define mqtt_topic_lock_address "/lock/address"
 #define mqtt_topic_lock_retry "/lock/retry"
+#define mqtt_topic_lock_json "/lock/json"
 
 #define mqtt_topic_config_button_enabled "/configuration/buttonEnabled"
 #define mqtt_topic_config_led_enabled "/configuration/ledEnabled"
@@ -49,14 +52,20 @@
 #define mqtt_topic_keypad_command_code "/keypad/command/code"
 #define mqtt_topic_keypad_command_enabled "/keypad/command/enabled"
 #define mqtt_topic_keypad_command_result "/keypad/command/commandResult"
+#define mqtt_topic_keypad_json_command "/keypad/commandJson"
+#define mqtt_topic_keypad_revision "/keypad/revision"
+#define mqtt_topic_keypad_json_command_result "/keypad/commandResultJson"
 
 #define mqtt_topic_presence "/presence/devices"
+#define mqtt_topic_presence_events "/presence/events"
 
 #define mqtt_topic_reset "/maintenance/reset"
 #define mqtt_topic_uptime "/maintenance/uptime"
 #define mqtt_topic_wifi_rssi "/maintenance/wifiRssi"
 #define mqtt_topic_log "/maintenance/log"
 #define mqtt_topic_freeheap "/maintenance/freeHeap"
+#define mqtt_topic_scratch_buffer_peak "/maintenance/scratchBufferPeak"
+#define mqtt_topic_scratch_buffer_contention "/maintenance/scratchBufferContention"
 #define mqtt_topic_restart_reason_fw "/maintenance/restartReasonNukiHub"
 #define mqtt_topic_restart_reason_esp "/maintenance/restartReasonNukiEsp"
 #define mqtt_topic_mqtt_connection_state "/maintenance/mqttConnectionState"
@@ -66,3 +75,74 @@
 #define mqtt_topic_gpio_pin "/pin_"
 #define mqtt_topic_gpio_role "/role"
 #define mqtt_topic_gpio_state "/state"
+
+// One entry per definition above, used to generate the MqttTopic ids for MqttTopicTable
+#define MQTT_TOPICS(X) \
+    X(BatteryLevel, mqtt_topic_battery_level) \
+    X(BatteryCritical, mqtt_topic_battery_critical) \
+    X(BatteryCharging, mqtt_topic_battery_charging) \
+    X(BatteryVoltage, mqtt_topic_battery_voltage) \
+    X(BatteryDrain, mqtt_topic_battery_drain) \
+    X(BatteryMaxTurnCurrent, mqtt_topic_battery_max_turn_current) \
+    X(BatteryLockDistance, mqtt_topic_battery_lock_distance) \
+    X(BatteryKeypadCritical, mqtt_topic_battery_keypad_critical) \
+    X(LockState, mqtt_topic_lock_state) \
+    X(QueryConfig, mqtt_topic_query_config) \
+    X(QueryLockstate, mqtt_topic_query_lockstate) \
+    X(QueryKeypad, mqtt_topic_query_keypad) \
+    X(QueryBattery, mqtt_topic_query_battery) \
+    X(QueryLockstateCommandResult, mqtt_topic_query_lockstate_command_result) \
+    X(LockBinaryState, mqtt_topic_lock_binary_state) \
+    X(LockTrigger, mqtt_topic_lock_trigger) \
+    X(LockLastLockAction, mqtt_topic_lock_last_lock_action) \
+    X(LockLog, mqtt_topic_lock_log) \
+    X(LockAuthId, mqtt_topic_lock_auth_id) \
+    X(LockAuthName, mqtt_topic_lock_auth_name) \
+    X(LockCompletionStatus, mqtt_topic_lock_completionStatus) \
+    X(LockActionCommandResult, mqtt_topic_lock_action_command_result) \
+    X(LockCommandId, mqtt_topic_lock_command_id) \
+    X(LockCommandResultJson, mqtt_topic_lock_command_result_json) \
+    X(LockDoorSensorState, mqtt_topic_lock_door_sensor_state) \
+    X(LockAction, mqtt_topic_lock_action) \
+    X(LockRssi, mqtt_topic_lock_rssi) \
+    X(LockAddress, mqtt_topic_lock_address) \
+    X(LockRetry, mqtt_topic_lock_retry) \
+    X(LockJson, mqtt_topic_lock_json) \
+    X(ConfigButtonEnabled, mqtt_topic_config_button_enabled) \
+    X(ConfigLedEnabled, mqtt_topic_config_led_enabled) \
+    X(ConfigLedBrightness, mqtt_topic_config_led_brightness) \
+    X(ConfigAutoUnlock, mqtt_topic_config_auto_unlock) \
+    X(ConfigAutoLock, mqtt_topic_config_auto_lock) \
+    X(ConfigSingleLock, mqtt_topic_config_single_lock) \
+    X(ConfigSoundLevel, mqtt_topic_config_sound_level) \
+    X(ConfigLastActionAuthorization, mqtt_topic_config_last_action_authorization) \
+    X(InfoHardwareVersion, mqtt_topic_info_hardware_version) \
+    X(InfoFirmwareVersion, mqtt_topic_info_firmware_version) \
+    X(InfoNukiHubVersion, mqtt_topic_info_nuki_hub_version) \
+    X(Keypad, mqtt_topic_keypad) \
+    X(KeypadCommandAction, mqtt_topic_keypad_command_action) \
+    X(KeypadCommandId, mqtt_topic_keypad_command_id) \
+    X(KeypadCommandName, mqtt_topic_keypad_command_name) \
+    X(KeypadCommandCode, mqtt_topic_keypad_command_code) \
+    X(KeypadCommandEnabled, mqtt_topic_keypad_command_enabled) \
+    X(KeypadCommandResult, mqtt_topic_keypad_command_result) \
+    X(KeypadJsonCommand, mqtt_topic_keypad_json_command) \
+    X(KeypadRevision, mqtt_topic_keypad_revision) \
+    X(KeypadJsonCommandResult, mqtt_topic_keypad_json_command_result) \
+    X(Presence, mqtt_topic_presence) \
+    X(PresenceEvents, mqtt_topic_presence_events) \
+    X(Reset, mqtt_topic_reset) \
+    X(Uptime, mqtt_topic_uptime) \
+    X(WifiRssi, mqtt_topic_wifi_rssi) \
+    X(Log, mqtt_topic_log) \
+    X(Freeheap, mqtt_topic_freeheap) \
+    X(ScratchBufferPeak, mqtt_topic_scratch_buffer_peak) \
+    X(ScratchBufferContention, mqtt_topic_scratch_buffer_contention) \
+    X(RestartReasonFw, mqtt_topic_restart_reason_fw) \
+    X(RestartReasonEsp, mqtt_topic_restart_reason_esp) \
+    X(MqttConnectionState, mqtt_topic_mqtt_connection_state) \
+    X(NetworkDevice, mqtt_topic_network_device) \
+    X(GpioPrefix, mqtt_topic_gpio_prefix) \
+    X(GpioPin, mqtt_topic_gpio_pin) \
+    X(GpioRole, mqtt_topic_gpio_role) \
+    X(GpioState, mqtt_topic_gpio_state)
@@ -4,8 +4,9 @@
 #include "networkDevices/WifiDevice.h"
 #include "Logger.h"
 #include "Config.h"
-#include <ArduinoJson.h>
 #include "RestartReason.h"
+#include "Fnv1a.h"
+#include "ScratchBuffer.h"
 #include "networkDevices/EthLan8720Device.h"
 
 Network* Network::_inst = nullptr;
@@ -14,11 +15,12 @@ bool _versionPublished = false;
 
 RTC_NOINIT_ATTR char WiFi_fallbackDetect[14];
 
-Network::Network(Preferences *preferences, Gpio* gpio, const String& maintenancePathPrefix, char* buffer, size_t bufferSize)
+Network::Network(Preferences *preferences, Gpio* gpio, StatusSnapshot* statusSnapshot, const String& maintenancePathPrefix)
 : _preferences(preferences),
   _gpio(gpio),
-  _buffer(buffer),
-  _bufferSize(bufferSize)
+  _statusSnapshot(statusSnapshot),
+  _presenceCsv(nullptr),
+  _presenceEvents(nullptr)
 {
     // Remove obsolete W5500 hardware detection configuration
     if(_preferences->getInt(preference_network_hardware_gpio) != 0)
@@ -36,7 +38,13 @@ Network::Network(Preferences *preferences, Gpio* gpio, const String& maintenance
         _maintenancePathPrefix[i] = maintenancePathPrefix.charAt(i);
     }
 
+    _maintenanceTopics.initialize(_maintenancePathPrefix, {
+        MqttTopic::WifiRssi, MqttTopic::Uptime, MqttTopic::Freeheap, MqttTopic::ScratchBufferPeak, MqttTopic::ScratchBufferContention, MqttTopic::RestartReasonFw,
+        MqttTopic::RestartReasonEsp, MqttTopic::InfoNukiHubVersion, MqttTopic::NetworkDevice, MqttTopic::MqttConnectionState
+    });
+
     _lockPath = _preferences->getString(preference_mqtt_lock_path);
+    buildMqttPath(_gpioPinPathPrefix, {_lockPath.c_str(), mqtt_topic_gpio_prefix, mqtt_topic_gpio_pin});
     String connectionStateTopic = _lockPath + mqtt_topic_mqtt_connection_state;
 
     memset(_mqttConnectionStateTopic, 0, sizeof(_mqttConnectionStateTopic));
@@ -47,6 +55,9 @@ Network::Network(Preferences *preferences, Gpio* gpio, const String& maintenance
     }
 
     setupDevice();
+
+    memset(&_status, 0, sizeof(NetworkStatus));
+    strlcpy(_status.device, _device->deviceName().c_str(), sizeof(_status.device));
 }
 
 void Network::setupDevice()
@@ -161,6 +172,10 @@ void Network::initialize()
         _preferences->putInt(preference_rssi_publish_interval, _rssiPublishInterval);
     }
     strcpy(_hostnameArr, _hostname.c_str());
+
+    String discoveryTopic = _preferences->getString(preference_mqtt_hass_discovery);
+    strncpy(_discoveryTopic, discoveryTopic.c_str(), sizeof(_discoveryTopic) - 1);
+
     _device->initialize();
 
     Log->print(F("Host name: "));
@@ -257,8 +272,18 @@ bool Network::update()
 {
     unsigned long ts = millis();
 
+    uint8_t requests = _requests.exchange(0);
+    if(requests != 0)
+    {
+        processRequests(requests);
+    }
+
     _device->update();
 
+    _status.networkConnected = _device->isConnected();
+    _status.mqttConnected = _device->mqttConnected();
+    _statusSnapshot->updateNetwork(_status);
+
     if(!_mqttEnabled)
     {
         return true;
@@ -311,15 +336,26 @@ bool Network::update()
 
     _lastConnectedTs = ts;
 
-    if(_presenceCsv != nullptr && strlen(_presenceCsv) > 0)
+    char* presenceEvents = _presenceEvents.load(std::memory_order_acquire);
+    if(presenceEvents != nullptr)
     {
-        bool success = publishString(_mqttPresencePrefix, mqtt_topic_presence, _presenceCsv);
-        if(!success)
+        // Events aren't retained, a subscriber connecting later gets the current state from the snapshot
+        if(_device->mqttPublish(_presenceTopics.get(MqttTopic::PresenceEvents), MQTT_QOS_LEVEL, false, presenceEvents) == 0)
+        {
+            Log->println(F("Failed to publish presence events."));
+        }
+        _presenceEvents.store(nullptr, std::memory_order_release);
+    }
+
+    char* presenceCsv = _presenceCsv.load(std::memory_order_acquire);
+    if(presenceCsv != nullptr)
+    {
+        if(strlen(presenceCsv) > 0 && !publishString(_presenceTopics.get(MqttTopic::Presence), presenceCsv))
         {
             Log->println(F("Failed to publish presence CSV data."));
-            Log->println(_presenceCsv);
+            Log->println(presenceCsv);
         }
-        _presenceCsv = nullptr;
+        _presenceCsv.store(nullptr, std::memory_order_release);
     }
 
     if(_device->signalStrength() != 127 && _rssiPublishInterval > 0 && ts - _lastRssiTs > _rssiPublishInterval)
@@ -329,22 +365,24 @@ bool Network::update()
 
         if(rssi != _lastRssi)
         {
-            publishInt(_maintenancePathPrefix, mqtt_topic_wifi_rssi, _device->signalStrength());
+            publishInt(_maintenanceTopics.get(MqttTopic::WifiRssi), _device->signalStrength());
             _lastRssi = rssi;
         }
     }
 
     if(_lastMaintenanceTs == 0 || (ts - _lastMaintenanceTs) > 30000)
     {
-        publishULong(_maintenancePathPrefix, mqtt_topic_uptime, ts / 1000 / 60);
+        publishULong(_maintenanceTopics.get(MqttTopic::Uptime), ts / 1000 / 60);
         if(_publishDebugInfo)
         {
-            publishUInt(_maintenancePathPrefix, mqtt_topic_freeheap, esp_get_free_heap_size());
-            publishString(_maintenancePathPrefix, mqtt_topic_restart_reason_fw, getRestartReason().c_str());
-            publishString(_maintenancePathPrefix, mqtt_topic_restart_reason_esp, getEspRestartReason().c_str());
+            publishUInt(_maintenanceTopics.get(MqttTopic::Freeheap), esp_get_free_heap_size());
+            publishUInt(_maintenanceTopics.get(MqttTopic::ScratchBufferPeak), ScratchBufferPool::peakUsage());
+            publishUInt(_maintenanceTopics.get(MqttTopic::ScratchBufferContention), ScratchBufferPool::contentionCount());
+            publishString(_maintenanceTopics.get(MqttTopic::RestartReasonFw), getRestartReason().c_str());
+            publishString(_maintenanceTopics.get(MqttTopic::RestartReasonEsp), getEspRestartReason().c_str());
         }
         if (!_versionPublished) {
-            publishString(_maintenancePathPrefix, mqtt_topic_info_nuki_hub_version, NUKI_HUB_VERSION);
+            publishString(_maintenanceTopics.get(MqttTopic::InfoNukiHubVersion), NUKI_HUB_VERSION);
             _versionPublished = true;
         }
         _lastMaintenanceTs = ts;
@@ -376,6 +414,7 @@ bool Network::update()
 
 void Network::onMqttConnect(const bool &sessionPresent)
 {
+    _mqttSessionPresent = sessionPresent;
     _connectReplyReceived = true;
 }
 
@@ -425,22 +464,22 @@ bool Network::reconnect()
     {
         if(strcmp(_mqttBrokerAddr, "") == 0)
         {
-            Log->println(F("MQTT Broker not configured, aborting connection attempt."));
+            LOG_WARN("MQTT Broker not configured, aborting connection attempt.");
             _nextReconnect = millis() + 5000;
             return false;
         }
 
-        Log->println(F("Attempting MQTT connection"));
+        LOG_INFO("Attempting MQTT connection");
 
         _connectReplyReceived = false;
 
         if(strlen(_mqttUser) == 0)
         {
-            Log->println(F("MQTT: Connecting without credentials"));
+            LOG_INFO("MQTT: Connecting without credentials");
         }
         else
         {
-            Log->print(F("MQTT: Connecting with user: ")); Log->println(_mqttUser);
+            LOG_INFO("MQTT: Connecting with user: %s", _mqttUser);
             _device->mqttSetCredentials(_mqttUser, _mqttPass);
         }
 
@@ -462,27 +501,27 @@ bool Network::reconnect()
 
         if (_device->mqttConnected())
         {
-            Log->println(F("MQTT connected"));
+            LOG_INFO("MQTT connected");
             _mqttConnectionState = 1;
             delay(100);
 
             _ignoreSubscriptionsTs = millis() + 2000;
             _device->mqttOnMessage(Network::onMqttDataReceivedCallback);
-            for(const String& topic : _subscribedTopics)
+            for(const char* topic : _subscribedTopics)
             {
-                _device->mqttSubscribe(topic.c_str(), MQTT_QOS_LEVEL);
+                _device->mqttSubscribe(topic, MQTT_QOS_LEVEL);
             }
             if(_firstConnect)
             {
                 _firstConnect = false;
-                publishString(_maintenancePathPrefix, mqtt_topic_network_device, _device->deviceName().c_str());
+                publishString(_maintenanceTopics.get(MqttTopic::NetworkDevice), _device->deviceName().c_str());
                 for(const auto& it : _initTopics)
                 {
-                    _device->mqttPublish(it.first.c_str(), MQTT_QOS_LEVEL, true, it.second.c_str());
+                    _device->mqttPublish(it.first, MQTT_QOS_LEVEL, true, it.second);
                 }
             }
 
-            publishString(_maintenancePathPrefix, mqtt_topic_mqtt_connection_state, "online");
+            publishString(_maintenanceTopics.get(MqttTopic::MqttConnectionState), "online");
 
             _mqttConnectionState = 2;
             for(const auto& callback : _reconnectedCallbacks)
@@ -502,20 +541,33 @@ bool Network::reconnect()
     return _mqttConnectionState > 0;
 }
 
-void Network::subscribe(const char* prefix, const char *path)
+void Network::subscribe(const char *path)
 {
-    char prefixedPath[500];
-    buildMqttPath(prefixedPath, { prefix, path });
-    _subscribedTopics.push_back(prefixedPath);
+    _subscribedTopics.push_back(path);
 }
 
-void Network::initTopic(const char *prefix, const char *path, const char *value)
+void Network::subscribe(MqttReceiver* receiver, const MqttTopicTable& topics, const MqttTopic& topic)
+{
+    const char* path = topics.get(topic);
+    if(_dispatcher.add(path, receiver, topic))
+    {
+        subscribe(path);
+    }
+}
+
+void Network::initTopic(const char *path, const char *value)
+{
+    _initTopics.push_back(std::make_pair(path, value));
+}
+
+void Network::subscribe(const char* prefix, const char *path)
 {
     char prefixedPath[500];
     buildMqttPath(prefixedPath, { prefix, path });
-    String pathStr = prefixedPath;
-    String valueStr = value;
-    _initTopics[pathStr] = valueStr;
+
+    char* topic = new char[strlen(prefixedPath) + 1];
+    strcpy(topic, prefixedPath);
+    _subscribedTopics.push_back(topic);
 }
 
 void Network::buildMqttPath(char* outPath, std::initializer_list<const char*> paths)
@@ -544,47 +596,44 @@ void Network::buildMqttPath(char* outPath, std::initializer_list<const char*> pa
     outPath[offset] = 0x00;
 }
 
-void Network::registerMqttReceiver(MqttReceiver* receiver)
+void Network::onMqttDataReceivedCallback(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len, size_t index, size_t total)
 {
-    _mqttReceivers.push_back(receiver);
+    _inst->onMqttDataReceived(topic, payload, len, index, total);
 }
 
-void Network::onMqttDataReceivedCallback(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len, size_t index, size_t total)
+void Network::onMqttDataReceived(const char* topic, const uint8_t* payload, const size_t& len, const size_t& index, const size_t& total)
 {
-    uint8_t value[50] = {0};
-    size_t l = min(len, sizeof(value)-1);
-
-    for(int i=0; i<l; i++)
+    if(total > MQTT_INBOUND_PAYLOAD_SIZE)
     {
-        value[i] = payload[i];
+        if(index == 0)
+        {
+            Log->print(F("MQTT payload exceeds the inbound buffer, dropping message on "));
+            Log->println(topic);
+        }
+        return;
     }
 
-    _inst->onMqttDataReceived(properties, topic, value, len, index, total);
-}
-
-void Network::onMqttDataReceived(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t& len, size_t& index, size_t& total)
-{
-    parseGpioTopics(properties, topic, payload, len, index, total);
-
-    if(millis() < _ignoreSubscriptionsTs)
+    // The parser's RX buffer isn't NUL terminated, so fragments are always assembled into the inbound buffer
+    memcpy(_inboundPayload + index, payload, len);
+    if(index + len < total)
     {
         return;
     }
+    _inboundPayload[total] = 0;
 
-    for(auto receiver : _mqttReceivers)
+    if(millis() >= _ignoreSubscriptionsTs && _dispatcher.dispatch(topic, (byte*)_inboundPayload, total))
     {
-        receiver->onMqttDataReceived(topic, (byte*)payload, index);
+        return;
     }
-}
 
+    parseGpioTopics(topic, _inboundPayload);
+}
 
-void Network::parseGpioTopics(const espMqttClientTypes::MessageProperties &properties, const char *topic, const uint8_t *payload, size_t& len, size_t& index, size_t& total)
+void Network::parseGpioTopics(const char *topic, const char *payload)
 {
-    char gpioPath[250];
-    buildMqttPath(gpioPath, {_lockPath.c_str(), mqtt_topic_gpio_prefix, mqtt_topic_gpio_pin});
 //    /nuki_t/gpio/pin_17/state
-    size_t gpioLen = strlen(gpioPath);
-    if(strncmp(gpioPath, topic, gpioLen) == 0)
+    size_t gpioLen = strlen(_gpioPinPathPrefix);
+    if(strncmp(_gpioPinPathPrefix, topic, gpioLen) == 0)
     {
         char pinStr[3] = {0};
         pinStr[0] = topic[gpioLen];
@@ -597,7 +646,7 @@ void Network::parseGpioTopics(const espMqttClientTypes::MessageProperties &prope
 
         if(_gpio->getPinRole(pin) == PinRole::GeneralOutput)
         {
-            const uint8_t pinState = strcmp((const char*)payload, "1") == 0 ? HIGH : LOW;
+            const uint8_t pinState = strcmp(payload, "1") == 0 ? HIGH : LOW;
             Log->print(F("GPIO "));
             Log->print(pin);
             Log->print(F(" (Output) --> "));
@@ -615,19 +664,17 @@ void Network::gpioActionCallback(const GpioAction &action, const int &pin)
 
 void Network::reconfigureDevice()
 {
-    _device->reconfigure();
+    _requests.fetch_or(NETWORK_REQUEST_RECONFIGURE_DEVICE);
 }
 
 void Network::setMqttPresencePath(char *path)
 {
-    memset(_mqttPresencePrefix, 0, sizeof(_mqttPresencePrefix));
-    strcpy(_mqttPresencePrefix, path);
+    _presenceTopics.initialize(path, { MqttTopic::Presence, MqttTopic::PresenceEvents });
 }
 
 void Network::disableAutoRestarts()
 {
-    _networkTimeout = 0;
-    _restartOnDisconnect = false;
+    _requests.fetch_or(NETWORK_REQUEST_DISABLE_AUTO_RESTARTS);
 }
 
 int Network::mqttConnectionState()
@@ -635,6 +682,11 @@ int Network::mqttConnectionState()
     return _mqttConnectionState;
 }
 
+bool Network::mqttSessionPresent() const
+{
+    return _mqttSessionPresent;
+}
+
 bool Network::encryptionSupported()
 {
     return _device->supportsEncryption();
@@ -647,674 +699,261 @@ const String Network::networkDeviceName() const
 
 void Network::publishFloat(const char* prefix, const char* topic, const float value, const uint8_t precision)
 {
-    char str[30];
-    dtostrf(value, 0, precision, str);
     char path[200] = {0};
     buildMqttPath(path, { prefix, topic });
-    _device->mqttPublish(path, MQTT_QOS_LEVEL, true, str);
+    publishFloat(path, value, precision);
 }
 
 void Network::publishInt(const char* prefix, const char *topic, const int value)
 {
-    char str[30];
-    itoa(value, str, 10);
     char path[200] = {0};
     buildMqttPath(path, { prefix, topic });
-    _device->mqttPublish(path, MQTT_QOS_LEVEL, true, str);
+    publishInt(path, value);
 }
 
 void Network::publishUInt(const char* prefix, const char *topic, const unsigned int value)
 {
-    char str[30];
-    utoa(value, str, 10);
     char path[200] = {0};
     buildMqttPath(path, { prefix, topic });
-    _device->mqttPublish(path, MQTT_QOS_LEVEL, true, str);
+    publishUInt(path, value);
 }
 
 void Network::publishULong(const char* prefix, const char *topic, const unsigned long value)
 {
-    char str[30];
-    utoa(value, str, 10);
     char path[200] = {0};
     buildMqttPath(path, { prefix, topic });
-    _device->mqttPublish(path, MQTT_QOS_LEVEL, true, str);
+    publishULong(path, value);
 }
 
 void Network::publishBool(const char* prefix, const char *topic, const bool value)
 {
-    char str[2] = {0};
-    str[0] = value ? '1' : '0';
     char path[200] = {0};
     buildMqttPath(path, { prefix, topic });
-    _device->mqttPublish(path, MQTT_QOS_LEVEL, true, str);
+    publishBool(path, value);
 }
 
 bool Network::publishString(const char* prefix, const char *topic, const char *value)
 {
     char path[200] = {0};
     buildMqttPath(path, { prefix, topic });
-    return _device->mqttPublish(path, MQTT_QOS_LEVEL, true, value) > 0;
+    return publishString(path, value);
 }
 
-void Network::publishHASSConfig(char* deviceType, const char* baseTopic, char* name, char* uidString, const bool& hasKeypad, char* lockAction, char* unlockAction, char* openAction, char* lockedState, char* unlockedState)
+void Network::publishFloat(const char* path, const float value, const uint8_t precision)
 {
-    String discoveryTopic = _preferences->getString(preference_mqtt_hass_discovery);
-
-    if (discoveryTopic != "")
-    {
-        DynamicJsonDocument json(JSON_BUFFER_SIZE);
-
-        auto dev = json.createNestedObject("dev");
-        auto ids = dev.createNestedArray("ids");
-        ids.add(String("nuki_") + uidString);
-        json["dev"]["mf"] = "Nuki";
-        json["dev"]["mdl"] = deviceType;
-        json["dev"]["name"] = name;
-        json["~"] = baseTopic;
-        json["name"] = name;
-        json["unique_id"] = String(uidString) + "_lock";
-        json["cmd_t"] = String("~") + String(mqtt_topic_lock_action);
-        json["pl_lock"] = lockAction;
-        json["pl_unlk"] = unlockAction;
-        json["pl_open"] = openAction;
-        json["stat_t"] = String("~") + mqtt_topic_lock_binary_state;
-        json["stat_locked"] = lockedState;
-        json["stat_unlocked"] = unlockedState;
-        json["opt"] = "false";
-
-        serializeJson(json, _buffer, _bufferSize);
-
-        String path = discoveryTopic;
-        path.concat("/lock/");
-        path.concat(uidString);
-        path.concat("/smartlock/config");
-
-        _device->mqttPublish(path.c_str(), MQTT_QOS_LEVEL, true, _buffer);
-
-        // Battery critical
-        publishHassTopic("binary_sensor",
-                         "battery_low",
-                         uidString,
-                         "_battery_low",
-                         "battery low",
-                         name,
-                         baseTopic,
-                         mqtt_topic_battery_critical,
-                         deviceType,
-                         "battery",
-                         "",
-                         "diagnostic",
-                         "",
-                         {{"pl_on", "1"},
-                          {"pl_off", "0"}});
-
-        if(hasKeypad)
-        {
-            // Keypad battery critical
-            publishHassTopic("binary_sensor",
-                             "keypad_battery_low",
-                             uidString,
-                             "_keypad_battery_low",
-                             "keypad battery low",
-                             name,
-                             baseTopic,
-                             mqtt_topic_battery_keypad_critical,
-                             deviceType,
-                             "battery",
-                             "",
-                             "diagnostic",
-                             "",
-                             {{"pl_on", "1"},
-                              {"pl_off", "0"}});
-        }
-        else
-        {
-            removeHassTopic("binary_sensor", "keypad_battery_low", uidString);
-        }
+    char str[30];
+    dtostrf(value, 0, precision, str);
+    _device->mqttPublish(path, MQTT_QOS_LEVEL, true, str);
+}
 
-        // Battery voltage
-        publishHassTopic("sensor",
-                         "battery_voltage",
-                         uidString,
-                         "_battery_voltage",
-                         "battery voltage",
-                         name,
-                         baseTopic,
-                         mqtt_topic_battery_voltage,
-                         deviceType,
-                         "voltage",
-                         "measurement",
-                         "diagnostic",
-                         "",
-                         { {"unit_of_meas", "V"} });
-
-        // Trigger
-        publishHassTopic("sensor",
-                         "trigger",
-                         uidString,
-                         "_trigger",
-                         "trigger",
-                         name,
-                         baseTopic,
-                         mqtt_topic_lock_trigger,
-                         deviceType,
-                         "",
-                         "",
-                         "diagnostic",
-                         "",
-                         { { "enabled_by_default", "true" } });
-
-        // MQTT Connected
-        publishHassTopic("binary_sensor",
-                         "mqtt_connected",
-                         uidString,
-                         "_mqtt_connected",
-                         "MQTT connected",
-                         name,
-                         baseTopic,
-                         mqtt_topic_mqtt_connection_state,
-                         deviceType,
-                         "",
-                         "",
-                         "diagnostic",
-                         "",
-                         {{"pl_on", "online"},
-                          {"pl_off", "offline"},
-                          {"ic", "mdi:lan-connect"}});
-
-        // Reset
-        publishHassTopic("switch",
-                         "reset",
-                         uidString,
-                         "_reset",
-                         "Restart NUKI Hub",
-                         name,
-                         baseTopic,
-                         mqtt_topic_reset,
-                         deviceType,
-                         "",
-                         "",
-                         "diagnostic",
-                         mqtt_topic_reset,
-                         { { "ic", "mdi:restart" },
-                           { "pl_on", "1" },
-                           { "pl_off", "0" },
-                           { "state_on", "1" },
-                           { "state_off", "0" }});
-
-        // Firmware version
-        publishHassTopic("sensor",
-                         "firmware_version",
-                         uidString,
-                         "_firmware_version",
-                         "Firmware version",
-                         name,
-                         baseTopic,
-                         mqtt_topic_info_firmware_version,
-                         deviceType,
-                         "",
-                         "",
-                         "diagnostic",
-                         "",
-                         { { "enabled_by_default", "true" },
-                           {"ic", "mdi:counter"}});
-
-        // Hardware version
-        publishHassTopic("sensor",
-                         "hardware_version",
-                         uidString,
-                         "_hardware_version",
-                         "Hardware version",
-                         name,
-                         baseTopic,
-                         mqtt_topic_info_hardware_version,
-                         deviceType,
-                         "",
-                         "",
-                         "diagnostic",
-                         "",
-                         { { "enabled_by_default", "true" },
-                           {"ic", "mdi:counter"}});
-
-        // NUKI Hub version
-        publishHassTopic("sensor",
-                         "nuki_hub_version",
-                         uidString,
-                         "_nuki_hub__version",
-                         "NUKI Hub version",
-                         name,
-                         baseTopic,
-                         mqtt_topic_info_nuki_hub_version,
-                         deviceType,
-                         "",
-                         "",
-                         "diagnostic",
-                         "",
-                         { { "enabled_by_default", "true" },
-                           {"ic", "mdi:counter"}});
-
-        // LED enabled
-        publishHassTopic("switch",
-                         "led_enabled",
-                         uidString,
-                         "_led_enabled",
-                         "LED enabled",
-                         name,
-                         baseTopic,
-                         mqtt_topic_config_led_enabled,
-                         deviceType,
-                         "",
-                         "",
-                         "config",
-                         mqtt_topic_config_led_enabled,
-                         { { "ic", "mdi:led-variant-on" },
-                                          { "pl_on", "1" },
-                                          { "pl_off", "0" },
-                                          { "state_on", "1" },
-                                          { "state_off", "0" }});
-
-        // Button enabled
-        publishHassTopic("switch",
-                         "button_enabled",
-                         uidString,
-                         "_button_enabled",
-                         "Button enabled",
-                         name,
-                         baseTopic,
-                         mqtt_topic_config_button_enabled,
-                         deviceType,
-                         "",
-                         "",
-                         "config",
-                         mqtt_topic_config_button_enabled,
-                         { { "ic", "mdi:radiobox-marked" },
-                           { "pl_on", "1" },
-                           { "pl_off", "0" },
-                           { "state_on", "1" },
-                           { "state_off", "0" }});
-    }
+void Network::publishInt(const char* path, const int value)
+{
+    char str[30];
+    itoa(value, str, 10);
+    _device->mqttPublish(path, MQTT_QOS_LEVEL, true, str);
 }
-//json["cmd_t"] = String("~") + String(mqtt_topic_lock_action);
-void Network::publishHASSConfigBatLevel(char *deviceType, const char *baseTopic, char *name, char *uidString)
+
+void Network::publishUInt(const char* path, const unsigned int value)
 {
-    String discoveryTopic = _preferences->getString(preference_mqtt_hass_discovery);
+    char str[30];
+    utoa(value, str, 10);
+    _device->mqttPublish(path, MQTT_QOS_LEVEL, true, str);
+}
 
-    if (discoveryTopic != "")
-    {
-        publishHassTopic("sensor",
-                         "battery_level",
-                         uidString,
-                         "_battery_level",
-                         "battery level",
-                         name,
-                         baseTopic,
-                         mqtt_topic_battery_level,
-                         deviceType,
-                         "battery",
-                         "measurement",
-                         "diagnostic",
-                         "",
-                         { {"unit_of_meas", "%"} });
-    }
+void Network::publishULong(const char* path, const unsigned long value)
+{
+    char str[30];
+    utoa(value, str, 10);
+    _device->mqttPublish(path, MQTT_QOS_LEVEL, true, str);
 }
 
-void Network::publishHASSConfigDoorSensor(char *deviceType, const char *baseTopic, char *name, char *uidString,
-                                        char *lockAction, char *unlockAction, char *openAction, char *lockedState,
-                                        char *unlockedState)
+void Network::publishBool(const char* path, const bool value)
 {
-    String discoveryTopic = _preferences->getString(preference_mqtt_hass_discovery);
+    char str[2] = {0};
+    str[0] = value ? '1' : '0';
+    _device->mqttPublish(path, MQTT_QOS_LEVEL, true, str);
+}
 
-    if (discoveryTopic != "")
+bool Network::publishString(const char* path, const char *value)
+{
+    if(path == nullptr)
     {
-        publishHassTopic("binary_sensor",
-                         "door_sensor",
-                         uidString,
-                         "_door_sensor",
-                         "door sensor",
-                         name,
-                         baseTopic,
-                         mqtt_topic_lock_door_sensor_state,
-                         deviceType,
-                         "door",
-                         "",
-                         "",
-                         "",
-                         {{"pl_on", "doorOpened"},
-                          {"pl_off", "doorClosed"},
-                          {"pl_not_avail", "unavailable"}});
+        return false;
     }
+    return _device->mqttPublish(path, MQTT_QOS_LEVEL, true, value) > 0;
 }
 
-void Network::publishHASSConfigRingDetect(char *deviceType, const char *baseTopic, char *name, char *uidString)
+void Network::publishBatch(const MqttPublishBatch& batch)
 {
-    String discoveryTopic = _preferences->getString(preference_mqtt_hass_discovery);
-
-    if (discoveryTopic != "")
+    for(size_t i = 0; i < batch.size(); i++)
     {
-        publishHassTopic("binary_sensor",
-                         "ring",
-                         uidString,
-                         "_ring_detect",
-                         "ring detect",
-                         name,
-                         baseTopic,
-                         mqtt_topic_lock_state,
-                         deviceType,
-                         "sound",
-                         "",
-                         "",
-                         "",
-                         {{"pl_on", "ring"},
-                          {"pl_off", "locked"}});
+        _device->mqttPublish(batch.path(i), MQTT_QOS_LEVEL, true, batch.value(i));
     }
 }
 
-
-void Network::publishHASSConfigLedBrightness(char *deviceType, const char *baseTopic, char *name, char *uidString)
+bool Network::hassDiscoveryEnabled() const
 {
-    publishHassTopic("number",
-                     "led_brightness",
-                     uidString,
-                     "_led_brightness",
-                     "LED brightness",
-                     name,
-                     baseTopic,
-                     mqtt_topic_config_led_brightness,
-                     deviceType,
-                     "",
-                     "",
-                     "config",
-                     mqtt_topic_config_led_brightness,
-                     { { "ic", "mdi:brightness-6" },
-                       { "min", "0" },
-                       { "max", "5" }});
+    return _discoveryTopic[0] != 0;
 }
 
-void Network::publishHASSConfigSoundLevel(char *deviceType, const char *baseTopic, char *name, char *uidString)
+HassPublishResult Network::publishHassLock(const HassDevice& device, uint32_t& hash)
 {
-    publishHassTopic("sensor",
-                     "sound_level",
-                     uidString,
-                     "_sound_level",
-                     "Sound level",
-                     name,
-                     baseTopic,
-                     mqtt_topic_config_sound_level,
-                     deviceType,
-                     "",
-                     "",
-                     "config",
-                     mqtt_topic_config_sound_level,
-                     { { "ic", "mdi:volume-source" },
-                       { "min", "0" },
-                       { "max", "255" }});
-}
-
+    ScratchBuffer buffer;
+    JsonWriter json(buffer.data(), buffer.size());
+    json.beginObject();
+    writeHassDevice(json, device);
+    json.add("name", device.name);
+    json.addConcat("unique_id", { device.uidString, hassLock.uidPostfix });
+    json.addConcat("cmd_t", { "~", hassLock.commandTopic });
+    json.add("pl_lock", device.lockAction);
+    json.add("pl_unlk", device.unlockAction);
+    json.add("pl_open", device.openAction);
+    json.addConcat("stat_t", { "~", hassLock.stateTopic });
+    json.add("stat_locked", device.lockedState);
+    json.add("stat_unlocked", device.unlockedState);
+    json.add("opt", "false");
+    json.endObject();
 
-void Network::publishHASSConfigAccessLog(char *deviceType, const char *baseTopic, char *name, char *uidString)
-{
-    publishHassTopic("sensor",
-                     "last_action_authorization",
-                     uidString,
-                     "_last_action_authorization",
-                     "Last action authorization",
-                     name,
-                     baseTopic,
-                     mqtt_topic_lock_log,
-                     deviceType,
-                     "",
-                     "",
-                     "diagnostic",
-                     "",
-                     { { "ic", "mdi:format-list-bulleted" },
-                                      { "value_template", "{{ (value_json|selectattr('type', 'eq', 'LockAction')|selectattr('action', 'in', ['Lock', 'Unlock', 'Unlatch'])|first).authorizationName }}" }});
-}
+    if(!json.ok())
+    {
+        Log->println(F("HASS lock config exceeds the buffer size, skipping"));
+        return HassPublishResult::Unchanged;
+    }
 
-void Network::publishHASSConfigKeypadAttemptInfo(char *deviceType, const char *baseTopic, char *name, char *uidString)
-{
-    publishHassTopic("sensor",
-                     "keypad_status",
-                     uidString,
-                     "_keypad_stats",
-                     "Keypad status",
-                     name,
-                     baseTopic,
-                     mqtt_topic_lock_log,
-                     deviceType,
-                     "",
-                     "",
-                     "diagnostic",
-                     "",
-                     { { "ic", "mdi:drag-vertical" },
-                                      { "value_template", "{{ (value_json|selectattr('type', 'eq', 'KeypadAction')|first).completionStatus }}" }});
+    return publishHassConfig(hassLock, device.uidString, buffer.data(), hash);
 }
 
-void Network::publishHASSWifiRssiConfig(char *deviceType, const char *baseTopic, char *name, char *uidString)
+HassPublishResult Network::publishHassEntity(const HassEntity& entity, const HassDevice& device, uint32_t& hash)
 {
-    if(_device->signalStrength() == 127)
+    ScratchBuffer buffer;
+    JsonWriter json(buffer.data(), buffer.size());
+    json.beginObject();
+    writeHassDevice(json, device);
+    json.addConcat("name", { device.name, " ", entity.displayName });
+    json.addConcat("unique_id", { device.uidString, entity.uidPostfix });
+    if(entity.deviceClass[0] != 0)
     {
-        return;
+        json.add("dev_cla", entity.deviceClass);
     }
-
-    String discoveryTopic = _preferences->getString(preference_mqtt_hass_discovery);
-
-    if (discoveryTopic != "")
+    json.addConcat("stat_t", { "~", entity.stateTopic });
+    if(entity.stateClass[0] != 0)
     {
-        publishHassTopic("sensor",
-                         "wifi_signal_strength",
-                         uidString,
-                         "_wifi_signal_strength",
-                         "wifi signal strength",
-                         name,
-                         baseTopic,
-                         mqtt_topic_wifi_rssi,
-                         deviceType,
-                         "signal_strength",
-                         "measurement",
-                         "diagnostic",
-                         "",
-                         { {"unit_of_meas", "dBm"} });
+        json.add("stat_cla", entity.stateClass);
     }
-}
-
-void Network::publishHASSBleRssiConfig(char *deviceType, const char *baseTopic, char *name, char *uidString)
-{
-    String discoveryTopic = _preferences->getString(preference_mqtt_hass_discovery);
-
-    if (discoveryTopic != "")
+    if(entity.entityCategory[0] != 0)
     {
-        publishHassTopic("sensor",
-                         "bluetooth_signal_strength",
-                         uidString,
-                         "_bluetooth_signal_strength",
-                         "bluetooth signal strength",
-                         name,
-                         baseTopic,
-                         mqtt_topic_lock_rssi,
-                         deviceType,
-                         "signal_strength",
-                         "measurement",
-                         "diagnostic",
-                         "",
-                         { {"unit_of_meas", "dBm"} });
+        json.add("ent_cat", entity.entityCategory);
     }
-}
-
-void Network::publishHassTopic(const String& mqttDeviceType,
-                               const String& mattDeviceName,
-                               const String& uidString,
-                               const String& uidStringPostfix,
-                               const String& displayName,
-                               const String& name,
-                               const String& baseTopic,
-                               const String& stateTopic,
-                               const String& deviceType,
-                               const String& deviceClass,
-                               const String& stateClass,
-                               const String& entityCat,
-                               const String& commandTopic,
-                               std::vector<std::pair<char*, char*>> additionalEntries
-)
-{
-    String discoveryTopic = _preferences->getString(preference_mqtt_hass_discovery);
-
-    if (discoveryTopic != "")
+    if(entity.commandTopic[0] != 0)
     {
-        DynamicJsonDocument json(_bufferSize);
-
-        // Battery level
-        json.clear();
-        auto dev = json.createNestedObject("dev");
-        auto ids = dev.createNestedArray("ids");
-        ids.add(String("nuki_") + uidString);
-        json["dev"]["mf"] = "Nuki";
-        json["dev"]["mdl"] = deviceType;
-        json["dev"]["name"] = name;
-        json["~"] = baseTopic;
-        json["name"] = name + String(" " + displayName);
-        json["unique_id"] = String(uidString) + uidStringPostfix;
-        if(deviceClass != "")
-        {
-            json["dev_cla"] = deviceClass;
-        }
-        json["stat_t"] = String("~") + stateTopic;
+        json.addConcat("cmd_t", { "~", entity.commandTopic });
+    }
 
-        if(stateClass != "")
+    for(uint8_t i = 0; i < entity.attributeCount; i++)
+    {
+        const HassAttribute& attribute = entity.attributes[i];
+        if(strcmp(attribute.value, "true") == 0)
         {
-            json["stat_cla"] = stateClass;
+            json.add(attribute.key, true);
         }
-        if(entityCat != "")
+        else if(strcmp(attribute.value, "false") == 0)
         {
-            json["ent_cat"] = entityCat;
+            json.add(attribute.key, false);
         }
-        if(commandTopic != "")
+        else
         {
-            json["cmd_t"] = String("~") + commandTopic;
+            json.add(attribute.key, attribute.value);
         }
+    }
+    json.endObject();
 
-        for(const auto& entry : additionalEntries)
-        {
-            if(strcmp(entry.second, "true") == 0)
-            {
-                json[entry.first] = true;
-            }
-            else if(strcmp(entry.second, "false") == 0)
-            {
-                json[entry.first] = false;
-            }
-            else
-            {
-                json[entry.first] = entry.second;
-            }
-        }
+    if(!json.ok())
+    {
+        Log->print(F("HASS config for "));
+        Log->print(entity.objectId);
+        Log->println(F(" exceeds the buffer size, skipping"));
+        return HassPublishResult::Unchanged;
+    }
 
-        serializeJson(json, _buffer, _bufferSize);
+    return publishHassConfig(entity, device.uidString, buffer.data(), hash);
+}
 
-        String path = discoveryTopic;
-        path.concat("/");
-        path.concat(mqttDeviceType);
-        path.concat("/");
-        path.concat(uidString);
-        path.concat("/");
-        path.concat(mattDeviceName);
-        path.concat("/config");
+HassPublishResult Network::removeHassEntity(const HassEntity& entity, const HassDevice& device, uint32_t& hash)
+{
+    return publishHassConfig(entity, device.uidString, "", hash);
+}
 
-        _device->mqttPublish(path.c_str(), MQTT_QOS_LEVEL, true, _buffer);
+HassPublishResult Network::publishHassConfig(const HassEntity& entity, const char* uidString, const char* payload, uint32_t& hash)
+{
+    if(_discoveryTopic[0] == 0)
+    {
+        return HassPublishResult::Unchanged;
     }
-}
 
+    char path[HASS_CONFIG_PATH_SIZE];
+    buildHassConfigPath(path, entity.component, uidString, entity.objectId);
 
-void Network::removeHassTopic(const String& mqttDeviceType, const String& mattDeviceName, const String& uidString)
-{
-    String discoveryTopic = _preferences->getString(preference_mqtt_hass_discovery);
+    uint32_t payloadHash = fnv1a(payload, fnv1a(path));
+    if(payloadHash == hash)
+    {
+        return HassPublishResult::Unchanged;
+    }
 
-    if (discoveryTopic != "")
+    if(_device->mqttPublish(path, MQTT_QOS_LEVEL, true, payload) == 0)
     {
-        String path = discoveryTopic;
-        path.concat("/");
-        path.concat(mqttDeviceType);
-        path.concat("/");
-        path.concat(uidString);
-        path.concat("/");
-        path.concat(mattDeviceName);
-        path.concat("/config");
-
-        _device->mqttPublish(path.c_str(), MQTT_QOS_LEVEL, true, "");
+        return HassPublishResult::Failed;
     }
+
+    hash = payloadHash;
+    return HassPublishResult::Published;
 }
 
+void Network::writeHassDevice(JsonWriter& json, const HassDevice& device)
+{
+    json.beginObject("dev");
+    json.beginArray("ids");
+    json.addConcat(nullptr, { "nuki_", device.uidString });
+    json.endArray();
+    json.add("mf", "Nuki");
+    json.add("mdl", device.deviceType);
+    json.add("name", device.name);
+    json.endObject();
+    json.add("~", device.baseTopic);
+}
+
+void Network::buildHassConfigPath(char* outPath, const char* component, const char* uidString, const char* objectId)
+{
+    snprintf(outPath, HASS_CONFIG_PATH_SIZE, "%s/%s/%s/%s/config", _discoveryTopic, component, uidString, objectId);
+}
 
 void Network::removeHASSConfig(char* uidString)
 {
-    String discoveryTopic = _preferences->getString(preference_mqtt_hass_discovery);
+    if(_discoveryTopic[0] == 0)
+    {
+        return;
+    }
 
-    if(discoveryTopic != "")
+    char path[HASS_CONFIG_PATH_SIZE];
+    for(const auto& config : hassRemovedConfigs)
     {
-        String path = discoveryTopic;
-        path.concat("/lock/");
-        path.concat(uidString);
-        path.concat("/smartlock/config");
-        _device->mqttPublish(path.c_str(), MQTT_QOS_LEVEL, true, "");
-
-        path = discoveryTopic;
-        path.concat("/binary_sensor/");
-        path.concat(uidString);
-        path.concat("/battery_low/config");
-        _device->mqttPublish(path.c_str(), MQTT_QOS_LEVEL, true, "");
-
-        path = discoveryTopic;
-        path.concat("/sensor/");
-        path.concat(uidString);
-        path.concat("/battery_voltage/config");
-        _device->mqttPublish(path.c_str(), MQTT_QOS_LEVEL, true, "");
-
-        path = discoveryTopic;
-        path.concat("/sensor/");
-        path.concat(uidString);
-        path.concat("/trigger/config");
-        _device->mqttPublish(path.c_str(), MQTT_QOS_LEVEL, true, "");
-
-        path = discoveryTopic;
-        path.concat("/sensor/");
-        path.concat(uidString);
-        path.concat("/battery_level/config");
-        _device->mqttPublish(path.c_str(), MQTT_QOS_LEVEL, true, "");
-
-        path = discoveryTopic;
-        path.concat("/binary_sensor/");
-        path.concat(uidString);
-        path.concat("/door_sensor/config");
-        _device->mqttPublish(path.c_str(), MQTT_QOS_LEVEL, true, "");
-
-        path = discoveryTopic;
-        path.concat("/binary_sensor/");
-        path.concat(uidString);
-        path.concat("/ring/config");
-        _device->mqttPublish(path.c_str(), MQTT_QOS_LEVEL, true, "");
-
-        path = discoveryTopic;
-        path.concat("/sensor/");
-        path.concat(uidString);
-        path.concat("/wifi_signal_strength/config");
-        _device->mqttPublish(path.c_str(), MQTT_QOS_LEVEL, true, "");
-
-        path = discoveryTopic;
-        path.concat("/sensor/");
-        path.concat(uidString);
-        path.concat("/bluetooth_signal_strength/config");
-        _device->mqttPublish(path.c_str(), MQTT_QOS_LEVEL, true, "");
+        buildHassConfigPath(path, config[0], uidString, config[1]);
+        _device->mqttPublish(path, MQTT_QOS_LEVEL, true, "");
     }
 }
 
-void Network::removeHASSConfigTopic(char *deviceType, char *name, char *uidString)
+void Network::publishPresenceDetection(char *csv)
 {
-    removeHassTopic(deviceType, name, uidString);
+    _presenceCsv.store(csv, std::memory_order_release);
 }
 
-void Network::publishPresenceDetection(char *csv)
+void Network::publishPresenceEvents(char *json)
 {
-    _presenceCsv = csv;
+    _presenceEvents.store(json, std::memory_order_release);
+}
+
+bool Network::presencePublishPending() const
+{
+    return _presenceCsv.load(std::memory_order_acquire) != nullptr || _presenceEvents.load(std::memory_order_acquire) != nullptr;
 }
 
 const NetworkDeviceType Network::networkDeviceType()
@@ -1344,8 +983,25 @@ void Network::clearWifiFallback()
 
 void Network::disableMqtt()
 {
-    _device->disableMqtt();
-    _mqttEnabled = false;
+    _requests.fetch_or(NETWORK_REQUEST_DISABLE_MQTT);
+}
+
+void Network::processRequests(const uint8_t requests)
+{
+    if((requests & NETWORK_REQUEST_DISABLE_AUTO_RESTARTS) != 0)
+    {
+        _networkTimeout = 0;
+        _restartOnDisconnect = false;
+    }
+    if((requests & NETWORK_REQUEST_DISABLE_MQTT) != 0)
+    {
+        _device->disableMqtt();
+        _mqttEnabled = false;
+    }
+    if((requests & NETWORK_REQUEST_RECONFIGURE_DEVICE) != 0)
+    {
+        _device->reconfigure();
+    }
 }
 
 NetworkDevice *Network::device()
@@ -3,11 +3,19 @@
 #include <Preferences.h>
 #include <vector>
 #include <map>
+#include <atomic>
 #include "networkDevices/NetworkDevice.h"
 #include "MqttReceiver.h"
 #include "networkDevices/IPConfiguration.h"
 #include "MqttTopics.h"
 #include "Gpio.h"
+#include "MqttPublishBatch.h"
+#include "MqttTopicTable.h"
+#include "Config.h"
+#include "MqttTopicDispatcher.h"
+#include "JsonWriter.h"
+#include "HassEntities.h"
+#include "StatusSnapshot.h"
 
 enum class NetworkDeviceType
 {
@@ -19,48 +27,61 @@ enum class NetworkDeviceType
     LilyGO_T_ETH_POE
 };
 
-#define JSON_BUFFER_SIZE 1024
+#define HASS_CONFIG_PATH_SIZE 250
+
+// Requests of other tasks, applied by the network task in update()
+#define NETWORK_REQUEST_RECONFIGURE_DEVICE 1
+#define NETWORK_REQUEST_DISABLE_AUTO_RESTARTS 2
+#define NETWORK_REQUEST_DISABLE_MQTT 4
 
 class Network
 {
 public:
-    explicit Network(Preferences* preferences, Gpio* gpio, const String& maintenancePathPrefix, char* buffer, size_t bufferSize);
+    explicit Network(Preferences* preferences, Gpio* gpio, StatusSnapshot* statusSnapshot, const String& maintenancePathPrefix);
 
     void initialize();
     bool update();
-    void registerMqttReceiver(MqttReceiver* receiver);
-    void reconfigureDevice();
     void setMqttPresencePath(char* path);
+    // Called from the web task, applied by the network task on its next update()
+    void reconfigureDevice();
     void disableAutoRestarts(); // disable on OTA start
     void disableMqtt();
 
+    // path and value pointers are stored as-is and must outlive the network instance
+    void subscribe(const char* path);
+    void subscribe(MqttReceiver* receiver, const MqttTopicTable& topics, const MqttTopic& topic);
+    void initTopic(const char* path, const char* value);
     void subscribe(const char* prefix, const char* path);
-    void initTopic(const char* prefix, const char* path, const char* value);
+    void publishFloat(const char* path, const float value, const uint8_t precision = 2);
+    void publishInt(const char* path, const int value);
+    void publishUInt(const char* path, const unsigned int value);
+    void publishULong(const char* path, const unsigned long value);
+    void publishBool(const char* path, const bool value);
+    bool publishString(const char* path, const char* value);
     void publishFloat(const char* prefix, const char* topic, const float value, const uint8_t precision = 2);
     void publishInt(const char* prefix, const char* topic, const int value);
     void publishUInt(const char* prefix, const char* topic, const unsigned int value);
     void publishULong(const char* prefix, const char* topic, const unsigned long value);
     void publishBool(const char* prefix, const char* topic, const bool value);
     bool publishString(const char* prefix, const char* topic, const char* value);
+    void publishBatch(const MqttPublishBatch& batch);
 
-    void publishHASSConfig(char* deviceType, const char* baseTopic, char* name, char* uidString, const bool& hasKeypad, char* lockAction, char* unlockAction, char* openAction, char* lockedState, char* unlockedState);
-    void publishHASSConfigBatLevel(char* deviceType, const char* baseTopic, char* name, char* uidString);
-    void publishHASSConfigDoorSensor(char* deviceType, const char* baseTopic, char* name, char* uidString, char* lockAction, char* unlockAction, char* openAction, char* lockedState, char* unlockedState);
-    void publishHASSConfigRingDetect(char* deviceType, const char* baseTopic, char* name, char* uidString);
-    void publishHASSConfigLedBrightness(char* deviceType, const char* baseTopic, char* name, char* uidString);
-    void publishHASSConfigSoundLevel(char* deviceType, const char* baseTopic, char* name, char* uidString);
-    void publishHASSConfigAccessLog(char* deviceType, const char* baseTopic, char* name, char* uidString);
-    void publishHASSConfigKeypadAttemptInfo(char* deviceType, const char* baseTopic, char* name, char* uidString);
-    void publishHASSWifiRssiConfig(char* deviceType, const char* baseTopic, char* name, char* uidString);
-    void publishHASSBleRssiConfig(char* deviceType, const char* baseTopic, char* name, char* uidString);
+    bool hassDiscoveryEnabled() const;
+    // Skipped with HassPublishResult::Unchanged if path and payload match the hash of the previous publish, hash is updated on success
+    HassPublishResult publishHassLock(const HassDevice& device, uint32_t& hash);
+    HassPublishResult publishHassEntity(const HassEntity& entity, const HassDevice& device, uint32_t& hash);
+    HassPublishResult removeHassEntity(const HassEntity& entity, const HassDevice& device, uint32_t& hash);
     void removeHASSConfig(char* uidString);
-    void removeHASSConfigTopic(char* deviceType, char* name, char* uidString);
 
     void clearWifiFallback();
 
+    // Hand over presence output to the network task. The buffers must stay untouched while presencePublishPending()
     void publishPresenceDetection(char* csv);
+    void publishPresenceEvents(char* json);
+    bool presencePublishPending() const;
 
     int mqttConnectionState(); // 0 = not connected; 1 = connected; 2 = connected and mqtt processed
+    bool mqttSessionPresent() const; // session present flag of the last CONNACK, false if the broker lost its state
     bool encryptionSupported();
     const String networkDeviceName() const;
 
@@ -74,30 +95,17 @@ public:
     NetworkDevice* device();
 
 private:
+    void processRequests(const uint8_t requests);
     static void onMqttDataReceivedCallback(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t len, size_t index, size_t total);
-    void onMqttDataReceived(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t& len, size_t& index, size_t& total);
-    void parseGpioTopics(const espMqttClientTypes::MessageProperties& properties, const char* topic, const uint8_t* payload, size_t& len, size_t& index, size_t& total);
+    void onMqttDataReceived(const char* topic, const uint8_t* payload, const size_t& len, const size_t& index, const size_t& total);
+    void parseGpioTopics(const char* topic, const char* payload);
     void gpioActionCallback(const GpioAction& action, const int& pin);
     void setupDevice();
     bool reconnect();
 
-    void publishHassTopic(const String& mqttDeviceType,
-                          const String& mattDeviceName,
-                          const String& uidString,
-                          const String& uidStringPostfix,
-                          const String& displayName,
-                          const String& name,
-                          const String& baseTopic,
-                          const String& stateTopic,
-                          const String& deviceType,
-                          const String& deviceClass,
-                          const String& stateClass = "",
-                          const String& entityCat = "",
-                          const String& commandTopic = "",
-                          std::vector<std::pair<char*, char*>> additionalEntries = {}
-                          );
-
-    void removeHassTopic(const String& mqttDeviceType, const String& mattDeviceName, const String& uidString);
+    HassPublishResult publishHassConfig(const HassEntity& entity, const char* uidString, const char* payload, uint32_t& hash);
+    void writeHassDevice(JsonWriter& json, const HassDevice& device);
+    void buildHassConfigPath(char* outPath, const char* component, const char* uidString, const char* objectId);
 
     void onMqttConnect(const bool& sessionPresent);
     void onMqttDisconnect(const espMqttClientTypes::DisconnectReason& reason);
@@ -112,39 +120,45 @@ private:
 
     Preferences* _preferences;
     Gpio* _gpio;
+    StatusSnapshot* _statusSnapshot;
+    NetworkStatus _status;
     IPConfiguration* _ipConfiguration = nullptr;
     String _hostname;
     char _hostnameArr[101] = {0};
     NetworkDevice* _device = nullptr;
     int _mqttConnectionState = 0;
     bool _connectReplyReceived = false;
+    bool _mqttSessionPresent = false;
 
     unsigned long _nextReconnect = 0;
     char _mqttBrokerAddr[101] = {0};
     char _mqttUser[31] = {0};
     char _mqttPass[31] = {0};
-    char _mqttPresencePrefix[181] = {0};
     char _maintenancePathPrefix[181] = {0};
+    char _discoveryTopic[101] = {0};
+    MqttTopicTable _maintenanceTopics;
+    MqttTopicTable _presenceTopics;
     int _networkTimeout = 0;
-    std::vector<MqttReceiver*> _mqttReceivers;
-    char* _presenceCsv = nullptr;
+    MqttTopicDispatcher _dispatcher;
+    char _inboundPayload[MQTT_INBOUND_PAYLOAD_SIZE + 1] = {0};
+    char _gpioPinPathPrefix[211] = {0};
+    std::atomic<char*> _presenceCsv;
+    std::atomic<char*> _presenceEvents;
     bool _restartOnDisconnect = false;
     bool _firstConnect = true;
     bool _publishDebugInfo = false;
-    std::vector<String> _subscribedTopics;
-    std::map<String, String> _initTopics;
+    std::vector<const char*> _subscribedTopics;
+    std::vector<std::pair<const char*, const char*>> _initTopics;
 
     unsigned long _lastConnectedTs = 0;
     unsigned long _lastMaintenanceTs = 0;
     unsigned long _lastRssiTs = 0;
     bool _mqttEnabled = true;
+    std::atomic<uint8_t> _requests{0}; // NETWORK_REQUEST_* flags
     static unsigned long _ignoreSubscriptionsTs;
     long _rssiPublishInterval = 0;
     std::map<uint8_t, unsigned long> _gpioTs;
 
-    char* _buffer;
-    const size_t _bufferSize;
-
     std::function<void()> _keepAliveCallback = nullptr;
     std::vector<std::function<void()>> _reconnectedCallbacks;
 
@@ -4,24 +4,23 @@
 #include "MqttTopics.h"
 #include "PreferencesKeys.h"
 #include "Logger.h"
+#include "NukiTask.h"
 #include "RestartReason.h"
 #include <ArduinoJson.h>
+#include "ScratchBuffer.h"
 
-NetworkLock::NetworkLock(Network* network, Preferences* preferences, char* buffer, size_t bufferSize)
+NetworkLock::NetworkLock(Network* network, Preferences* preferences)
 : _network(network),
   _preferences(preferences),
-  _buffer(buffer),
-  _bufferSize(bufferSize)
+  _hassDiscovery(network, preferences, preference_hass_hashes_lock)
 {
     _configTopics.reserve(5);
-    _configTopics.push_back(mqtt_topic_config_button_enabled);
-    _configTopics.push_back(mqtt_topic_config_led_enabled);
-    _configTopics.push_back(mqtt_topic_config_led_brightness);
-    _configTopics.push_back(mqtt_topic_config_auto_unlock);
-    _configTopics.push_back(mqtt_topic_config_auto_lock);
-    _configTopics.push_back(mqtt_topic_config_single_lock);
-
-    _network->registerMqttReceiver(this);
+    _configTopics.push_back(MqttTopic::ConfigButtonEnabled);
+    _configTopics.push_back(MqttTopic::ConfigLedEnabled);
+    _configTopics.push_back(MqttTopic::ConfigLedBrightness);
+    _configTopics.push_back(MqttTopic::ConfigAutoUnlock);
+    _configTopics.push_back(MqttTopic::ConfigAutoLock);
+    _configTopics.push_back(MqttTopic::ConfigSingleLock);
 }
 
 NetworkLock::~NetworkLock()
@@ -48,161 +47,223 @@ void NetworkLock::initialize()
     _network->setMqttPresencePath(_mqttPath);
 
     _haEnabled = _preferences->getString(preference_mqtt_hass_discovery) != "";
+    _publishJson = _preferences->getBool(preference_publish_json_state);
+
+    _topics.initialize(_mqttPath, {
+        MqttTopic::ConfigButtonEnabled, MqttTopic::ConfigLedEnabled, MqttTopic::ConfigLedBrightness,
+        MqttTopic::ConfigAutoUnlock, MqttTopic::ConfigAutoLock, MqttTopic::ConfigSingleLock, MqttTopic::LockState,
+        MqttTopic::LockBinaryState, MqttTopic::LockTrigger, MqttTopic::LockLastLockAction,
+        MqttTopic::LockCompletionStatus, MqttTopic::LockDoorSensorState, MqttTopic::BatteryCritical,
+        MqttTopic::BatteryCharging, MqttTopic::BatteryLevel, MqttTopic::BatteryKeypadCritical, MqttTopic::LockJson,
+        MqttTopic::LockAction, MqttTopic::Reset, MqttTopic::QueryConfig, MqttTopic::QueryLockstate,
+        MqttTopic::QueryBattery, MqttTopic::KeypadCommandAction, MqttTopic::KeypadCommandId,
+        MqttTopic::KeypadCommandName, MqttTopic::KeypadCommandCode, MqttTopic::KeypadCommandEnabled,
+        MqttTopic::QueryKeypad, MqttTopic::LockLog, MqttTopic::LockAuthId, MqttTopic::LockAuthName,
+        MqttTopic::LockCommandId, MqttTopic::LockActionCommandResult, MqttTopic::QueryLockstateCommandResult,
+        MqttTopic::BatteryVoltage, MqttTopic::BatteryDrain, MqttTopic::BatteryMaxTurnCurrent,
+        MqttTopic::BatteryLockDistance, MqttTopic::InfoFirmwareVersion, MqttTopic::InfoHardwareVersion,
+        MqttTopic::LockRssi, MqttTopic::LockRetry, MqttTopic::LockAddress, MqttTopic::KeypadCommandResult,
+        MqttTopic::KeypadJsonCommand, MqttTopic::KeypadJsonCommandResult, MqttTopic::KeypadRevision,
+        MqttTopic::LockCommandResultJson
+    });
 
-    _network->initTopic(_mqttPath, mqtt_topic_lock_action, "--");
-    _network->subscribe(_mqttPath, mqtt_topic_lock_action);
+    _network->initTopic(_topics.get(MqttTopic::LockAction), "--");
+    _network->subscribe(this, _topics, MqttTopic::LockAction);
     for(const auto& topic : _configTopics)
     {
-        _network->subscribe(_mqttPath, topic);
+        _network->subscribe(this, _topics, topic);
     }
 
-    _network->subscribe(_mqttPath, mqtt_topic_reset);
-    _network->initTopic(_mqttPath, mqtt_topic_reset, "0");
+    _network->subscribe(this, _topics, MqttTopic::Reset);
+    _network->initTopic(_topics.get(MqttTopic::Reset), "0");
 
-    _network->initTopic(_mqttPath, mqtt_topic_query_config, "0");
-    _network->initTopic(_mqttPath, mqtt_topic_query_lockstate, "0");
-    _network->initTopic(_mqttPath, mqtt_topic_query_battery, "0");
-    _network->subscribe(_mqttPath, mqtt_topic_query_config);
-    _network->subscribe(_mqttPath, mqtt_topic_query_lockstate);
-    _network->subscribe(_mqttPath, mqtt_topic_query_battery);
+    _network->initTopic(_topics.get(MqttTopic::QueryConfig), "0");
+    _network->initTopic(_topics.get(MqttTopic::QueryLockstate), "0");
+    _network->initTopic(_topics.get(MqttTopic::QueryBattery), "0");
+    _network->subscribe(this, _topics, MqttTopic::QueryConfig);
+    _network->subscribe(this, _topics, MqttTopic::QueryLockstate);
+    _network->subscribe(this, _topics, MqttTopic::QueryBattery);
 
     if(_preferences->getBool(preference_keypad_control_enabled))
     {
-        _network->subscribe(_mqttPath, mqtt_topic_keypad_command_action);
-        _network->subscribe(_mqttPath, mqtt_topic_keypad_command_id);
-        _network->subscribe(_mqttPath, mqtt_topic_keypad_command_name);
-        _network->subscribe(_mqttPath, mqtt_topic_keypad_command_code);
-        _network->subscribe(_mqttPath, mqtt_topic_keypad_command_enabled);
-        _network->subscribe(_mqttPath, mqtt_topic_query_keypad);
-        _network->initTopic(_mqttPath, mqtt_topic_keypad_command_action, "--");
-        _network->initTopic(_mqttPath, mqtt_topic_keypad_command_id, "0");
-        _network->initTopic(_mqttPath, mqtt_topic_keypad_command_name, "--");
-        _network->initTopic(_mqttPath, mqtt_topic_keypad_command_code, "000000");
-        _network->initTopic(_mqttPath, mqtt_topic_keypad_command_enabled, "1");
-        _network->initTopic(_mqttPath, mqtt_topic_query_keypad, "0");
+        _network->subscribe(this, _topics, MqttTopic::KeypadCommandAction);
+        _network->subscribe(this, _topics, MqttTopic::KeypadCommandId);
+        _network->subscribe(this, _topics, MqttTopic::KeypadCommandName);
+        _network->subscribe(this, _topics, MqttTopic::KeypadCommandCode);
+        _network->subscribe(this, _topics, MqttTopic::KeypadCommandEnabled);
+        _network->subscribe(this, _topics, MqttTopic::KeypadJsonCommand);
+        _network->subscribe(this, _topics, MqttTopic::QueryKeypad);
+        _network->initTopic(_topics.get(MqttTopic::KeypadCommandAction), "--");
+        _network->initTopic(_topics.get(MqttTopic::KeypadCommandId), "0");
+        _network->initTopic(_topics.get(MqttTopic::KeypadCommandName), "--");
+        _network->initTopic(_topics.get(MqttTopic::KeypadCommandCode), "000000");
+        _network->initTopic(_topics.get(MqttTopic::KeypadCommandEnabled), "1");
+        _network->initTopic(_topics.get(MqttTopic::KeypadJsonCommand), "--");
+        _network->initTopic(_topics.get(MqttTopic::QueryKeypad), "0");
     }
 
     _network->addReconnectedCallback([&]()
     {
         _reconnected = true;
+        _keypadResync = true;
+        if(!_network->mqttSessionPresent())
+        {
+            _brokerStateLost = true;
+        }
+        wakeNukiTask();
     });
 }
 
-void NetworkLock::onMqttDataReceived(const char* topic, byte* payload, const unsigned int length)
+void NetworkLock::onMqttDataReceived(const MqttTopic& topic, byte* payload, const unsigned int length)
 {
     char* value = (char*)payload;
 
-    if(comparePrefixedPath(topic, mqtt_topic_reset) && strcmp(value, "1") == 0)
-    {
-        Log->println(F("Restart requested via MQTT."));
-        _network->clearWifiFallback();
-        delay(200);
-        restartEsp(RestartReason::RequestedViaMqtt);
-    }
-
-    if(comparePrefixedPath(topic, mqtt_topic_lock_action))
+    switch(topic)
     {
-        if(strcmp(value, "") == 0 ||
-           strcmp(value, "--") == 0 ||
-           strcmp(value, "ack") == 0 ||
-           strcmp(value, "unknown_action") == 0 ||
-           strcmp(value, "denied") == 0 ||
-           strcmp(value, "error") == 0) return;
-
-        Log->print(F("Lock action received: "));
-        Log->println(value);
-        LockActionResult lockActionResult = LockActionResult::Failed;
-        if(_lockActionReceivedCallback != NULL)
-        {
-            lockActionResult = _lockActionReceivedCallback(value);
-        }
-
-        switch(lockActionResult)
+        case MqttTopic::Reset:
+            if(strcmp(value, "1") == 0)
+            {
+                Log->println(F("Restart requested via MQTT."));
+                _network->clearWifiFallback();
+                delay(200);
+                restartEsp(RestartReason::RequestedViaMqtt);
+            }
+            break;
+        case MqttTopic::LockAction:
         {
-            case LockActionResult::Success:
-                publishString(mqtt_topic_lock_action, "ack");
-                break;
-            case LockActionResult::UnknownAction:
-                publishString(mqtt_topic_lock_action, "unknown_action");
-                break;
-            case LockActionResult::AccessDenied:
-                publishString(mqtt_topic_lock_action, "denied");
-                break;
-            case LockActionResult::Failed:
-                publishString(mqtt_topic_lock_action, "error");
+            if(strcmp(value, "") == 0 ||
+               strcmp(value, "--") == 0 ||
+               strcmp(value, "ack") == 0 ||
+               strcmp(value, "unknown_action") == 0 ||
+               strcmp(value, "denied") == 0 ||
+               strcmp(value, "error") == 0 ||
+               strcmp(value, "queue_full") == 0)
+            {
                 break;
+            }
+
+            Log->print(F("Lock action received: "));
+            Log->println(value);
+            LockActionResult lockActionResult = LockActionResult::Failed;
+            if(_lockActionReceivedCallback != NULL)
+            {
+                lockActionResult = _lockActionReceivedCallback(value);
+            }
+
+            switch(lockActionResult)
+            {
+                case LockActionResult::Success:
+                    publishString(MqttTopic::LockAction, "ack");
+                    break;
+                case LockActionResult::UnknownAction:
+                    publishString(MqttTopic::LockAction, "unknown_action");
+                    break;
+                case LockActionResult::AccessDenied:
+                    publishString(MqttTopic::LockAction, "denied");
+                    break;
+                case LockActionResult::Failed:
+                    publishString(MqttTopic::LockAction, "error");
+                    break;
+                case LockActionResult::QueueFull:
+                    publishString(MqttTopic::LockAction, "queue_full");
+                    break;
+            }
+            break;
         }
-    }
+        case MqttTopic::KeypadCommandAction:
+            if(_keypadCommandReceivedReceivedCallback != nullptr)
+            {
+                if(strcmp(value, "--") == 0)
+                {
+                    break;
+                }
 
-    if(comparePrefixedPath(topic, mqtt_topic_keypad_command_action))
-    {
-        if(_keypadCommandReceivedReceivedCallback != nullptr)
-        {
-            if(strcmp(value, "--") == 0) return;
+                _keypadCommandReceivedReceivedCallback(value, _keypadCommandId, _keypadCommandName, _keypadCommandCode, _keypadCommandEnabled);
 
-            _keypadCommandReceivedReceivedCallback(value, _keypadCommandId, _keypadCommandName, _keypadCommandCode, _keypadCommandEnabled);
+                _keypadCommandId = 0;
+                _keypadCommandName = "--";
+                _keypadCommandCode = "000000";
+                _keypadCommandEnabled = 1;
 
-            _keypadCommandId = 0;
-            _keypadCommandName = "--";
-            _keypadCommandCode = "000000";
-            _keypadCommandEnabled = 1;
+                if(strcmp(value, "--") != 0)
+                {
+                    publishString(MqttTopic::KeypadCommandAction, "--");
+                }
+                publishInt(MqttTopic::KeypadCommandId, _keypadCommandId);
+                publishString(MqttTopic::KeypadCommandName, _keypadCommandName);
+                publishString(MqttTopic::KeypadCommandCode, _keypadCommandCode);
+                publishInt(MqttTopic::KeypadCommandEnabled, _keypadCommandEnabled);
+            }
+            break;
+        case MqttTopic::KeypadCommandId:
+            _keypadCommandId = atoi(value);
+            break;
+        case MqttTopic::KeypadCommandName:
+            _keypadCommandName = value;
+            break;
+        case MqttTopic::KeypadCommandCode:
+            _keypadCommandCode = value;
+            break;
+        case MqttTopic::KeypadCommandEnabled:
+            _keypadCommandEnabled = atoi(value);
+            break;
+        case MqttTopic::KeypadJsonCommand:
+            if(_keypadJsonCommandReceivedCallback != nullptr)
+            {
+                if(strcmp(value, "") == 0 || strcmp(value, "--") == 0)
+                {
+                    break;
+                }
 
-            if(strcmp(value, "--") != 0)
+                _keypadJsonCommandReceivedCallback(value);
+                publishString(MqttTopic::KeypadJsonCommand, "--");
+            }
+            break;
+        case MqttTopic::QueryConfig:
+            if(strcmp(value, "1") == 0)
             {
-                publishString(mqtt_topic_keypad_command_action, "--");
+                _queryCommands = _queryCommands | QUERY_COMMAND_CONFIG;
+                wakeNukiTask();
+                publishString(MqttTopic::QueryConfig, "0");
             }
-            publishInt(mqtt_topic_keypad_command_id, _keypadCommandId);
-            publishString(mqtt_topic_keypad_command_name, _keypadCommandName);
-            publishString(mqtt_topic_keypad_command_code, _keypadCommandCode);
-            publishInt(mqtt_topic_keypad_command_enabled, _keypadCommandEnabled);
-        }
-    }
-    else if(comparePrefixedPath(topic, mqtt_topic_keypad_command_id))
-    {
-        _keypadCommandId = atoi(value);
-    }
-    else if(comparePrefixedPath(topic, mqtt_topic_keypad_command_name))
-    {
-        _keypadCommandName = value;
-    }
-    else if(comparePrefixedPath(topic, mqtt_topic_keypad_command_code))
-    {
-        _keypadCommandCode = value;
-    }
-    else if(comparePrefixedPath(topic, mqtt_topic_keypad_command_enabled))
-    {
-        _keypadCommandEnabled = atoi(value);
-    }
-    else if(comparePrefixedPath(topic, mqtt_topic_query_config) && strcmp(value, "1") == 0)
-    {
-        _queryCommands = _queryCommands | QUERY_COMMAND_CONFIG;
-        publishString(mqtt_topic_query_config, "0");
-    }
-    else if(comparePrefixedPath(topic, mqtt_topic_query_lockstate) && strcmp(value, "1") == 0)
-    {
-        _queryCommands = _queryCommands | QUERY_COMMAND_LOCKSTATE;
-        publishString(mqtt_topic_query_lockstate, "0");
-    }
-    else if(comparePrefixedPath(topic, mqtt_topic_query_keypad) && strcmp(value, "1") == 0)
-    {
-        _queryCommands = _queryCommands | QUERY_COMMAND_KEYPAD;
-        publishString(mqtt_topic_query_keypad, "0");
-    }
-    else if(comparePrefixedPath(topic, mqtt_topic_query_battery) && strcmp(value, "1") == 0)
-    {
-        _queryCommands = _queryCommands | QUERY_COMMAND_BATTERY;
-        publishString(mqtt_topic_query_battery, "0");
-    }
-
-    for(auto configTopic : _configTopics)
-    {
-        if(comparePrefixedPath(topic, configTopic))
-        {
+            break;
+        case MqttTopic::QueryLockstate:
+            if(strcmp(value, "1") == 0)
+            {
+                _queryCommands = _queryCommands | QUERY_COMMAND_LOCKSTATE;
+                wakeNukiTask();
+                publishString(MqttTopic::QueryLockstate, "0");
+            }
+            break;
+        case MqttTopic::QueryKeypad:
+            if(strcmp(value, "1") == 0)
+            {
+                _queryCommands = _queryCommands | QUERY_COMMAND_KEYPAD;
+                wakeNukiTask();
+                publishString(MqttTopic::QueryKeypad, "0");
+            }
+            break;
+        case MqttTopic::QueryBattery:
+            if(strcmp(value, "1") == 0)
+            {
+                _queryCommands = _queryCommands | QUERY_COMMAND_BATTERY;
+                wakeNukiTask();
+                publishString(MqttTopic::QueryBattery, "0");
+            }
+            break;
+        case MqttTopic::ConfigButtonEnabled:
+        case MqttTopic::ConfigLedEnabled:
+        case MqttTopic::ConfigLedBrightness:
+        case MqttTopic::ConfigAutoUnlock:
+        case MqttTopic::ConfigAutoLock:
+        case MqttTopic::ConfigSingleLock:
             if(_configUpdateReceivedCallback != nullptr)
             {
-                _configUpdateReceivedCallback(configTopic, value);
+                _configUpdateReceivedCallback(MqttTopicTable::subPath(topic), value);
             }
-        }
+            break;
+        default:
+            break;
     }
 }
 
@@ -210,15 +271,18 @@ void NetworkLock::publishKeyTurnerState(const NukiLock::KeyTurnerState& keyTurne
 {
     char str[50];
 
+    _stateBatch.clear();
+
     if((_firstTunerStatePublish || keyTurnerState.lockState != lastKeyTurnerState.lockState) && keyTurnerState.lockState != NukiLock::LockState::Undefined)
     {
         memset(&str, 0, sizeof(str));
         lockstateToString(keyTurnerState.lockState, str);
-        publishString(mqtt_topic_lock_state, str);
+        _stateBatch.addString(_topics.get(MqttTopic::LockState), str);
 
-        if(_haEnabled)
+        const char* binaryStateStr = binaryState(keyTurnerState.lockState);
+        if(_haEnabled && binaryStateStr != nullptr)
         {
-            publishBinaryState(keyTurnerState.lockState);
+            _stateBatch.addString(_topics.get(MqttTopic::LockBinaryState), binaryStateStr);
         }
     }
 
@@ -226,73 +290,101 @@ void NetworkLock::publishKeyTurnerState(const NukiLock::KeyTurnerState& keyTurne
     {
         memset(&str, 0, sizeof(str));
         triggerToString(keyTurnerState.trigger, str);
-        publishString(mqtt_topic_lock_trigger, str);
+        _stateBatch.addString(_topics.get(MqttTopic::LockTrigger), str);
     }
 
     if(_firstTunerStatePublish || keyTurnerState.lastLockAction != lastKeyTurnerState.lastLockAction)
     {
         memset(&str, 0, sizeof(str));
         lockactionToString(keyTurnerState.lastLockAction, str);
-        publishString(mqtt_topic_lock_last_lock_action, str);
+        _stateBatch.addString(_topics.get(MqttTopic::LockLastLockAction), str);
     }
 
     if(_firstTunerStatePublish || keyTurnerState.lastLockActionCompletionStatus != lastKeyTurnerState.lastLockActionCompletionStatus)
     {
         memset(&str, 0, sizeof(str));
         NukiLock::completionStatusToString(keyTurnerState.lastLockActionCompletionStatus, str);
-        publishString(mqtt_topic_lock_completionStatus, str);
+        _stateBatch.addString(_topics.get(MqttTopic::LockCompletionStatus), str);
     }
 
     if(_firstTunerStatePublish || keyTurnerState.doorSensorState != lastKeyTurnerState.doorSensorState)
     {
         memset(&str, 0, sizeof(str));
         NukiLock::doorSensorStateToString(keyTurnerState.doorSensorState, str);
-        publishString(mqtt_topic_lock_door_sensor_state, str);
+        _stateBatch.addString(_topics.get(MqttTopic::LockDoorSensorState), str);
     }
 
+    bool critical = (keyTurnerState.criticalBatteryState & 0b00000001) > 0;
+    bool charging = (keyTurnerState.criticalBatteryState & 0b00000010) > 0;
+    uint8_t level = (keyTurnerState.criticalBatteryState & 0b11111100) >> 1;
+    bool keypadCritical = (keyTurnerState.accessoryBatteryState & (1 << 7)) != 0 ? (keyTurnerState.accessoryBatteryState & (1 << 6)) != 0 : false;
+
     if(_firstTunerStatePublish || keyTurnerState.criticalBatteryState != lastKeyTurnerState.criticalBatteryState)
     {
-        bool critical = (keyTurnerState.criticalBatteryState & 0b00000001) > 0;
-        publishBool(mqtt_topic_battery_critical, critical);
-
-        bool charging = (keyTurnerState.criticalBatteryState & 0b00000010) > 0;
-        publishBool(mqtt_topic_battery_charging, charging);
-
-        uint8_t level = (keyTurnerState.criticalBatteryState & 0b11111100) >> 1;
-        publishInt(mqtt_topic_battery_level, level);
+        _stateBatch.addBool(_topics.get(MqttTopic::BatteryCritical), critical);
+        _stateBatch.addBool(_topics.get(MqttTopic::BatteryCharging), charging);
+        _stateBatch.addInt(_topics.get(MqttTopic::BatteryLevel), level);
     }
 
     if(_firstTunerStatePublish || keyTurnerState.accessoryBatteryState != lastKeyTurnerState.accessoryBatteryState)
     {
-        if ((keyTurnerState.accessoryBatteryState & (1 << 7)) != 0) {
-            publishBool(mqtt_topic_battery_keypad_critical, (keyTurnerState.accessoryBatteryState & (1 << 6)) != 0);
-        }
-        else
-        {
-            publishBool(mqtt_topic_battery_keypad_critical, false);
-        }
+        _stateBatch.addBool(_topics.get(MqttTopic::BatteryKeypadCritical), keypadCritical);
+    }
+
+    if(_publishJson && _stateBatch.size() > 0)
+    {
+        DynamicJsonDocument json(LOCK_STATE_JSON_BUFFER_SIZE);
+
+        memset(&str, 0, sizeof(str));
+        lockstateToString(keyTurnerState.lockState, str);
+        json["lock_state"] = str;
+
+        memset(&str, 0, sizeof(str));
+        triggerToString(keyTurnerState.trigger, str);
+        json["trigger"] = str;
+
+        memset(&str, 0, sizeof(str));
+        lockactionToString(keyTurnerState.lastLockAction, str);
+        json["last_lock_action"] = str;
+
+        memset(&str, 0, sizeof(str));
+        NukiLock::completionStatusToString(keyTurnerState.lastLockActionCompletionStatus, str);
+        json["completion_status"] = str;
+
+        memset(&str, 0, sizeof(str));
+        NukiLock::doorSensorStateToString(keyTurnerState.doorSensorState, str);
+        json["door_sensor_state"] = str;
+
+        json["battery_critical"] = critical;
+        json["battery_charging"] = charging;
+        json["battery_level"] = level;
+        json["keypad_battery_critical"] = keypadCritical;
+
+        ScratchBuffer buffer;
+        serializeJson(json, buffer.data(), buffer.size());
+        _stateBatch.addString(_topics.get(MqttTopic::LockJson), buffer.data());
     }
 
+    _network->publishBatch(_stateBatch);
+
     _firstTunerStatePublish = false;
 }
 
-void NetworkLock::publishBinaryState(NukiLock::LockState lockState)
+const char* NetworkLock::binaryState(NukiLock::LockState lockState)
 {
     switch(lockState)
     {
         case NukiLock::LockState::Locked:
         case NukiLock::LockState::Locking:
-            publishString(mqtt_topic_lock_binary_state, "locked");
-            break;
+            return "locked";
         case NukiLock::LockState::Unlocked:
         case NukiLock::LockState::Unlocking:
         case NukiLock::LockState::Unlatched:
         case NukiLock::LockState::Unlatching:
         case NukiLock::LockState::UnlockedLnga:
-            publishString(mqtt_topic_lock_binary_state, "unlocked");
-            break;
+            return "unlocked";
         default:
-            break;
+            return nullptr;
     }
 }
 
@@ -305,7 +397,7 @@ void NetworkLock::publishAuthorizationInfo(const std::list<NukiLock::LogEntry>&
     char authName[33];
     memset(authName, 0, sizeof(authName));
 
-    DynamicJsonDocument json(_bufferSize);
+    DynamicJsonDocument json(SCRATCH_BUFFER_SIZE);
 
     for(const auto& log : logEntries)
     {
@@ -383,80 +475,106 @@ void NetworkLock::publishAuthorizationInfo(const std::list<NukiLock::LogEntry>&
         }
     }
 
-    serializeJson(json, _buffer, _bufferSize);
-    publishString(mqtt_topic_lock_log, _buffer);
+    ScratchBuffer buffer;
+    serializeJson(json, buffer.data(), buffer.size());
+    publishString(MqttTopic::LockLog, buffer.data());
 
     if(authFound)
     {
-        publishUInt(mqtt_topic_lock_auth_id, authId);
-        publishString(mqtt_topic_lock_auth_name, authName);
+        publishUInt(MqttTopic::LockAuthId, authId);
+        publishString(MqttTopic::LockAuthName, authName);
     }
 }
 
 void NetworkLock::clearAuthorizationInfo()
 {
-    publishString(mqtt_topic_lock_log, "--");
-    publishUInt(mqtt_topic_lock_auth_id, 0);
-    publishString(mqtt_topic_lock_auth_name, "--");}
+    publishString(MqttTopic::LockLog, "--");
+    publishUInt(MqttTopic::LockAuthId, 0);
+    publishString(MqttTopic::LockAuthName, "--");}
+
+void NetworkLock::publishCommandId(const uint32_t& commandId)
+{
+    publishUInt(MqttTopic::LockCommandId, commandId);
+}
+
+void NetworkLock::publishCommandResult(const char *resultStr, const uint32_t& commandId)
+{
+    publishString(MqttTopic::LockActionCommandResult, resultStr);
+    if(commandId != 0)
+    {
+        publishCommandResultJson(commandId, "lockAction", resultStr);
+    }
+}
 
-void NetworkLock::publishCommandResult(const char *resultStr)
+void NetworkLock::publishConfigCommandResult(const char* resultStr, const uint32_t& commandId)
 {
-    publishString(mqtt_topic_lock_action_command_result, resultStr);
+    publishCommandResultJson(commandId, "config", resultStr);
 }
 
 void NetworkLock::publishLockstateCommandResult(const char *resultStr)
 {
-    publishString(mqtt_topic_query_lockstate_command_result, resultStr);
+    publishString(MqttTopic::QueryLockstateCommandResult, resultStr);
 }
 
 void NetworkLock::publishBatteryReport(const NukiLock::BatteryReport& batteryReport)
 {
-    publishFloat(mqtt_topic_battery_voltage, (float)batteryReport.batteryVoltage / 1000.0);
-    publishInt(mqtt_topic_battery_drain, batteryReport.batteryDrain); // milliwatt seconds
-    publishFloat(mqtt_topic_battery_max_turn_current, (float)batteryReport.maxTurnCurrent / 1000.0);
-    publishInt(mqtt_topic_battery_lock_distance, batteryReport.lockDistance); // degrees
+    publishFloat(MqttTopic::BatteryVoltage, (float)batteryReport.batteryVoltage / 1000.0);
+    publishInt(MqttTopic::BatteryDrain, batteryReport.batteryDrain); // milliwatt seconds
+    publishFloat(MqttTopic::BatteryMaxTurnCurrent, (float)batteryReport.maxTurnCurrent / 1000.0);
+    publishInt(MqttTopic::BatteryLockDistance, batteryReport.lockDistance); // degrees
 }
 
 void NetworkLock::publishConfig(const NukiLock::Config &config)
 {
-    publishBool(mqtt_topic_config_button_enabled, config.buttonEnabled == 1);
-    publishBool(mqtt_topic_config_led_enabled, config.ledEnabled == 1);
-    publishInt(mqtt_topic_config_led_brightness, config.ledBrightness);
-    publishBool(mqtt_topic_config_single_lock, config.singleLock == 1);
-    publishString(mqtt_topic_info_firmware_version, std::to_string(config.firmwareVersion[0]) + "." + std::to_string(config.firmwareVersion[1]) + "." + std::to_string(config.firmwareVersion[2]));
-    publishString(mqtt_topic_info_hardware_version, std::to_string(config.hardwareRevision[0]) + "." + std::to_string(config.hardwareRevision[1]));
+    publishBool(MqttTopic::ConfigButtonEnabled, config.buttonEnabled == 1);
+    publishBool(MqttTopic::ConfigLedEnabled, config.ledEnabled == 1);
+    publishInt(MqttTopic::ConfigLedBrightness, config.ledBrightness);
+    publishBool(MqttTopic::ConfigSingleLock, config.singleLock == 1);
+    publishString(MqttTopic::InfoFirmwareVersion, std::to_string(config.firmwareVersion[0]) + "." + std::to_string(config.firmwareVersion[1]) + "." + std::to_string(config.firmwareVersion[2]));
+    publishString(MqttTopic::InfoHardwareVersion, std::to_string(config.hardwareRevision[0]) + "." + std::to_string(config.hardwareRevision[1]));
 }
 
 void NetworkLock::publishAdvancedConfig(const NukiLock::AdvancedConfig &config)
 {
-    publishBool(mqtt_topic_config_auto_unlock, config.autoUnLockDisabled == 0);
-    publishBool(mqtt_topic_config_auto_lock, config.autoLockEnabled == 1);
+    publishBool(MqttTopic::ConfigAutoUnlock, config.autoUnLockDisabled == 0);
+    publishBool(MqttTopic::ConfigAutoLock, config.autoLockEnabled == 1);
 }
 
 void NetworkLock::publishRssi(const int& rssi)
 {
-    publishInt(mqtt_topic_lock_rssi, rssi);
+    publishInt(MqttTopic::LockRssi, rssi);
 }
 
 void NetworkLock::publishRetry(const std::string& message)
 {
-    publishString(mqtt_topic_lock_retry, message);
+    publishString(MqttTopic::LockRetry, message);
 }
 
 void NetworkLock::publishBleAddress(const std::string &address)
 {
-    publishString(mqtt_topic_lock_address, address);
+    publishString(MqttTopic::LockAddress, address);
 }
 
-void NetworkLock::publishKeypad(const std::list<NukiLock::KeypadEntry>& entries, uint maxKeypadCodeCount)
+bool NetworkLock::publishKeypad(const std::list<NukiLock::KeypadEntry>& entries, uint maxKeypadCodeCount)
 {
+    if(_keypadResync)
+    {
+        _keypadCache.clear();
+        _keypadResync = false;
+    }
+
+    bool changed = false;
     uint index = 0;
     for(const auto& entry : entries)
     {
-        String basePath = mqtt_topic_keypad;
-        basePath.concat("/code_");
-        basePath.concat(std::to_string(index).c_str());
-        publishKeypadEntry(basePath, entry);
+        if(_keypadCache.update(index, entry))
+        {
+            String basePath = mqtt_topic_keypad;
+            basePath.concat("/code_");
+            basePath.concat(std::to_string(index).c_str());
+            publishKeypadEntry(basePath, entry);
+            changed = true;
+        }
 
         ++index;
     }
@@ -464,18 +582,65 @@ void NetworkLock::publishKeypad(const std::list<NukiLock::KeypadEntry>& entries,
     {
         NukiLock::KeypadEntry entry;
         memset(&entry, 0, sizeof(entry));
-        String basePath = mqtt_topic_keypad;
-        basePath.concat("/code_");
-        basePath.concat(std::to_string(index).c_str());
-        publishKeypadEntry(basePath, entry);
+        if(_keypadCache.update(index, entry))
+        {
+            String basePath = mqtt_topic_keypad;
+            basePath.concat("/code_");
+            basePath.concat(std::to_string(index).c_str());
+            publishKeypadEntry(basePath, entry);
+            changed = true;
+        }
 
         ++index;
     }
+
+    if(changed)
+    {
+        publishUInt(MqttTopic::KeypadRevision, _keypadCache.revision());
+    }
+    return changed;
 }
 
-void NetworkLock::publishKeypadCommandResult(const char* result)
+void NetworkLock::publishKeypadCommandResult(const char* result, const uint32_t& commandId)
 {
-    publishString(mqtt_topic_keypad_command_result, result);
+    publishString(MqttTopic::KeypadCommandResult, result);
+    if(commandId != 0)
+    {
+        publishCommandResultJson(commandId, "keypad", result);
+    }
+}
+
+void NetworkLock::publishKeypadJsonCommandResult(const char* result, const uint32_t& commandId, const NukiKeypadBatch* batch)
+{
+    ScratchBuffer buffer;
+    JsonWriter json(buffer.data(), buffer.size());
+    json.beginObject();
+    json.addInt("id", commandId);
+    json.add("result", result);
+    if(batch != nullptr)
+    {
+        batch->writeEntries(json);
+    }
+    json.endObject();
+
+    if(!json.ok())
+    {
+        Log->println(F("Keypad command result exceeds buffer size."));
+        return;
+    }
+    publishString(MqttTopic::KeypadJsonCommandResult, buffer.data());
+}
+
+void NetworkLock::publishCommandResultJson(const uint32_t& commandId, const char* commandType, const char* result)
+{
+    StaticJsonDocument<128> json;
+    json["id"] = commandId;
+    json["command"] = commandType;
+    json["result"] = result;
+
+    char str[128];
+    serializeJson(json, str, sizeof(str));
+    publishString(MqttTopic::LockCommandResultJson, str);
 }
 
 void NetworkLock::setLockActionReceivedCallback(LockActionResult (*lockActionReceivedCallback)(const char *))
@@ -493,76 +658,139 @@ void NetworkLock::setKeypadCommandReceivedCallback(void (*keypadCommandReceivedR
     _keypadCommandReceivedReceivedCallback = keypadCommandReceivedReceivedCallback;
 }
 
-void NetworkLock::buildMqttPath(const char* path, char* outPath)
-{
-    int offset = 0;
-    for(const char& c : _mqttPath)
-    {
-        if(c == 0x00)
-        {
-            break;
-        }
-        outPath[offset] = c;
-        ++offset;
-    }
-    int i=0;
-    while(outPath[i] != 0x00)
-    {
-        outPath[offset] = path[i];
-        ++i;
-        ++offset;
-    }
-    outPath[i+1] = 0x00;
-}
-
-bool NetworkLock::comparePrefixedPath(const char *fullPath, const char *subPath)
+void NetworkLock::setKeypadJsonCommandReceivedCallback(void (*keypadJsonCommandReceivedCallback)(char* json))
 {
-    char prefixedPath[500];
-    buildMqttPath(subPath, prefixedPath);
-    return strcmp(fullPath, prefixedPath) == 0;
+    _keypadJsonCommandReceivedCallback = keypadJsonCommandReceivedCallback;
 }
 
 void NetworkLock::publishHASSConfig(char *deviceType, const char *baseTopic, char *name, char *uidString, const bool& hasDoorSensor, const bool& hasKeypad, const bool& publishAuthData, char *lockAction,
                                char *unlockAction, char *openAction, char *lockedState, char *unlockedState)
 {
-    _network->publishHASSConfig(deviceType, baseTopic, name, uidString, hasKeypad, lockAction, unlockAction, openAction, lockedState, unlockedState);
-    _network->publishHASSConfigBatLevel(deviceType, baseTopic, name, uidString);
-    _network->publishHASSConfigLedBrightness(deviceType, baseTopic, name, uidString);
+    if(!_network->hassDiscoveryEnabled())
+    {
+        return;
+    }
+
+    if(_brokerStateLost)
+    {
+        // The persisted hashes only hold while the broker keeps the retained configs, publish all of them again
+        _hassDiscovery.clearHashes();
+        _brokerStateLost = false;
+    }
+
+    _hassDiscovery.begin(deviceType, baseTopic, name, uidString, lockAction, unlockAction, openAction, lockedState, unlockedState);
+    _hassDiscovery.addPublish(hassBatteryLow);
+    if(hasKeypad)
+    {
+        _hassDiscovery.addPublish(hassKeypadBatteryLow);
+    }
+    else
+    {
+        _hassDiscovery.addRemove(hassKeypadBatteryLow);
+    }
+    _hassDiscovery.addPublish(hassBatteryVoltage);
+    _hassDiscovery.addPublish(hassTrigger);
+    _hassDiscovery.addPublish(hassMqttConnected);
+    _hassDiscovery.addPublish(hassReset);
+    _hassDiscovery.addPublish(hassFirmwareVersion);
+    _hassDiscovery.addPublish(hassHardwareVersion);
+    _hassDiscovery.addPublish(hassNukiHubVersion);
+    _hassDiscovery.addPublish(hassLedEnabled);
+    _hassDiscovery.addPublish(hassButtonEnabled);
+    _hassDiscovery.addPublish(hassBatteryLevel);
+    _hassDiscovery.addPublish(hassLedBrightness);
     if(hasDoorSensor)
     {
-        _network->publishHASSConfigDoorSensor(deviceType, baseTopic, name, uidString, lockAction, unlockAction, openAction, lockedState, unlockedState);
+        _hassDiscovery.addPublish(hassDoorSensor);
     }
     else
     {
-        _network->removeHASSConfigTopic("binary_sensor", "door_sensor", uidString);
+        _hassDiscovery.addRemove(hassDoorSensor);
     }
-    _network->publishHASSWifiRssiConfig(deviceType, baseTopic, name, uidString);
-    _network->publishHASSBleRssiConfig(deviceType, baseTopic, name, uidString);
-
+    if(_network->device()->signalStrength() != 127)
+    {
+        _hassDiscovery.addPublish(hassWifiSignalStrength);
+    }
+    _hassDiscovery.addPublish(hassBleSignalStrength);
     if(publishAuthData)
     {
-        _network->publishHASSConfigAccessLog(deviceType, baseTopic, name, uidString);
+        _hassDiscovery.addPublish(hassAccessLog);
     }
     else
     {
-        _network->removeHASSConfigTopic("sensor", "last_action_authorization", uidString);
+        _hassDiscovery.addRemove(hassAccessLog);
     }
-
     if(hasKeypad)
     {
-        _network->publishHASSConfigKeypadAttemptInfo(deviceType, baseTopic, name, uidString);
+        _hassDiscovery.addPublish(hassKeypadAttemptInfo);
     }
     else
     {
-        _network->removeHASSConfigTopic("sensor", "keypad_status", uidString);
+        _hassDiscovery.addRemove(hassKeypadAttemptInfo);
     }
 }
 
+void NetworkLock::updateHASSConfig()
+{
+    _hassDiscovery.update();
+}
+
+bool NetworkLock::hassConfigPending() const
+{
+    return _hassDiscovery.pending();
+}
+
+unsigned long NetworkLock::hassConfigNextUpdateTs() const
+{
+    return _hassDiscovery.nextUpdateTs();
+}
+
 void NetworkLock::removeHASSConfig(char *uidString)
 {
+    _hassDiscovery.clearHashes();
     _network->removeHASSConfig(uidString);
 }
 
+void NetworkLock::publishFloat(const MqttTopic& topic, const float value, const uint8_t precision)
+{
+    _network->publishFloat(_topics.get(topic), value, precision);
+}
+
+void NetworkLock::publishInt(const MqttTopic& topic, const int value)
+{
+    _network->publishInt(_topics.get(topic), value);
+}
+
+void NetworkLock::publishUInt(const MqttTopic& topic, const unsigned int value)
+{
+    _network->publishUInt(_topics.get(topic), value);
+}
+
+void NetworkLock::publishULong(const MqttTopic& topic, const unsigned long value)
+{
+    _network->publishULong(_topics.get(topic), value);
+}
+
+void NetworkLock::publishBool(const MqttTopic& topic, const bool value)
+{
+    _network->publishBool(_topics.get(topic), value);
+}
+
+bool NetworkLock::publishString(const MqttTopic& topic, const String& value)
+{
+    return _network->publishString(_topics.get(topic), value.c_str());
+}
+
+bool NetworkLock::publishString(const MqttTopic& topic, const std::string& value)
+{
+    return _network->publishString(_topics.get(topic), value.c_str());
+}
+
+bool NetworkLock::publishString(const MqttTopic& topic, const char* value)
+{
+    return _network->publishString(_topics.get(topic), value);
+}
+
 void NetworkLock::publishFloat(const char *topic, const float value, const uint8_t precision)
 {
     _network->publishFloat(_mqttPath, topic, value, precision);
@@ -647,3 +875,8 @@ uint8_t NetworkLock::queryCommands()
     _queryCommands = 0;
     return qc;
 }
+
+uint8_t NetworkLock::pendingQueryCommands() const
+{
+    return _queryCommands;
+}
@@ -11,22 +11,29 @@
 #include "Network.h"
 #include "QueryCommand.h"
 #include "LockActionResult.h"
+#include "MqttTopicTable.h"
+#include "MqttPublishBatch.h"
+#include "HassDiscovery.h"
+#include "NukiKeypadBatch.h"
+#include "KeypadPublishCache.h"
 
 #define LOCK_LOG_JSON_BUFFER_SIZE 2048
+#define LOCK_STATE_JSON_BUFFER_SIZE 512
 
 class NetworkLock : public MqttReceiver
 {
 public:
-    explicit NetworkLock(Network* network, Preferences* preferences, char* buffer, size_t bufferSize);
+    explicit NetworkLock(Network* network, Preferences* preferences);
     virtual ~NetworkLock();
 
     void initialize();
 
     void publishKeyTurnerState(const NukiLock::KeyTurnerState& keyTurnerState, const NukiLock::KeyTurnerState& lastKeyTurnerState);
-    void publishBinaryState(NukiLock::LockState lockState);
     void publishAuthorizationInfo(const std::list<NukiLock::LogEntry>& logEntries);
     void clearAuthorizationInfo();
-    void publishCommandResult(const char* resultStr);
+    void publishCommandId(const uint32_t& commandId);
+    void publishCommandResult(const char* resultStr, const uint32_t& commandId = 0);
+    void publishConfigCommandResult(const char* resultStr, const uint32_t& commandId);
     void publishLockstateCommandResult(const char* resultStr);
     void publishBatteryReport(const NukiLock::BatteryReport& batteryReport);
     void publishConfig(const NukiLock::Config& config);
@@ -35,22 +42,38 @@ public:
     void publishRetry(const std::string& message);
     void publishBleAddress(const std::string& address);
     void publishHASSConfig(char* deviceType, const char* baseTopic, char* name, char* uidString, const bool& hasDoorSensor, const bool& hasKeypad, const bool& publishAuthData, char* lockAction, char* unlockAction, char* openAction, char* lockedState, char* unlockedState);
+    void updateHASSConfig();
+    bool hassConfigPending() const;
+    unsigned long hassConfigNextUpdateTs() const;
     void removeHASSConfig(char* uidString);
-    void publishKeypad(const std::list<NukiLock::KeypadEntry>& entries, uint maxKeypadCodeCount);
-    void publishKeypadCommandResult(const char* result);
+    bool publishKeypad(const std::list<NukiLock::KeypadEntry>& entries, uint maxKeypadCodeCount); // true if any code changed
+    void publishKeypadCommandResult(const char* result, const uint32_t& commandId = 0);
+    void publishKeypadJsonCommandResult(const char* result, const uint32_t& commandId = 0, const NukiKeypadBatch* batch = nullptr);
 
     void setLockActionReceivedCallback(LockActionResult (*lockActionReceivedCallback)(const char* value));
     void setConfigUpdateReceivedCallback(void (*configUpdateReceivedCallback)(const char* path, const char* value));
     void setKeypadCommandReceivedCallback(void (*keypadCommandReceivedReceivedCallback)(const char* command, const uint& id, const String& name, const String& code, const int& enabled));
+    void setKeypadJsonCommandReceivedCallback(void (*keypadJsonCommandReceivedCallback)(char* json));
 
-    void onMqttDataReceived(const char* topic, byte* payload, const unsigned int length) override;
+    void onMqttDataReceived(const MqttTopic& topic, byte* payload, const unsigned int length) override;
 
     bool reconnected();
     uint8_t queryCommands();
+    uint8_t pendingQueryCommands() const; // like queryCommands(), without clearing them
 
 private:
-    bool comparePrefixedPath(const char* fullPath, const char* subPath);
-
+    const char* binaryState(NukiLock::LockState lockState);
+
+    void publishFloat(const MqttTopic& topic, const float value, const uint8_t precision = 2);
+    void publishInt(const MqttTopic& topic, const int value);
+    void publishUInt(const MqttTopic& topic, const unsigned int value);
+    void publishULong(const MqttTopic& topic, const unsigned long value);
+    void publishBool(const MqttTopic& topic, const bool value);
+    bool publishString(const MqttTopic& topic, const String& value);
+    bool publishString(const MqttTopic& topic, const std::string& value);
+    bool publishString(const MqttTopic& topic, const char* value);
+
+    // Dynamic sub paths (keypad codes), prefixed on every call
     void publishFloat(const char* topic, const float value, const uint8_t precision = 2);
     void publishInt(const char* topic, const int value);
     void publishUInt(const char* topic, const unsigned int value);
@@ -63,18 +86,27 @@ private:
 
     String concat(String a, String b);
 
-    void buildMqttPath(const char* path, char* outPath);
+    void publishCommandResultJson(const uint32_t& commandId, const char* commandType, const char* result);
 
     Network* _network;
     Preferences* _preferences;
+    HassDiscovery _hassDiscovery;
 
-    std::vector<char*> _configTopics;
+    std::vector<MqttTopic> _configTopics;
     char _mqttPath[181] = {0};
 
     bool _firstTunerStatePublish = true;
     unsigned long _lastMaintenanceTs = 0;
     bool _haEnabled= false;
+    bool _publishJson = false;
+
+    MqttTopicTable _topics;
+    MqttPublishBatch _stateBatch;
+
     bool _reconnected = false;
+    bool _brokerStateLost = false; // the broker reported no session, its retained HASS configs may be gone
+    bool _keypadResync = false; // set on reconnect, the broker may have lost the retained codes
+    KeypadPublishCache _keypadCache;
 
     String _keypadCommandName = "";
     String _keypadCommandCode = "";
@@ -82,10 +114,8 @@ private:
     int _keypadCommandEnabled = 1;
     uint8_t _queryCommands = 0;
 
-    char* _buffer;
-    size_t _bufferSize;
-
     LockActionResult (*_lockActionReceivedCallback)(const char* value) = nullptr;
     void (*_configUpdateReceivedCallback)(const char* path, const char* value) = nullptr;
     void (*_keypadCommandReceivedReceivedCallback)(const char* command, const uint& id, const String& name, const String& code, const int& enabled) = nullptr;
+    void (*_keypadJsonCommandReceivedCallback)(char* json) = nullptr;
 };
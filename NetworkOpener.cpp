@@ -3,21 +3,20 @@
 #include "MqttTopics.h"
 #include "PreferencesKeys.h"
 #include "Logger.h"
+#include "NukiTask.h"
 #include "Config.h"
 #include <ArduinoJson.h>
+#include "ScratchBuffer.h"
 
-NetworkOpener::NetworkOpener(Network* network, Preferences* preferences, char* buffer, size_t bufferSize)
+NetworkOpener::NetworkOpener(Network* network, Preferences* preferences)
         : _preferences(preferences),
           _network(network),
-          _buffer(buffer),
-          _bufferSize(bufferSize)
+          _hassDiscovery(network, preferences, preference_hass_hashes_opener)
 {
     _configTopics.reserve(5);
-    _configTopics.push_back(mqtt_topic_config_button_enabled);
-    _configTopics.push_back(mqtt_topic_config_led_enabled);
-    _configTopics.push_back(mqtt_topic_config_sound_level);
-
-    _network->registerMqttReceiver(this);
+    _configTopics.push_back(MqttTopic::ConfigButtonEnabled);
+    _configTopics.push_back(MqttTopic::ConfigLedEnabled);
+    _configTopics.push_back(MqttTopic::ConfigSoundLevel);
 }
 
 void NetworkOpener::initialize()
@@ -38,40 +37,64 @@ void NetworkOpener::initialize()
     }
 
     _haEnabled = _preferences->getString(preference_mqtt_hass_discovery) != "";
-
-    _network->initTopic(_mqttPath, mqtt_topic_lock_action, "--");
-    _network->subscribe(_mqttPath, mqtt_topic_lock_action);
+    _publishJson = _preferences->getBool(preference_publish_json_state);
+
+    _topics.initialize(_mqttPath, {
+        MqttTopic::ConfigButtonEnabled, MqttTopic::ConfigLedEnabled, MqttTopic::ConfigSoundLevel, MqttTopic::LockState,
+        MqttTopic::LockBinaryState, MqttTopic::LockTrigger, MqttTopic::LockCompletionStatus,
+        MqttTopic::LockDoorSensorState, MqttTopic::BatteryCritical, MqttTopic::LockJson, MqttTopic::LockAction,
+        MqttTopic::QueryConfig, MqttTopic::QueryLockstate, MqttTopic::QueryBattery, MqttTopic::KeypadCommandAction,
+        MqttTopic::KeypadCommandId, MqttTopic::KeypadCommandName, MqttTopic::KeypadCommandCode,
+        MqttTopic::KeypadCommandEnabled, MqttTopic::QueryKeypad, MqttTopic::LockLog, MqttTopic::LockAuthId,
+        MqttTopic::LockAuthName, MqttTopic::LockCommandId, MqttTopic::LockActionCommandResult,
+        MqttTopic::QueryLockstateCommandResult, MqttTopic::BatteryVoltage, MqttTopic::InfoFirmwareVersion,
+        MqttTopic::InfoHardwareVersion, MqttTopic::LockRssi, MqttTopic::LockRetry, MqttTopic::LockAddress,
+        MqttTopic::KeypadCommandResult, MqttTopic::KeypadJsonCommand,
+        MqttTopic::KeypadJsonCommandResult, MqttTopic::KeypadRevision,
+        MqttTopic::LockCommandResultJson
+    });
+
+    _network->initTopic(_topics.get(MqttTopic::LockAction), "--");
+    _network->subscribe(this, _topics, MqttTopic::LockAction);
     for(const auto& topic : _configTopics)
     {
-        _network->subscribe(_mqttPath, topic);
+        _network->subscribe(this, _topics, topic);
     }
 
-    _network->initTopic(_mqttPath, mqtt_topic_query_config, "0");
-    _network->initTopic(_mqttPath, mqtt_topic_query_lockstate, "0");
-    _network->initTopic(_mqttPath, mqtt_topic_query_battery, "0");
-    _network->subscribe(_mqttPath, mqtt_topic_query_config);
-    _network->subscribe(_mqttPath, mqtt_topic_query_lockstate);
-    _network->subscribe(_mqttPath, mqtt_topic_query_battery);
+    _network->initTopic(_topics.get(MqttTopic::QueryConfig), "0");
+    _network->initTopic(_topics.get(MqttTopic::QueryLockstate), "0");
+    _network->initTopic(_topics.get(MqttTopic::QueryBattery), "0");
+    _network->subscribe(this, _topics, MqttTopic::QueryConfig);
+    _network->subscribe(this, _topics, MqttTopic::QueryLockstate);
+    _network->subscribe(this, _topics, MqttTopic::QueryBattery);
 
     if(_preferences->getBool(preference_keypad_control_enabled))
     {
-        _network->subscribe(_mqttPath, mqtt_topic_keypad_command_action);
-        _network->subscribe(_mqttPath, mqtt_topic_keypad_command_id);
-        _network->subscribe(_mqttPath, mqtt_topic_keypad_command_name);
-        _network->subscribe(_mqttPath, mqtt_topic_keypad_command_code);
-        _network->subscribe(_mqttPath, mqtt_topic_keypad_command_enabled);
-        _network->subscribe(_mqttPath, mqtt_topic_query_keypad);
-        _network->initTopic(_mqttPath, mqtt_topic_keypad_command_action, "--");
-        _network->initTopic(_mqttPath, mqtt_topic_keypad_command_id, "0");
-        _network->initTopic(_mqttPath, mqtt_topic_keypad_command_name, "--");
-        _network->initTopic(_mqttPath, mqtt_topic_keypad_command_code, "000000");
-        _network->initTopic(_mqttPath, mqtt_topic_keypad_command_enabled, "1");
-        _network->initTopic(_mqttPath, mqtt_topic_query_keypad, "0");
+        _network->subscribe(this, _topics, MqttTopic::KeypadCommandAction);
+        _network->subscribe(this, _topics, MqttTopic::KeypadCommandId);
+        _network->subscribe(this, _topics, MqttTopic::KeypadCommandName);
+        _network->subscribe(this, _topics, MqttTopic::KeypadCommandCode);
+        _network->subscribe(this, _topics, MqttTopic::KeypadCommandEnabled);
+        _network->subscribe(this, _topics, MqttTopic::KeypadJsonCommand);
+        _network->subscribe(this, _topics, MqttTopic::QueryKeypad);
+        _network->initTopic(_topics.get(MqttTopic::KeypadCommandAction), "--");
+        _network->initTopic(_topics.get(MqttTopic::KeypadCommandId), "0");
+        _network->initTopic(_topics.get(MqttTopic::KeypadCommandName), "--");
+        _network->initTopic(_topics.get(MqttTopic::KeypadCommandCode), "000000");
+        _network->initTopic(_topics.get(MqttTopic::KeypadCommandEnabled), "1");
+        _network->initTopic(_topics.get(MqttTopic::KeypadJsonCommand), "--");
+        _network->initTopic(_topics.get(MqttTopic::QueryKeypad), "0");
     }
 
     _network->addReconnectedCallback([&]()
      {
          _reconnected = true;
+         _keypadResync = true;
+         if(!_network->mqttSessionPresent())
+         {
+             _brokerStateLost = true;
+         }
+         wakeNukiTask();
      });
 }
 
@@ -83,117 +106,148 @@ void NetworkOpener::update()
         memset(str, 0, sizeof(str));
         _resetLockStateTs = 0;
         lockstateToString(NukiOpener::LockState::Locked, str);
-        publishString(mqtt_topic_lock_state, str);
+        publishString(MqttTopic::LockState, str);
     }
 }
 
-void NetworkOpener::onMqttDataReceived(const char* topic, byte* payload, const unsigned int length)
+void NetworkOpener::onMqttDataReceived(const MqttTopic& topic, byte* payload, const unsigned int length)
 {
     char* value = (char*)payload;
 
-    if(comparePrefixedPath(topic, mqtt_topic_lock_action))
+    switch(topic)
     {
-        if(strcmp(value, "") == 0 ||
-           strcmp(value, "--") == 0 ||
-           strcmp(value, "ack") == 0 ||
-           strcmp(value, "unknown_action") == 0 ||
-           strcmp(value, "denied") == 0 ||
-           strcmp(value, "error") == 0) return;
-
-        Log->print(F("Lock action received: "));
-        Log->println(value);
-        LockActionResult lockActionResult = LockActionResult::Failed;
-        if(_lockActionReceivedCallback != NULL)
+        case MqttTopic::LockAction:
         {
-            lockActionResult = _lockActionReceivedCallback(value);
-        }
-
-        switch(lockActionResult)
-        {
-            case LockActionResult::Success:
-                publishString(mqtt_topic_lock_action, "ack");
-                break;
-            case LockActionResult::UnknownAction:
-                publishString(mqtt_topic_lock_action, "unknown_action");
-                break;
-            case LockActionResult::AccessDenied:
-                publishString(mqtt_topic_lock_action, "denied");
-                break;
-            case LockActionResult::Failed:
-                publishString(mqtt_topic_lock_action, "error");
+            if(strcmp(value, "") == 0 ||
+               strcmp(value, "--") == 0 ||
+               strcmp(value, "ack") == 0 ||
+               strcmp(value, "unknown_action") == 0 ||
+               strcmp(value, "denied") == 0 ||
+               strcmp(value, "error") == 0 ||
+               strcmp(value, "queue_full") == 0)
+            {
                 break;
+            }
+
+            Log->print(F("Lock action received: "));
+            Log->println(value);
+            LockActionResult lockActionResult = LockActionResult::Failed;
+            if(_lockActionReceivedCallback != NULL)
+            {
+                lockActionResult = _lockActionReceivedCallback(value);
+            }
+
+            switch(lockActionResult)
+            {
+                case LockActionResult::Success:
+                    publishString(MqttTopic::LockAction, "ack");
+                    break;
+                case LockActionResult::UnknownAction:
+                    publishString(MqttTopic::LockAction, "unknown_action");
+                    break;
+                case LockActionResult::AccessDenied:
+                    publishString(MqttTopic::LockAction, "denied");
+                    break;
+                case LockActionResult::Failed:
+                    publishString(MqttTopic::LockAction, "error");
+                    break;
+                case LockActionResult::QueueFull:
+                    publishString(MqttTopic::LockAction, "queue_full");
+                    break;
+            }
+            break;
         }
-    }
+        case MqttTopic::KeypadCommandAction:
+            if(_keypadCommandReceivedReceivedCallback != nullptr)
+            {
+                if(strcmp(value, "--") == 0)
+                {
+                    break;
+                }
 
-    if(comparePrefixedPath(topic, mqtt_topic_keypad_command_action))
-    {
-        if(_keypadCommandReceivedReceivedCallback != nullptr)
-        {
-            if(strcmp(value, "--") == 0) return;
+                _keypadCommandReceivedReceivedCallback(value, _keypadCommandId, _keypadCommandName, _keypadCommandCode, _keypadCommandEnabled);
 
-            _keypadCommandReceivedReceivedCallback(value, _keypadCommandId, _keypadCommandName, _keypadCommandCode, _keypadCommandEnabled);
+                _keypadCommandId = 0;
+                _keypadCommandName = "--";
+                _keypadCommandCode = "000000";
+                _keypadCommandEnabled = 1;
 
-            _keypadCommandId = 0;
-            _keypadCommandName = "--";
-            _keypadCommandCode = "000000";
-            _keypadCommandEnabled = 1;
+                if(strcmp(value, "--") != 0)
+                {
+                    publishString(MqttTopic::KeypadCommandAction, "--");
+                }
+                publishInt(MqttTopic::KeypadCommandId, _keypadCommandId);
+                publishString(MqttTopic::KeypadCommandName, _keypadCommandName);
+                publishString(MqttTopic::KeypadCommandCode, _keypadCommandCode);
+                publishInt(MqttTopic::KeypadCommandEnabled, _keypadCommandEnabled);
+            }
+            break;
+        case MqttTopic::KeypadCommandId:
+            _keypadCommandId = atoi(value);
+            break;
+        case MqttTopic::KeypadCommandName:
+            _keypadCommandName = value;
+            break;
+        case MqttTopic::KeypadCommandCode:
+            _keypadCommandCode = value;
+            break;
+        case MqttTopic::KeypadCommandEnabled:
+            _keypadCommandEnabled = atoi(value);
+            break;
+        case MqttTopic::KeypadJsonCommand:
+            if(_keypadJsonCommandReceivedCallback != nullptr)
+            {
+                if(strcmp(value, "") == 0 || strcmp(value, "--") == 0)
+                {
+                    break;
+                }
 
-            if(strcmp(value, "--") != 0)
+                _keypadJsonCommandReceivedCallback(value);
+                publishString(MqttTopic::KeypadJsonCommand, "--");
+            }
+            break;
+        case MqttTopic::QueryConfig:
+            if(strcmp(value, "1") == 0)
             {
-                publishString(mqtt_topic_keypad_command_action, "--");
+                _queryCommands = _queryCommands | QUERY_COMMAND_CONFIG;
+                wakeNukiTask();
+                publishString(MqttTopic::QueryConfig, "0");
             }
-            publishInt(mqtt_topic_keypad_command_id, _keypadCommandId);
-            publishString(mqtt_topic_keypad_command_name, _keypadCommandName);
-            publishString(mqtt_topic_keypad_command_code, _keypadCommandCode);
-            publishInt(mqtt_topic_keypad_command_enabled, _keypadCommandEnabled);
-        }
-    }
-    else if(comparePrefixedPath(topic, mqtt_topic_keypad_command_id))
-    {
-        _keypadCommandId = atoi(value);
-    }
-    else if(comparePrefixedPath(topic, mqtt_topic_keypad_command_name))
-    {
-        _keypadCommandName = value;
-    }
-    else if(comparePrefixedPath(topic, mqtt_topic_keypad_command_code))
-    {
-        _keypadCommandCode = value;
-    }
-    else if(comparePrefixedPath(topic, mqtt_topic_keypad_command_enabled))
-    {
-        _keypadCommandEnabled = atoi(value);
-    }
-    else if(comparePrefixedPath(topic, mqtt_topic_query_config) && strcmp(value, "1") == 0)
-    {
-        _queryCommands = _queryCommands | QUERY_COMMAND_CONFIG;
-        publishString(mqtt_topic_query_config, "0");
-    }
-    else if(comparePrefixedPath(topic, mqtt_topic_query_lockstate) && strcmp(value, "1") == 0)
-    {
-        _queryCommands = _queryCommands | QUERY_COMMAND_LOCKSTATE;
-        publishString(mqtt_topic_query_lockstate, "0");
-    }
-    else if(comparePrefixedPath(topic, mqtt_topic_query_keypad) && strcmp(value, "1") == 0)
-    {
-        _queryCommands = _queryCommands | QUERY_COMMAND_KEYPAD;
-        publishString(mqtt_topic_query_keypad, "0");
-    }
-    else if(comparePrefixedPath(topic, mqtt_topic_query_battery) && strcmp(value, "1") == 0)
-    {
-        _queryCommands = _queryCommands | QUERY_COMMAND_BATTERY;
-        publishString(mqtt_topic_query_battery, "0");
-    }
-
-    for(auto configTopic : _configTopics)
-    {
-        if(comparePrefixedPath(topic, configTopic))
-        {
+            break;
+        case MqttTopic::QueryLockstate:
+            if(strcmp(value, "1") == 0)
+            {
+                _queryCommands = _queryCommands | QUERY_COMMAND_LOCKSTATE;
+                wakeNukiTask();
+                publishString(MqttTopic::QueryLockstate, "0");
+            }
+            break;
+        case MqttTopic::QueryKeypad:
+            if(strcmp(value, "1") == 0)
+            {
+                _queryCommands = _queryCommands | QUERY_COMMAND_KEYPAD;
+                wakeNukiTask();
+                publishString(MqttTopic::QueryKeypad, "0");
+            }
+            break;
+        case MqttTopic::QueryBattery:
+            if(strcmp(value, "1") == 0)
+            {
+                _queryCommands = _queryCommands | QUERY_COMMAND_BATTERY;
+                wakeNukiTask();
+                publishString(MqttTopic::QueryBattery, "0");
+            }
+            break;
+        case MqttTopic::ConfigButtonEnabled:
+        case MqttTopic::ConfigLedEnabled:
+        case MqttTopic::ConfigSoundLevel:
             if(_configUpdateReceivedCallback != nullptr)
             {
-                _configUpdateReceivedCallback(configTopic, value);
+                _configUpdateReceivedCallback(MqttTopicTable::subPath(topic), value);
             }
-        }
+            break;
+        default:
+            break;
     }
 }
 
@@ -201,23 +255,18 @@ void NetworkOpener::publishKeyTurnerState(const NukiOpener::OpenerState& keyTurn
 {
     char str[50];
 
+    _stateBatch.clear();
+
     if((_firstTunerStatePublish || keyTurnerState.lockState != lastKeyTurnerState.lockState || keyTurnerState.nukiState != lastKeyTurnerState.nukiState) && keyTurnerState.lockState != NukiOpener::LockState::Undefined)
     {
         memset(&str, 0, sizeof(str));
+        lockStateString(keyTurnerState, str);
+        _stateBatch.addString(_topics.get(MqttTopic::LockState), str);
 
-        if(keyTurnerState.nukiState == NukiOpener::State::ContinuousMode)
-        {
-            publishString(mqtt_topic_lock_state, "ContinuousMode");
-        }
-        else
-        {
-            lockstateToString(keyTurnerState.lockState, str);
-            publishString(mqtt_topic_lock_state, str);
-        }
-
-        if(_haEnabled)
+        const char* binaryStateStr = binaryState(keyTurnerState);
+        if(_haEnabled && binaryStateStr != nullptr)
         {
-            publishBinaryState(keyTurnerState);
+            _stateBatch.addString(_topics.get(MqttTopic::LockBinaryState), binaryStateStr);
         }
     }
 
@@ -225,7 +274,7 @@ void NetworkOpener::publishKeyTurnerState(const NukiOpener::OpenerState& keyTurn
     {
         memset(&str, 0, sizeof(str));
         triggerToString(keyTurnerState.trigger, str);
-        publishString(mqtt_topic_lock_trigger, str);
+        _stateBatch.addString(_topics.get(MqttTopic::LockTrigger), str);
     }
 
 
@@ -233,52 +282,90 @@ void NetworkOpener::publishKeyTurnerState(const NukiOpener::OpenerState& keyTurn
     {
         memset(&str, 0, sizeof(str));
         completionStatusToString(keyTurnerState.lastLockActionCompletionStatus, str);
-        publishString(mqtt_topic_lock_completionStatus, str);
+        _stateBatch.addString(_topics.get(MqttTopic::LockCompletionStatus), str);
     }
 
     if(_firstTunerStatePublish || keyTurnerState.doorSensorState != lastKeyTurnerState.doorSensorState)
     {
         memset(&str, 0, sizeof(str));
         NukiOpener::doorSensorStateToString(keyTurnerState.doorSensorState, str);
-        publishString(mqtt_topic_lock_door_sensor_state, str);
+        _stateBatch.addString(_topics.get(MqttTopic::LockDoorSensorState), str);
     }
 
+    bool critical = (keyTurnerState.criticalBatteryState & 0b00000001) > 0;
+
     if(_firstTunerStatePublish || keyTurnerState.criticalBatteryState != lastKeyTurnerState.criticalBatteryState)
     {
-        bool critical = (keyTurnerState.criticalBatteryState & 0b00000001) > 0;
-        publishBool(mqtt_topic_battery_critical, critical);
+        _stateBatch.addBool(_topics.get(MqttTopic::BatteryCritical), critical);
     }
 
+    if(_publishJson && _stateBatch.size() > 0)
+    {
+        DynamicJsonDocument json(LOCK_STATE_JSON_BUFFER_SIZE);
+
+        memset(&str, 0, sizeof(str));
+        lockStateString(keyTurnerState, str);
+        json["lock_state"] = str;
+
+        memset(&str, 0, sizeof(str));
+        triggerToString(keyTurnerState.trigger, str);
+        json["trigger"] = str;
+
+        memset(&str, 0, sizeof(str));
+        completionStatusToString(keyTurnerState.lastLockActionCompletionStatus, str);
+        json["completion_status"] = str;
+
+        memset(&str, 0, sizeof(str));
+        NukiOpener::doorSensorStateToString(keyTurnerState.doorSensorState, str);
+        json["door_sensor_state"] = str;
+
+        json["battery_critical"] = critical;
+
+        ScratchBuffer buffer;
+        serializeJson(json, buffer.data(), buffer.size());
+        _stateBatch.addString(_topics.get(MqttTopic::LockJson), buffer.data());
+    }
+
+    _network->publishBatch(_stateBatch);
+
     _firstTunerStatePublish = false;
 }
 
+void NetworkOpener::lockStateString(const NukiOpener::OpenerState& state, char* str)
+{
+    if(state.nukiState == NukiOpener::State::ContinuousMode)
+    {
+        strcpy(str, "ContinuousMode");
+    }
+    else
+    {
+        lockstateToString(state.lockState, str);
+    }
+}
+
 void NetworkOpener::publishRing()
 {
-    publishString(mqtt_topic_lock_state, "ring");
+    publishString(MqttTopic::LockState, "ring");
     _resetLockStateTs = millis() + 2000;
 }
 
-void NetworkOpener::publishBinaryState(NukiOpener::OpenerState lockState)
+const char* NetworkOpener::binaryState(const NukiOpener::OpenerState& lockState)
 {
     if(lockState.nukiState == NukiOpener::State::ContinuousMode)
     {
-        publishString(mqtt_topic_lock_binary_state, "unlocked");
+        return "unlocked";
     }
-    else
+
+    switch (lockState.lockState)
     {
-        switch (lockState.lockState)
-        {
-            case NukiOpener::LockState::Locked:
-                publishString(mqtt_topic_lock_binary_state, "locked");
-                break;
-            case NukiOpener::LockState::RTOactive:
-            case NukiOpener::LockState::Open:
-            case NukiOpener::LockState::Opening:
-                publishString(mqtt_topic_lock_binary_state, "unlocked");
-                break;
-            default:
-                break;
-        }
+        case NukiOpener::LockState::Locked:
+            return "locked";
+        case NukiOpener::LockState::RTOactive:
+        case NukiOpener::LockState::Open:
+        case NukiOpener::LockState::Opening:
+            return "unlocked";
+        default:
+            return nullptr;
     }
 }
 
@@ -291,7 +378,7 @@ void NetworkOpener::publishAuthorizationInfo(const std::list<NukiOpener::LogEntr
     char authName[33];
     memset(authName, 0, sizeof(authName));
 
-    DynamicJsonDocument json(_bufferSize);
+    DynamicJsonDocument json(SCRATCH_BUFFER_SIZE);
 
     for(const auto& log : logEntries)
     {
@@ -394,13 +481,14 @@ void NetworkOpener::publishAuthorizationInfo(const std::list<NukiOpener::LogEntr
         }
     }
 
-    serializeJson(json, _buffer, _bufferSize);
-    publishString(mqtt_topic_lock_log, _buffer);
+    ScratchBuffer buffer;
+    serializeJson(json, buffer.data(), buffer.size());
+    publishString(MqttTopic::LockLog, buffer.data());
 
     if(authFound)
     {
-        publishUInt(mqtt_topic_lock_auth_id, authId);
-        publishString(mqtt_topic_lock_auth_name, authName);
+        publishUInt(MqttTopic::LockAuthId, authId);
+        publishString(MqttTopic::LockAuthName, authName);
     }
 }
 
@@ -437,76 +525,140 @@ void NetworkOpener::logactionCompletionStatusToString(uint8_t value, char* out)
 
 void NetworkOpener::clearAuthorizationInfo()
 {
-    publishString(mqtt_topic_lock_log, "--");
-    publishUInt(mqtt_topic_lock_auth_id, 0);
-    publishString(mqtt_topic_lock_auth_name, "--");
+    publishString(MqttTopic::LockLog, "--");
+    publishUInt(MqttTopic::LockAuthId, 0);
+    publishString(MqttTopic::LockAuthName, "--");
+}
+
+void NetworkOpener::publishCommandId(const uint32_t& commandId)
+{
+    publishUInt(MqttTopic::LockCommandId, commandId);
 }
 
-void NetworkOpener::publishCommandResult(const char *resultStr)
+void NetworkOpener::publishCommandResult(const char *resultStr, const uint32_t& commandId)
 {
-    publishString(mqtt_topic_lock_action_command_result, resultStr);
+    publishString(MqttTopic::LockActionCommandResult, resultStr);
+    if(commandId != 0)
+    {
+        publishCommandResultJson(commandId, "lockAction", resultStr);
+    }
+}
+
+void NetworkOpener::publishConfigCommandResult(const char* resultStr, const uint32_t& commandId)
+{
+    publishCommandResultJson(commandId, "config", resultStr);
 }
 
 void NetworkOpener::publishLockstateCommandResult(const char *resultStr)
 {
-    publishString(mqtt_topic_query_lockstate_command_result, resultStr);
+    publishString(MqttTopic::QueryLockstateCommandResult, resultStr);
 }
 
 void NetworkOpener::publishBatteryReport(const NukiOpener::BatteryReport& batteryReport)
 {
-    publishFloat(mqtt_topic_battery_voltage, (float)batteryReport.batteryVoltage / 1000.0);
+    publishFloat(MqttTopic::BatteryVoltage, (float)batteryReport.batteryVoltage / 1000.0);
 }
 
 void NetworkOpener::publishConfig(const NukiOpener::Config &config)
 {
-    publishBool(mqtt_topic_config_button_enabled, config.buttonEnabled == 1);
-    publishBool(mqtt_topic_config_led_enabled, config.ledFlashEnabled == 1);
-    publishString(mqtt_topic_info_firmware_version, std::to_string(config.firmwareVersion[0]) + "." + std::to_string(config.firmwareVersion[1]) + "." + std::to_string(config.firmwareVersion[2]));
-    publishString(mqtt_topic_info_hardware_version, std::to_string(config.hardwareRevision[0]) + "." + std::to_string(config.hardwareRevision[1]));
+    publishBool(MqttTopic::ConfigButtonEnabled, config.buttonEnabled == 1);
+    publishBool(MqttTopic::ConfigLedEnabled, config.ledFlashEnabled == 1);
+    publishString(MqttTopic::InfoFirmwareVersion, std::to_string(config.firmwareVersion[0]) + "." + std::to_string(config.firmwareVersion[1]) + "." + std::to_string(config.firmwareVersion[2]));
+    publishString(MqttTopic::InfoHardwareVersion, std::to_string(config.hardwareRevision[0]) + "." + std::to_string(config.hardwareRevision[1]));
 }
 
 void NetworkOpener::publishAdvancedConfig(const NukiOpener::AdvancedConfig &config)
 {
-    publishUInt(mqtt_topic_config_sound_level, config.soundLevel);
+    publishUInt(MqttTopic::ConfigSoundLevel, config.soundLevel);
 }
 
 void NetworkOpener::publishRssi(const int &rssi)
 {
-    publishInt(mqtt_topic_lock_rssi, rssi);
+    publishInt(MqttTopic::LockRssi, rssi);
 }
 
 void NetworkOpener::publishRetry(const std::string& message)
 {
-    publishString(mqtt_topic_lock_retry, message);
+    publishString(MqttTopic::LockRetry, message);
 }
 
 void NetworkOpener::publishBleAddress(const std::string &address)
 {
-    publishString(mqtt_topic_lock_address, address);
+    publishString(MqttTopic::LockAddress, address);
 }
 
 void NetworkOpener::publishHASSConfig(char* deviceType, const char* baseTopic, char* name, char* uidString, char* lockAction, char* unlockAction, char* openAction, char* lockedState, char* unlockedState)
 {
-    _network->publishHASSConfig(deviceType, baseTopic, name, uidString, false, lockAction, unlockAction, openAction, lockedState, unlockedState);
-    _network->publishHASSConfigRingDetect(deviceType, baseTopic, name, uidString);
-    _network->publishHASSConfigSoundLevel(deviceType, baseTopic, name, uidString);
-    _network->publishHASSBleRssiConfig(deviceType, baseTopic, name, uidString);
+    if(!_network->hassDiscoveryEnabled())
+    {
+        return;
+    }
+
+    if(_brokerStateLost)
+    {
+        // The persisted hashes only hold while the broker keeps the retained configs, publish all of them again
+        _hassDiscovery.clearHashes();
+        _brokerStateLost = false;
+    }
+
+    _hassDiscovery.begin(deviceType, baseTopic, name, uidString, lockAction, unlockAction, openAction, lockedState, unlockedState);
+    _hassDiscovery.addPublish(hassBatteryLow);
+    _hassDiscovery.addRemove(hassKeypadBatteryLow);
+    _hassDiscovery.addPublish(hassBatteryVoltage);
+    _hassDiscovery.addPublish(hassTrigger);
+    _hassDiscovery.addPublish(hassMqttConnected);
+    _hassDiscovery.addPublish(hassReset);
+    _hassDiscovery.addPublish(hassFirmwareVersion);
+    _hassDiscovery.addPublish(hassHardwareVersion);
+    _hassDiscovery.addPublish(hassNukiHubVersion);
+    _hassDiscovery.addPublish(hassLedEnabled);
+    _hassDiscovery.addPublish(hassButtonEnabled);
+    _hassDiscovery.addPublish(hassRingDetect);
+    _hassDiscovery.addPublish(hassSoundLevel);
+    _hassDiscovery.addPublish(hassBleSignalStrength);
+}
+
+void NetworkOpener::updateHASSConfig()
+{
+    _hassDiscovery.update();
+}
+
+bool NetworkOpener::hassConfigPending() const
+{
+    return _hassDiscovery.pending();
+}
+
+unsigned long NetworkOpener::hassConfigNextUpdateTs() const
+{
+    return _hassDiscovery.nextUpdateTs();
 }
 
 void NetworkOpener::removeHASSConfig(char* uidString)
 {
+    _hassDiscovery.clearHashes();
     _network->removeHASSConfig(uidString);
 }
 
-void NetworkOpener::publishKeypad(const std::list<NukiLock::KeypadEntry>& entries, uint maxKeypadCodeCount)
+bool NetworkOpener::publishKeypad(const std::list<NukiLock::KeypadEntry>& entries, uint maxKeypadCodeCount)
 {
+    if(_keypadResync)
+    {
+        _keypadCache.clear();
+        _keypadResync = false;
+    }
+
+    bool changed = false;
     uint index = 0;
     for(const auto& entry : entries)
     {
-        String basePath = mqtt_topic_keypad;
-        basePath.concat("/code_");
-        basePath.concat(std::to_string(index).c_str());
-        publishKeypadEntry(basePath, entry);
+        if(_keypadCache.update(index, entry))
+        {
+            String basePath = mqtt_topic_keypad;
+            basePath.concat("/code_");
+            basePath.concat(std::to_string(index).c_str());
+            publishKeypadEntry(basePath, entry);
+            changed = true;
+        }
 
         ++index;
     }
@@ -514,18 +666,65 @@ void NetworkOpener::publishKeypad(const std::list<NukiLock::KeypadEntry>& entrie
     {
         NukiLock::KeypadEntry entry;
         memset(&entry, 0, sizeof(entry));
-        String basePath = mqtt_topic_keypad;
-        basePath.concat("/code_");
-        basePath.concat(std::to_string(index).c_str());
-        publishKeypadEntry(basePath, entry);
+        if(_keypadCache.update(index, entry))
+        {
+            String basePath = mqtt_topic_keypad;
+            basePath.concat("/code_");
+            basePath.concat(std::to_string(index).c_str());
+            publishKeypadEntry(basePath, entry);
+            changed = true;
+        }
 
         ++index;
     }
+
+    if(changed)
+    {
+        publishUInt(MqttTopic::KeypadRevision, _keypadCache.revision());
+    }
+    return changed;
 }
 
-void NetworkOpener::publishKeypadCommandResult(const char* result)
+void NetworkOpener::publishKeypadCommandResult(const char* result, const uint32_t& commandId)
 {
-    publishString(mqtt_topic_keypad_command_result, result);
+    publishString(MqttTopic::KeypadCommandResult, result);
+    if(commandId != 0)
+    {
+        publishCommandResultJson(commandId, "keypad", result);
+    }
+}
+
+void NetworkOpener::publishKeypadJsonCommandResult(const char* result, const uint32_t& commandId, const NukiKeypadBatch* batch)
+{
+    ScratchBuffer buffer;
+    JsonWriter json(buffer.data(), buffer.size());
+    json.beginObject();
+    json.addInt("id", commandId);
+    json.add("result", result);
+    if(batch != nullptr)
+    {
+        batch->writeEntries(json);
+    }
+    json.endObject();
+
+    if(!json.ok())
+    {
+        Log->println(F("Keypad command result exceeds buffer size."));
+        return;
+    }
+    publishString(MqttTopic::KeypadJsonCommandResult, buffer.data());
+}
+
+void NetworkOpener::publishCommandResultJson(const uint32_t& commandId, const char* commandType, const char* result)
+{
+    StaticJsonDocument<128> json;
+    json["id"] = commandId;
+    json["command"] = commandType;
+    json["result"] = result;
+
+    char str[128];
+    serializeJson(json, str, sizeof(str));
+    publishString(MqttTopic::LockCommandResultJson, str);
 }
 
 void NetworkOpener::setLockActionReceivedCallback(LockActionResult (*lockActionReceivedCallback)(const char *))
@@ -543,6 +742,46 @@ void NetworkOpener::setKeypadCommandReceivedCallback(void (*keypadCommandReceive
     _keypadCommandReceivedReceivedCallback = keypadCommandReceivedReceivedCallback;
 }
 
+void NetworkOpener::setKeypadJsonCommandReceivedCallback(void (*keypadJsonCommandReceivedCallback)(char* json))
+{
+    _keypadJsonCommandReceivedCallback = keypadJsonCommandReceivedCallback;
+}
+
+void NetworkOpener::publishFloat(const MqttTopic& topic, const float value, const uint8_t precision)
+{
+    _network->publishFloat(_topics.get(topic), value, precision);
+}
+
+void NetworkOpener::publishInt(const MqttTopic& topic, const int value)
+{
+    _network->publishInt(_topics.get(topic), value);
+}
+
+void NetworkOpener::publishUInt(const MqttTopic& topic, const unsigned int value)
+{
+    _network->publishUInt(_topics.get(topic), value);
+}
+
+void NetworkOpener::publishBool(const MqttTopic& topic, const bool value)
+{
+    _network->publishBool(_topics.get(topic), value);
+}
+
+void NetworkOpener::publishString(const MqttTopic& topic, const String& value)
+{
+    _network->publishString(_topics.get(topic), value.c_str());
+}
+
+void NetworkOpener::publishString(const MqttTopic& topic, const std::string& value)
+{
+    _network->publishString(_topics.get(topic), value.c_str());
+}
+
+void NetworkOpener::publishString(const MqttTopic& topic, const char* value)
+{
+    _network->publishString(_topics.get(topic), value);
+}
+
 void NetworkOpener::publishFloat(const char *topic, const float value, const uint8_t precision)
 {
     _network->publishFloat(_mqttPath, topic, value, precision);
@@ -602,43 +841,6 @@ void NetworkOpener::publishKeypadEntry(const String topic, NukiLock::KeypadEntry
     publishInt(concat(topic, "/lockCount").c_str(), entry.lockCount);
 }
 
-void NetworkOpener::buildMqttPath(const char* path, char* outPath)
-{
-    int offset = 0;
-    for(const char& c : _mqttPath)
-    {
-        if(c == 0x00)
-        {
-            break;
-        }
-        outPath[offset] = c;
-        ++offset;
-    }
-    int i=0;
-    while(path[i] != 0x00)
-    {
-        outPath[offset] = path[i];
-        ++i;
-        ++offset;
-    }
-    outPath[offset] = 0x00;
-}
-
-void NetworkOpener::subscribe(const char *path)
-{
-    char prefixedPath[500];
-    buildMqttPath(path, prefixedPath);
-    _network->subscribe(prefixedPath, MQTT_QOS_LEVEL);
-}
-
-bool NetworkOpener::comparePrefixedPath(const char *fullPath, const char *subPath)
-{
-    char prefixedPath[500];
-    buildMqttPath(subPath, prefixedPath);
-
-    return strcmp(fullPath, prefixedPath) == 0;
-}
-
 String NetworkOpener::concat(String a, String b)
 {
     String c = a;
@@ -659,3 +861,8 @@ uint8_t NetworkOpener::queryCommands()
     _queryCommands = 0;
     return qc;
 }
+
+uint8_t NetworkOpener::pendingQueryCommands() const
+{
+    return _queryCommands;
+}
@@ -8,11 +8,16 @@
 #include "NukiConstants.h"
 #include "NukiOpenerConstants.h"
 #include "NetworkLock.h"
+#include "MqttTopicTable.h"
+#include "MqttPublishBatch.h"
+#include "HassDiscovery.h"
+#include "NukiKeypadBatch.h"
+#include "KeypadPublishCache.h"
 
 class NetworkOpener : public MqttReceiver
 {
 public:
-    explicit NetworkOpener(Network* network, Preferences* preferences, char* buffer, size_t bufferSize);
+    explicit NetworkOpener(Network* network, Preferences* preferences);
     virtual ~NetworkOpener() = default;
 
     void initialize();
@@ -20,10 +25,11 @@ public:
 
     void publishKeyTurnerState(const NukiOpener::OpenerState& keyTurnerState, const NukiOpener::OpenerState& lastKeyTurnerState);
     void publishRing();
-    void publishBinaryState(NukiOpener::OpenerState lockState);
     void publishAuthorizationInfo(const std::list<NukiOpener::LogEntry>& logEntries);
     void clearAuthorizationInfo();
-    void publishCommandResult(const char* resultStr);
+    void publishCommandId(const uint32_t& commandId);
+    void publishCommandResult(const char* resultStr, const uint32_t& commandId = 0);
+    void publishConfigCommandResult(const char* resultStr, const uint32_t& commandId);
     void publishLockstateCommandResult(const char* resultStr);
     void publishBatteryReport(const NukiOpener::BatteryReport& batteryReport);
     void publishConfig(const NukiOpener::Config& config);
@@ -32,22 +38,38 @@ public:
     void publishRetry(const std::string& message);
     void publishBleAddress(const std::string& address);
     void publishHASSConfig(char* deviceType, const char* baseTopic, char* name, char* uidString, char* lockAction, char* unlockAction, char* openAction, char* lockedState, char* unlockedState);
+    void updateHASSConfig();
+    bool hassConfigPending() const;
+    unsigned long hassConfigNextUpdateTs() const;
     void removeHASSConfig(char* uidString);
-    void publishKeypad(const std::list<NukiLock::KeypadEntry>& entries, uint maxKeypadCodeCount);
-    void publishKeypadCommandResult(const char* result);
+    bool publishKeypad(const std::list<NukiLock::KeypadEntry>& entries, uint maxKeypadCodeCount); // true if any code changed
+    void publishKeypadCommandResult(const char* result, const uint32_t& commandId = 0);
+    void publishKeypadJsonCommandResult(const char* result, const uint32_t& commandId = 0, const NukiKeypadBatch* batch = nullptr);
 
     void setLockActionReceivedCallback(LockActionResult (*lockActionReceivedCallback)(const char* value));
     void setConfigUpdateReceivedCallback(void (*configUpdateReceivedCallback)(const char* path, const char* value));
     void setKeypadCommandReceivedCallback(void (*keypadCommandReceivedReceivedCallback)(const char* command, const uint& id, const String& name, const String& code, const int& enabled));
+    void setKeypadJsonCommandReceivedCallback(void (*keypadJsonCommandReceivedCallback)(char* json));
 
-    void onMqttDataReceived(const char* topic, byte* payload, const unsigned int length) override;
+    void onMqttDataReceived(const MqttTopic& topic, byte* payload, const unsigned int length) override;
 
     bool reconnected();
     uint8_t queryCommands();
+    uint8_t pendingQueryCommands() const; // like queryCommands(), without clearing them
 
 private:
-    bool comparePrefixedPath(const char* fullPath, const char* subPath);
-
+    void lockStateString(const NukiOpener::OpenerState& state, char* str);
+    const char* binaryState(const NukiOpener::OpenerState& lockState);
+
+    void publishFloat(const MqttTopic& topic, const float value, const uint8_t precision = 2);
+    void publishInt(const MqttTopic& topic, const int value);
+    void publishUInt(const MqttTopic& topic, const unsigned int value);
+    void publishBool(const MqttTopic& topic, const bool value);
+    void publishString(const MqttTopic& topic, const String& value);
+    void publishString(const MqttTopic& topic, const std::string& value);
+    void publishString(const MqttTopic& topic, const char* value);
+
+    // Dynamic sub paths (keypad codes), prefixed on every call
     void publishFloat(const char* topic, const float value, const uint8_t precision = 2);
     void publishInt(const char* topic, const int value);
     void publishUInt(const char* topic, const unsigned int value);
@@ -57,8 +79,8 @@ private:
     void publishString(const char* topic, const char* value);
     void publishKeypadEntry(const String topic, NukiLock::KeypadEntry entry);
 
-    void buildMqttPath(const char* path, char* outPath);
-    void subscribe(const char* path);
+    void publishCommandResultJson(const uint32_t& commandId, const char* commandType, const char* result);
+
     void logactionCompletionStatusToString(uint8_t value, char* out);
 
     String concat(String a, String b);
@@ -66,15 +88,24 @@ private:
     Preferences* _preferences;
 
     Network* _network = nullptr;
+    HassDiscovery _hassDiscovery;
 
     char _mqttPath[181] = {0};
     bool _isConnected = false;
 
-    std::vector<char*> _configTopics;
+    std::vector<MqttTopic> _configTopics;
 
     bool _firstTunerStatePublish = true;
     bool _haEnabled= false;
+    bool _publishJson = false;
+
+    MqttTopicTable _topics;
+    MqttPublishBatch _stateBatch;
+
     bool _reconnected = false;
+    bool _brokerStateLost = false; // the broker reported no session, its retained HASS configs may be gone
+    bool _keypadResync = false; // set on reconnect, the broker may have lost the retained codes
+    KeypadPublishCache _keypadCache;
 
     String _keypadCommandName = "";
     String _keypadCommandCode = "";
@@ -83,10 +114,9 @@ private:
     unsigned long _resetLockStateTs = 0;
     uint8_t _queryCommands = 0;
 
-    char* _buffer;
-    const size_t _bufferSize;
 
     LockActionResult (*_lockActionReceivedCallback)(const char* value) = nullptr;
     void (*_configUpdateReceivedCallback)(const char* path, const char* value) = nullptr;
     void (*_keypadCommandReceivedReceivedCallback)(const char* command, const uint& id, const String& name, const String& code, const int& enabled) = nullptr;
+    void (*_keypadJsonCommandReceivedCallback)(char* json) = nullptr;
 };
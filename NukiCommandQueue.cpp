@@ -0,0 +1,74 @@
+#include "NukiCommandQueue.h"
+
+NukiCommandQueue::NukiCommandQueue()
+: _enqueuePos(0),
+  _droppedCount(0)
+{
+    for(uint32_t i = 0; i < NUKI_COMMAND_QUEUE_SIZE; i++)
+    {
+        _slots[i].sequence.store(i, std::memory_order_relaxed);
+    }
+}
+
+uint32_t NukiCommandQueue::push(NukiCommand& command)
+{
+    uint32_t pos = _enqueuePos.load(std::memory_order_relaxed);
+    Slot* slot = nullptr;
+
+    while(true)
+    {
+        slot = &_slots[pos & (NUKI_COMMAND_QUEUE_SIZE - 1)];
+        int32_t diff = (int32_t)(slot->sequence.load(std::memory_order_acquire) - pos);
+
+        if(diff == 0)
+        {
+            if(_enqueuePos.compare_exchange_weak(pos, pos + 1, std::memory_order_relaxed))
+            {
+                break;
+            }
+        }
+        else if(diff < 0)
+        {
+            _droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return 0;
+        }
+        else
+        {
+            pos = _enqueuePos.load(std::memory_order_relaxed);
+        }
+    }
+
+    command.id = pos + 1;
+    slot->command = command;
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    return command.id;
+}
+
+NukiCommand* NukiCommandQueue::front()
+{
+    Slot& slot = _slots[_dequeuePos & (NUKI_COMMAND_QUEUE_SIZE - 1)];
+    if(slot.sequence.load(std::memory_order_acquire) != _dequeuePos + 1)
+    {
+        return nullptr;
+    }
+    return &slot.command;
+}
+
+void NukiCommandQueue::pop()
+{
+    Slot& slot = _slots[_dequeuePos & (NUKI_COMMAND_QUEUE_SIZE - 1)];
+    slot.sequence.store(_dequeuePos + NUKI_COMMAND_QUEUE_SIZE, std::memory_order_release);
+    ++_dequeuePos;
+}
+
+bool NukiCommandQueue::empty() const
+{
+    const Slot& slot = _slots[_dequeuePos & (NUKI_COMMAND_QUEUE_SIZE - 1)];
+    return slot.sequence.load(std::memory_order_acquire) != _dequeuePos + 1;
+}
+
+uint32_t NukiCommandQueue::droppedCount() const
+{
+    return _droppedCount.load(std::memory_order_relaxed);
+}
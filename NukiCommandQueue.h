@@ -0,0 +1,69 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "Config.h"
+
+enum class NukiCommandType : uint8_t
+{
+    LockAction,
+    KeypadCommand,
+    KeypadBatch,
+    ConfigUpdate
+};
+
+struct NukiCommand
+{
+    NukiCommandType type = NukiCommandType::LockAction;
+    uint32_t id = 0;
+    unsigned long enqueuedTs = 0; // millis()
+
+    uint8_t lockAction = 0xff;
+
+    struct
+    {
+        char action[8] = {0};
+        uint16_t codeId = 0;
+        char name[21] = {0};
+        char code[8] = {0};
+        int enabled = 1;
+    } keypad;
+
+    struct
+    {
+        const char* topic = nullptr; // points to one of the mqtt_topic_config_* literals
+        char value[16] = {0};
+    } config;
+};
+
+// Bounded multi-producer / single-consumer ring of commands for the nuki task.
+// Producers (network task, GPIO ISRs) never block: push() either claims a slot with a single CAS or fails when the queue is full.
+// The nuki task is the only consumer. It can keep the front command while retrying and only pops it once it's done.
+class NukiCommandQueue
+{
+public:
+    NukiCommandQueue();
+
+    // Returns the id assigned to the command, 0 if the queue is full.
+    uint32_t push(NukiCommand& command);
+
+    NukiCommand* front();
+    void pop();
+    bool empty() const;
+
+    uint32_t droppedCount() const;
+
+private:
+    struct Slot
+    {
+        std::atomic<uint32_t> sequence;
+        NukiCommand command;
+    };
+
+    static_assert((NUKI_COMMAND_QUEUE_SIZE & (NUKI_COMMAND_QUEUE_SIZE - 1)) == 0, "NUKI_COMMAND_QUEUE_SIZE must be a power of two");
+
+    Slot _slots[NUKI_COMMAND_QUEUE_SIZE];
+    std::atomic<uint32_t> _enqueuePos;
+    uint32_t _dequeuePos = 0;
+    std::atomic<uint32_t> _droppedCount;
+};
@@ -0,0 +1,92 @@
+#include "NukiKeypadBatch.h"
+#include "ArduinoJson.h"
+
+// Zero-copy parsing, the document only holds the array and the entry objects
+#define NUKI_KEYPAD_BATCH_JSON_SIZE (JSON_ARRAY_SIZE(NUKI_KEYPAD_BATCH_MAX_OPERATIONS) + NUKI_KEYPAD_BATCH_MAX_OPERATIONS * JSON_OBJECT_SIZE(6))
+
+NukiKeypadBatch::NukiKeypadBatch()
+: _busy(false)
+{}
+
+bool NukiKeypadBatch::acquire()
+{
+    bool expected = false;
+    return _busy.compare_exchange_strong(expected, true, std::memory_order_acquire);
+}
+
+void NukiKeypadBatch::release()
+{
+    _busy.store(false, std::memory_order_release);
+}
+
+const char* NukiKeypadBatch::parse(char* json)
+{
+    _count = 0;
+
+    DynamicJsonDocument doc(NUKI_KEYPAD_BATCH_JSON_SIZE);
+    if(deserializeJson(doc, json) || !doc.is<JsonArray>())
+    {
+        return "InvalidJson";
+    }
+
+    JsonArray entries = doc.as<JsonArray>();
+    if(entries.size() == 0)
+    {
+        return "NoEntries";
+    }
+    if(entries.size() > NUKI_KEYPAD_BATCH_MAX_OPERATIONS)
+    {
+        return "TooManyEntries";
+    }
+
+    for(JsonObject entry : entries)
+    {
+        NukiKeypadOperation& operation = _operations[_count];
+        operation = NukiKeypadOperation();
+
+        strncpy(operation.action, entry["action"] | "", sizeof(operation.action) - 1);
+        operation.codeId = entry["id"] | 0;
+        strncpy(operation.name, entry["name"] | "", sizeof(operation.name) - 1);
+        operation.enabled = entry["enabled"] | 1;
+
+        JsonVariant code = entry["code"];
+        if(code.is<const char*>())
+        {
+            strncpy(operation.code, code.as<const char*>(), sizeof(operation.code) - 1);
+        }
+        else if(!code.isNull())
+        {
+            snprintf(operation.code, sizeof(operation.code), "%ld", code.as<long>());
+        }
+
+        ++_count;
+    }
+
+    return nullptr;
+}
+
+size_t NukiKeypadBatch::count() const
+{
+    return _count;
+}
+
+NukiKeypadOperation& NukiKeypadBatch::operator[](const size_t index)
+{
+    return _operations[index];
+}
+
+void NukiKeypadBatch::writeEntries(JsonWriter& json) const
+{
+    json.beginArray("entries");
+    for(size_t i = 0; i < _count; ++i)
+    {
+        const NukiKeypadOperation& operation = _operations[i];
+        json.beginObject();
+        json.add("action", operation.action);
+        json.addInt("id", operation.codeId);
+        json.add("name", operation.name);
+        json.add("result", operation.result);
+        json.endObject();
+    }
+    json.endArray();
+}
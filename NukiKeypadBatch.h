@@ -0,0 +1,41 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+#include "Config.h"
+#include "JsonWriter.h"
+
+struct NukiKeypadOperation
+{
+    char action[8] = {0};
+    uint16_t codeId = 0;
+    char name[21] = {0};
+    char code[8] = {0};
+    int enabled = 1;
+    char result[21] = {0};
+};
+
+// Single slot holding a bulk keypad command, a JSON array of add / update / delete operations.
+// The network task claims the slot and parses the payload into it, the nuki task applies all operations,
+// fills in the per entry results and releases the slot again. Only one bulk command can be pending per device.
+class NukiKeypadBatch
+{
+public:
+    NukiKeypadBatch();
+
+    bool acquire();
+    void release();
+
+    // Parses the payload in place (the buffer is modified). Returns nullptr on success, otherwise the result string to report.
+    const char* parse(char* json);
+
+    size_t count() const;
+    NukiKeypadOperation& operator[](const size_t index);
+
+    void writeEntries(JsonWriter& json) const;
+
+private:
+    NukiKeypadOperation _operations[NUKI_KEYPAD_BATCH_MAX_OPERATIONS];
+    size_t _count = 0;
+    std::atomic<bool> _busy;
+};
@@ -3,35 +3,38 @@
 #include "PreferencesKeys.h"
 #include "MqttTopics.h"
 #include "Logger.h"
+#include "NukiTask.h"
 #include "RestartReason.h"
 #include <NukiOpenerUtils.h>
 
 NukiOpenerWrapper* nukiOpenerInst;
 AccessLevel NukiOpenerWrapper::_accessLevel = AccessLevel::ReadOnly;
 
-NukiOpenerWrapper::NukiOpenerWrapper(const std::string& deviceName, NukiDeviceId* deviceId, BleScanner::Scanner* scanner, NetworkOpener* network, Gpio* gpio, Preferences* preferences)
+NukiOpenerWrapper::NukiOpenerWrapper(const std::string& deviceName, NukiDeviceId* deviceId, BleScanner::Scanner* scanner, NetworkOpener* network, Gpio* gpio, StatusSnapshot* statusSnapshot, Preferences* preferences)
 : _deviceName(deviceName),
   _deviceId(deviceId),
   _nukiOpener(deviceName, _deviceId->get()),
   _bleScanner(scanner),
   _network(network),
   _gpio(gpio),
+  _statusSnapshot(statusSnapshot),
   _preferences(preferences)
 {
-    Log->print("Device id opener: ");
-    Log->println(_deviceId->get());
+    LOG_INFO("Device id opener: %u", _deviceId->get());
 
     nukiOpenerInst = this;
 
-    memset(&_lastKeyTurnerState, sizeof(NukiLock::KeyTurnerState), 0);
-    memset(&_lastBatteryReport, sizeof(NukiLock::BatteryReport), 0);
-    memset(&_batteryReport, sizeof(NukiLock::BatteryReport), 0);
-    memset(&_keyTurnerState, sizeof(NukiLock::KeyTurnerState), 0);
+    memset(&_lastKeyTurnerState, 0, sizeof(NukiOpener::OpenerState));
+    memset(&_lastBatteryReport, 0, sizeof(NukiOpener::BatteryReport));
+    memset(&_batteryReport, 0, sizeof(NukiOpener::BatteryReport));
+    memset(&_keyTurnerState, 0, sizeof(NukiOpener::OpenerState));
+    memset(&_status, 0, sizeof(DeviceStatus));
     _keyTurnerState.lockState = NukiOpener::LockState::Undefined;
 
     network->setLockActionReceivedCallback(nukiOpenerInst->onLockActionReceivedCallback);
     network->setConfigUpdateReceivedCallback(nukiOpenerInst->onConfigUpdateReceivedCallback);
     network->setKeypadCommandReceivedCallback(nukiOpenerInst->onKeypadCommandReceivedCallback);
+    network->setKeypadJsonCommandReceivedCallback(nukiOpenerInst->onKeypadJsonCommandReceivedCallback);
 
     _gpio->addCallback(NukiOpenerWrapper::gpioActionCallback);
 }
@@ -103,24 +106,27 @@ void NukiOpenerWrapper::initialize()
 
     _nukiOpener.setEventHandler(this);
 
-    Log->print(F("Lock state interval: "));
-    Log->print(_intervalLockstate);
-    Log->print(F(" | Battery interval: "));
-    Log->print(_intervalBattery);
-    Log->print(F(" | Publish auth data: "));
-    Log->println(_publishAuthData ? "yes" : "no");
+    LOG_INFO("Lock state interval: %d | Battery interval: %d | Publish auth data: %s", _intervalLockstate, _intervalBattery, _publishAuthData ? "yes" : "no");
 
     if(!_publishAuthData)
     {
         _clearAuthData = true;
     }
+
+    updateStatusSnapshot();
 }
 
 void NukiOpenerWrapper::update()
 {
+    if(_disableHassRequested)
+    {
+        removeHASSConfig();
+        _disableHassRequested = false;
+    }
+
     if (!_paired)
     {
-        Log->println(F("Nuki opener start pairing"));
+        LOG_INFO("Nuki opener start pairing");
         _network->publishBleAddress("");
 
         Nuki::AuthorizationIdType idType = _preferences->getBool(preference_register_as_app) ?
@@ -129,9 +135,11 @@ void NukiOpenerWrapper::update()
 
         if (_nukiOpener.pairNuki(idType) == NukiOpener::PairingResult::Success)
         {
-            Log->println(F("Nuki opener paired"));
+            LOG_INFO("Nuki opener paired");
             _paired = true;
             _network->publishBleAddress(_nukiOpener.getBleAddress().toString());
+            updateBleScannerFilter();
+            updateStatusSnapshot();
         }
         else
         {
@@ -150,27 +158,28 @@ void NukiOpenerWrapper::update()
        _disableBleWatchdogTs < ts &&
        (ts - lastReceivedBeaconTs > _restartBeaconTimeout * 1000))
     {
-        Log->print("No BLE beacon received from the opener for ");
-        Log->print((millis() - _nukiOpener.getLastReceivedBeaconTs()) / 1000);
-        Log->println(" seconds, restarting device.");
+        LOG_ERROR("No BLE beacon received from the opener for %lu seconds, restarting device.", (millis() - _nukiOpener.getLastReceivedBeaconTs()) / 1000);
         delay(200);
         restartEsp(RestartReason::BLEBeaconWatchdog);
     }
 
     _nukiOpener.updateConnectionState();
 
-    if(_statusUpdated || _nextLockStateUpdateTs == 0 || ts >= _nextLockStateUpdateTs || (queryCommands & QUERY_COMMAND_LOCKSTATE) > 0)
+    // Refreshes that are due soon are pulled forward into the same connection
+    unsigned long horizon = refreshDue(ts) ? ts + NUKI_REFRESH_BATCH_WINDOW : ts;
+
+    if(_statusUpdated || _nextLockStateUpdateTs == 0 || horizon >= _nextLockStateUpdateTs || (queryCommands & QUERY_COMMAND_LOCKSTATE) > 0)
     {
         _nextLockStateUpdateTs = ts + _intervalLockstate * 1000;
         updateKeyTurnerState();
         _statusUpdated = false;
     }
-    if(_nextBatteryReportTs == 0 || ts > _nextBatteryReportTs || (queryCommands & QUERY_COMMAND_BATTERY) > 0)
+    if(_nextBatteryReportTs == 0 || horizon >= _nextBatteryReportTs || (queryCommands & QUERY_COMMAND_BATTERY) > 0)
     {
         _nextBatteryReportTs = ts + _intervalBattery * 1000;
         updateBatteryState();
     }
-    if(_nextConfigUpdateTs == 0 || ts > _nextConfigUpdateTs || (queryCommands & QUERY_COMMAND_CONFIG) > 0)
+    if(_nextConfigUpdateTs == 0 || horizon >= _nextConfigUpdateTs || (queryCommands & QUERY_COMMAND_CONFIG) > 0)
     {
         _nextConfigUpdateTs = ts + _intervalConfig * 1000;
         updateConfig();
@@ -192,102 +201,178 @@ void NukiOpenerWrapper::update()
         {
             _network->publishRssi(rssi);
             _lastRssi = rssi;
+            updateStatusSnapshot();
         }
     }
 
-    if(_hasKeypad && _keypadEnabled && (_nextKeypadUpdateTs == 0 || ts > _nextKeypadUpdateTs || (queryCommands & QUERY_COMMAND_KEYPAD) > 0))
+    if(_hasKeypad && _keypadEnabled && (_nextKeypadUpdateTs == 0 || horizon >= _nextKeypadUpdateTs || (queryCommands & QUERY_COMMAND_KEYPAD) > 0))
     {
         _nextKeypadUpdateTs = ts + _intervalKeypad * 1000;
         updateKeypad();
     }
 
-    if(_nextLockAction != (NukiOpener::LockAction)0xff && ts > _nextRetryTs)
+    NukiCommand* command = _commandQueue.front();
+    if(command != nullptr && ts > _nextRetryTs)
     {
-        Nuki::CmdResult cmdResult = _nukiOpener.lockAction(_nextLockAction, 0, 0);
+        switch(command->type)
+        {
+            case NukiCommandType::LockAction:
+                if(processLockAction(*command))
+                {
+                    _commandQueue.pop();
+                }
+                break;
+            case NukiCommandType::KeypadCommand:
+                onKeypadCommandReceived(command->id, command->keypad.action, command->keypad.codeId, command->keypad.name, command->keypad.code, command->keypad.enabled);
+                _commandQueue.pop();
+                break;
+            case NukiCommandType::KeypadBatch:
+                onKeypadBatchReceived(command->id);
+                _keypadBatch.release();
+                _commandQueue.pop();
+                break;
+            case NukiCommandType::ConfigUpdate:
+                onConfigUpdateReceived(command->id, command->config.topic, command->config.value);
+                _commandQueue.pop();
+                break;
+        }
+    }
 
-        char resultStr[15] = {0};
-        NukiOpener::cmdResultToString(cmdResult, resultStr);
+    if(_commandQueue.empty())
+    {
+        _network->updateHASSConfig();
+    }
 
-        _network->publishCommandResult(resultStr);
+    if(_clearAuthData)
+    {
+        _network->clearAuthorizationInfo();
+        _clearAuthData = false;
+    }
 
-        Log->print(F("Lock action result: "));
-        Log->println(resultStr);
+    memcpy(&_lastKeyTurnerState, &_keyTurnerState, sizeof(NukiOpener::OpenerState));
+}
 
-        if(cmdResult == Nuki::CmdResult::Success)
-        {
-            _retryCount = 0;
-            _nextLockAction = (NukiOpener::LockAction) 0xff;
-            _network->publishRetry("--");
-            if (_intervalLockstate > 10)
-            {
-                _nextLockStateUpdateTs = ts + 10 * 1000;
-            }
-        }
-        else
+
+bool NukiOpenerWrapper::processLockAction(const NukiCommand& command)
+{
+    Nuki::CmdResult cmdResult = _nukiOpener.lockAction((NukiOpener::LockAction)command.lockAction, 0, 0);
+
+    char resultStr[15] = {0};
+    NukiOpener::cmdResultToString(cmdResult, resultStr);
+
+    LOG_INFO("Lock action result: %s", resultStr);
+
+    bool finished = true;
+
+    if(cmdResult == Nuki::CmdResult::Success)
+    {
+        _retryCount = 0;
+        _nextRetryTs = 0;
+        _network->publishCommandResult(resultStr, command.id);
+        _network->publishRetry("--");
+        _nextLockStateUpdateTs = std::min(_nextLockStateUpdateTs, millis() + NUKI_LOCK_ACTION_REFRESH_DELAY);
+    }
+    else
+    {
+        if(_retryCount < _nrOfRetries)
         {
-            if(_retryCount < _nrOfRetries)
-            {
-                Log->print(F("Opener: Last command failed, retrying after "));
-                Log->print(_retryDelay);
-                Log->print(F(" milliseconds. Retry "));
-                Log->print(_retryCount + 1);
-                Log->print(" of ");
-                Log->println(_nrOfRetries);
+            LOG_WARN("Opener: Last command failed, retrying after %d milliseconds. Retry %d of %d", _retryDelay, _retryCount + 1, _nrOfRetries);
 
-                _network->publishRetry(std::to_string(_retryCount + 1));
+            _network->publishCommandResult(resultStr);
+            _network->publishRetry(std::to_string(_retryCount + 1));
 
-                _nextRetryTs = millis() + _retryDelay;
+            _nextRetryTs = millis() + _retryDelay;
 
-                ++_retryCount;
-            }
-            else
-            {
-                Log->println(F("Opener: Maximum number of retries exceeded, aborting."));
-                _network->publishRetry("failed");
-                _retryCount = 0;
-                _nextRetryTs = 0;
-                _nextLockAction = (NukiOpener::LockAction) 0xff;
-            }
+            ++_retryCount;
+            finished = false;
+        }
+        else
+        {
+            LOG_ERROR("Opener: Maximum number of retries exceeded, aborting.");
+            _network->publishCommandResult(resultStr, command.id);
+            _network->publishRetry("failed");
+            _retryCount = 0;
+            _nextRetryTs = 0;
         }
-        postponeBleWatchdog();
     }
+    postponeBleWatchdog();
 
-    if(_clearAuthData)
+    return finished;
+}
+
+bool NukiOpenerWrapper::refreshDue(const unsigned long ts) const
+{
+    bool due = ts >= _nextLockStateUpdateTs || ts >= _nextBatteryReportTs || ts >= _nextConfigUpdateTs;
+    if(_hasKeypad && _keypadEnabled)
     {
-        _network->clearAuthorizationInfo();
-        _clearAuthData = false;
+        due = due || ts >= _nextKeypadUpdateTs;
     }
+    return due;
+}
 
-    memcpy(&_lastKeyTurnerState, &_keyTurnerState, sizeof(NukiOpener::OpenerState));
+bool NukiOpenerWrapper::bleWorkPending(const unsigned long ts) const
+{
+    // Mirrors the conditions in update() that start a GATT exchange. RSSI and HASS updates only use cached data or MQTT.
+    if(_statusUpdated || _disableHassRequested || _network->pendingQueryCommands() != 0)
+    {
+        return true;
+    }
+    // A due refresh pulls the ones within NUKI_REFRESH_BATCH_WINDOW into the same connection
+    if(refreshDue(ts))
+    {
+        return true;
+    }
+    return !_commandQueue.empty() && ts > _nextRetryTs;
 }
 
+unsigned long NukiOpenerWrapper::nextUpdateTs() const
+{
+    unsigned long ts = std::min(_nextLockStateUpdateTs, std::min(_nextBatteryReportTs, _nextConfigUpdateTs));
+    if(_hasKeypad && _keypadEnabled)
+    {
+        ts = std::min(ts, _nextKeypadUpdateTs);
+    }
+    if(_rssiPublishInterval > 0)
+    {
+        ts = std::min(ts, (unsigned long)_nextRssiTs);
+    }
+    if(!_commandQueue.empty())
+    {
+        ts = std::min(ts, _nextRetryTs);
+    }
+    if(_network->hassConfigPending())
+    {
+        ts = std::min(ts, _network->hassConfigNextUpdateTs());
+    }
+    return ts;
+}
 
 void NukiOpenerWrapper::electricStrikeActuation()
 {
-    _nextLockAction = NukiOpener::LockAction::ElectricStrikeActuation;
+    enqueueLockAction(NukiOpener::LockAction::ElectricStrikeActuation);
 }
 
 void NukiOpenerWrapper::activateRTO()
 {
-    _nextLockAction = NukiOpener::LockAction::ActivateRTO;
+    enqueueLockAction(NukiOpener::LockAction::ActivateRTO);
 }
 
 void NukiOpenerWrapper::activateCM()
 {
-    _nextLockAction = NukiOpener::LockAction::ActivateCM;
+    enqueueLockAction(NukiOpener::LockAction::ActivateCM);
 }
 
 void NukiOpenerWrapper::deactivateRtoCm()
 {
     if(_keyTurnerState.nukiState == NukiOpener::State::ContinuousMode)
     {
-        _nextLockAction = NukiOpener::LockAction::DeactivateCM;
+        enqueueLockAction(NukiOpener::LockAction::DeactivateCM);
         return;
     }
 
     if(_keyTurnerState.lockState == NukiOpener::LockState::RTOactive)
     {
-        _nextLockAction = NukiOpener::LockAction::DeactivateRTO;
+        enqueueLockAction(NukiOpener::LockAction::DeactivateRTO);
     }
 }
 
@@ -306,11 +391,22 @@ void NukiOpenerWrapper::unpair()
     _nukiOpener.unPairNuki();
     _deviceId->assignNewId();
     _paired = false;
+    updateBleScannerFilter();
+}
+
+void NukiOpenerWrapper::updateBleScannerFilter()
+{
+    // Once paired only advertisements of the own device are forwarded, pairing needs to see all devices
+    BleScanner::AdvertisementFilter filter;
+    if(_paired)
+    {
+        filter.addAddress(_nukiOpener.getBleAddress());
+    }
+    _bleScanner->setFilter(&_nukiOpener, filter);
 }
 
 void NukiOpenerWrapper::updateKeyTurnerState()
 {
-    Log->print(F("Querying opener state: "));
     Nuki::CmdResult result =_nukiOpener.requestOpenerState(&_keyTurnerState);
 
     char resultStr[15];
@@ -320,6 +416,7 @@ void NukiOpenerWrapper::updateKeyTurnerState()
 
     if(result != Nuki::CmdResult::Success)
     {
+        LOG_WARN("Querying opener state: %s", resultStr);
         _retryLockstateCount++;
         postponeBleWatchdog();
         if(_retryLockstateCount < _nrOfRetries)
@@ -335,23 +432,24 @@ void NukiOpenerWrapper::updateKeyTurnerState()
         _lastKeyTurnerState.lockState == NukiOpener::LockState::Locked &&
         _lastKeyTurnerState.nukiState == _keyTurnerState.nukiState)
     {
-        Log->println(F("Nuki opener: Ring detected"));
+        LOG_INFO("Nuki opener: Ring detected");
         _network->publishRing();
     }
     else
     {
         _network->publishKeyTurnerState(_keyTurnerState, _lastKeyTurnerState);
         updateGpioOutputs();
+        updateStatusSnapshot();
 
         if(_keyTurnerState.nukiState == NukiOpener::State::ContinuousMode)
         {
-            Log->println(F("Continuous Mode"));
+            LOG_DEBUG("Opener state: Continuous Mode");
         }
         else
         {
             char lockStateStr[20];
             lockstateToString(_keyTurnerState.lockState, lockStateStr);
-            Log->println(lockStateStr);
+            LOG_DEBUG("Opener state: %s", lockStateStr);
         }
     }
 
@@ -365,12 +463,12 @@ void NukiOpenerWrapper::updateKeyTurnerState()
 
 void NukiOpenerWrapper::updateBatteryState()
 {
-    Log->print("Querying opener battery state: ");
     Nuki::CmdResult result = _nukiOpener.requestBatteryReport(&_batteryReport);
-    printCommandResult(result);
+    printCommandResult("Querying opener battery state", result);
     if(result == Nuki::CmdResult::Success)
     {
         _network->publishBatteryReport(_batteryReport);
+        updateStatusSnapshot();
     }
     postponeBleWatchdog();
 }
@@ -392,6 +490,7 @@ void NukiOpenerWrapper::updateConfig()
     {
         _network->publishAdvancedConfig(_nukiAdvancedConfig);
     }
+    updateStatusSnapshot();
 }
 
 void NukiOpenerWrapper::updateAuthData()
@@ -401,19 +500,36 @@ void NukiOpenerWrapper::updateAuthData()
     {
         return;
     }
-    delay(100);
 
+    // The count and the entries arrive as separate notifications, wait for them instead of sleeping a fixed time
+    unsigned long timeoutTs = millis() + NUKI_LOG_COUNT_TIMEOUT;
     uint16_t count = _nukiOpener.getLogEntryCount();
+    while(count == 0 && (long)(millis() - timeoutTs) < 0)
+    {
+        delay(NUKI_LOG_POLL_INTERVAL);
+        count = _nukiOpener.getLogEntryCount();
+    }
+    if(count == 0)
+    {
+        return;
+    }
 
-    result = _nukiOpener.retrieveLogEntries(0, count < 5 ? count : 5, 1, false);
+    uint16_t requested = count < 5 ? count : 5;
+    result = _nukiOpener.retrieveLogEntries(0, requested, 1, false);
     if(result != Nuki::CmdResult::Success)
     {
         return;
     }
-    delay(1000);
 
     std::list<NukiOpener::LogEntry> log;
+    timeoutTs = millis() + NUKI_LOG_ENTRIES_TIMEOUT;
     _nukiOpener.getLogEntries(&log);
+    while(log.size() < requested && (long)(millis() - timeoutTs) < 0)
+    {
+        delay(NUKI_LOG_POLL_INTERVAL);
+        log.clear();
+        _nukiOpener.getLogEntries(&log);
+    }
 
     if(log.size() > 0)
     {
@@ -424,9 +540,8 @@ void NukiOpenerWrapper::updateAuthData()
 
 void NukiOpenerWrapper::updateKeypad()
 {
-    Log->print(F("Querying opener keypad: "));
     Nuki::CmdResult result = _nukiOpener.retrieveKeypadEntries(0, 0xffff);
-    printCommandResult(result);
+    printCommandResult("Querying opener keypad", result);
     if(result == Nuki::CmdResult::Success)
     {
         std::list<NukiLock::KeypadEntry> entries;
@@ -483,14 +598,12 @@ LockActionResult NukiOpenerWrapper::onLockActionReceivedCallback(const char *val
     switch(_accessLevel)
     {
         case AccessLevel::Full:
-            nukiOpenerInst->_nextLockAction = action;
-            return LockActionResult::Success;
+            return nukiOpenerInst->onLockActionAccepted(action);
             break;
         case AccessLevel::LockOnly:
             if(action == NukiOpener::LockAction::DeactivateRTO || action == NukiOpener::LockAction::DeactivateCM)
             {
-                nukiOpenerInst->_nextLockAction = action;
-                return LockActionResult::Success;
+                return nukiOpenerInst->onLockActionAccepted(action);
             }
             return LockActionResult::AccessDenied;
             break;
@@ -501,14 +614,92 @@ LockActionResult NukiOpenerWrapper::onLockActionReceivedCallback(const char *val
     }
 }
 
+LockActionResult NukiOpenerWrapper::onLockActionAccepted(const NukiOpener::LockAction& action)
+{
+    uint32_t commandId = enqueueLockAction(action);
+    if(commandId == 0)
+    {
+        LOG_WARN("Opener: Command queue full, lock action dropped.");
+        return LockActionResult::QueueFull;
+    }
+    _network->publishCommandId(commandId);
+    return LockActionResult::Success;
+}
+
+uint32_t NukiOpenerWrapper::enqueueLockAction(const NukiOpener::LockAction& action)
+{
+    NukiCommand command;
+    command.type = NukiCommandType::LockAction;
+    command.lockAction = (uint8_t)action;
+
+    uint32_t commandId = _commandQueue.push(command);
+    if(commandId != 0)
+    {
+        wakeNukiTask();
+    }
+    return commandId;
+}
+
 void NukiOpenerWrapper::onConfigUpdateReceivedCallback(const char *topic, const char *value)
 {
-    nukiOpenerInst->onConfigUpdateReceived(topic, value);
+    NukiCommand command;
+    command.type = NukiCommandType::ConfigUpdate;
+    command.config.topic = topic;
+    strncpy(command.config.value, value, sizeof(command.config.value) - 1);
+
+    if(nukiOpenerInst->_commandQueue.push(command) == 0)
+    {
+        LOG_WARN("Opener: Command queue full, config update dropped.");
+        return;
+    }
+    wakeNukiTask();
 }
 
 void NukiOpenerWrapper::onKeypadCommandReceivedCallback(const char *command, const uint &id, const String &name, const String &code, const int& enabled)
 {
-    nukiOpenerInst->onKeypadCommandReceived(command, id, name, code, enabled);
+    NukiCommand keypadCommand;
+    keypadCommand.type = NukiCommandType::KeypadCommand;
+    strncpy(keypadCommand.keypad.action, command, sizeof(keypadCommand.keypad.action) - 1);
+    keypadCommand.keypad.codeId = id;
+    strncpy(keypadCommand.keypad.name, name.c_str(), sizeof(keypadCommand.keypad.name) - 1);
+    strncpy(keypadCommand.keypad.code, code.c_str(), sizeof(keypadCommand.keypad.code) - 1);
+    keypadCommand.keypad.enabled = enabled;
+
+    if(nukiOpenerInst->_commandQueue.push(keypadCommand) == 0)
+    {
+        nukiOpenerInst->_network->publishKeypadCommandResult("QueueFull");
+        return;
+    }
+    wakeNukiTask();
+}
+
+void NukiOpenerWrapper::onKeypadJsonCommandReceivedCallback(char* json)
+{
+    NukiKeypadBatch& batch = nukiOpenerInst->_keypadBatch;
+    if(!batch.acquire())
+    {
+        nukiOpenerInst->_network->publishKeypadJsonCommandResult("Busy");
+        return;
+    }
+
+    const char* error = batch.parse(json);
+    if(error != nullptr)
+    {
+        batch.release();
+        nukiOpenerInst->_network->publishKeypadJsonCommandResult(error);
+        return;
+    }
+
+    NukiCommand batchCommand;
+    batchCommand.type = NukiCommandType::KeypadBatch;
+
+    if(nukiOpenerInst->_commandQueue.push(batchCommand) == 0)
+    {
+        batch.release();
+        nukiOpenerInst->_network->publishKeypadJsonCommandResult("QueueFull");
+        return;
+    }
+    wakeNukiTask();
 }
 
 void NukiOpenerWrapper::gpioActionCallback(const GpioAction &action, const int& pin)
@@ -530,34 +721,68 @@ void NukiOpenerWrapper::gpioActionCallback(const GpioAction &action, const int&
     }
 }
 
-void NukiOpenerWrapper::onConfigUpdateReceived(const char *topic, const char *value)
+void NukiOpenerWrapper::onConfigUpdateReceived(const uint32_t& commandId, const char *topic, const char *value)
 {
     if(_accessLevel != AccessLevel::Full) return;
 
+    Nuki::CmdResult result = (Nuki::CmdResult)-1;
+
     if(strcmp(topic, mqtt_topic_config_button_enabled) == 0)
     {
         bool newValue = atoi(value) > 0;
         if(!_nukiConfigValid || _nukiConfig.buttonEnabled == newValue) return;
-        _nukiOpener.enableButton(newValue);
+        result = _nukiOpener.enableButton(newValue);
         _nextConfigUpdateTs = millis() + 300;
     }
     if(strcmp(topic, mqtt_topic_config_led_enabled) == 0)
     {
         bool newValue = atoi(value) > 0;
         if(!_nukiConfigValid || _nukiConfig.ledFlashEnabled == newValue) return;
-        _nukiOpener.enableLedFlash(newValue);
+        result = _nukiOpener.enableLedFlash(newValue);
         _nextConfigUpdateTs = millis() + 300;
     }
     if(strcmp(topic, mqtt_topic_config_sound_level) == 0)
     {
         uint8_t newValue = atoi(value);
         if(!_nukiAdvancedConfigValid || _nukiAdvancedConfig.soundLevel == newValue) return;
-        _nukiOpener.setSoundLevel(newValue);
+        result = _nukiOpener.setSoundLevel(newValue);
         _nextConfigUpdateTs = millis() + 300;
     }
+
+    if((int)result != -1)
+    {
+        char resultStr[15] = {0};
+        NukiOpener::cmdResultToString(result, resultStr);
+        _network->publishConfigCommandResult(resultStr, commandId);
+    }
+}
+
+void NukiOpenerWrapper::onKeypadCommandReceived(const uint32_t& commandId, const char *command, const uint &id, const String &name, const String &code, const int& enabled)
+{
+    if(_accessLevel != AccessLevel::Full) return;
+
+    if(!_hasKeypad)
+    {
+        if(_configRead)
+        {
+            _network->publishKeypadCommandResult("KeypadNotAvailable", commandId);
+        }
+        return;
+    }
+    if(!_keypadEnabled || strcmp(command, "--") == 0)
+    {
+        return;
+    }
+
+    char resultStr[21] = {0};
+    if(executeKeypadCommand(command, id, name, code, enabled, resultStr))
+    {
+        updateKeypad();
+    }
+    _network->publishKeypadCommandResult(resultStr, commandId);
 }
 
-void NukiOpenerWrapper::onKeypadCommandReceived(const char *command, const uint &id, const String &name, const String &code, const int& enabled)
+void NukiOpenerWrapper::onKeypadBatchReceived(const uint32_t& commandId)
 {
     if(_accessLevel != AccessLevel::Full) return;
 
@@ -565,7 +790,7 @@ void NukiOpenerWrapper::onKeypadCommandReceived(const char *command, const uint
     {
         if(_configRead)
         {
-            _network->publishKeypadCommandResult("KeypadNotAvailable");
+            _network->publishKeypadJsonCommandResult("KeypadNotAvailable", commandId);
         }
         return;
     }
@@ -574,27 +799,47 @@ void NukiOpenerWrapper::onKeypadCommandReceived(const char *command, const uint
         return;
     }
 
+    // The entries are sent back to back so the BLE connection stays up, the keypad is only queried once afterwards
+    bool keypadChanged = false;
+    for(size_t i = 0; i < _keypadBatch.count(); ++i)
+    {
+        NukiKeypadOperation& operation = _keypadBatch[i];
+        if(executeKeypadCommand(operation.action, operation.codeId, operation.name, operation.code, operation.enabled, operation.result))
+        {
+            keypadChanged = true;
+        }
+    }
+
+    if(keypadChanged)
+    {
+        updateKeypad();
+    }
+    _network->publishKeypadJsonCommandResult("Completed", commandId, &_keypadBatch);
+}
+
+bool NukiOpenerWrapper::executeKeypadCommand(const char *command, const uint &id, const String &name, const String &code, const int& enabled, char* resultStr)
+{
     bool idExists = std::find(_keypadCodeIds.begin(), _keypadCodeIds.end(), id) != _keypadCodeIds.end();
     int codeInt = code.toInt();
     bool codeValid = codeInt > 100000 && codeInt < 1000000 && (code.indexOf('0') == -1);
-    NukiLock::CmdResult result = (NukiLock::CmdResult)-1;
+    NukiLock::CmdResult result;
 
     if(strcmp(command, "add") == 0)
     {
         if(name == "" || name == "--")
         {
-            _network->publishKeypadCommandResult("MissingParameterName");
-            return;
+            strcpy(resultStr, "MissingParameterName");
+            return false;
         }
         if(codeInt == 0)
         {
-            _network->publishKeypadCommandResult("MissingParameterCode");
-            return;
+            strcpy(resultStr, "MissingParameterCode");
+            return false;
         }
         if(!codeValid)
         {
-            _network->publishKeypadCommandResult("CodeInvalid");
-            return;
+            strcpy(resultStr, "CodeInvalid");
+            return false;
         }
 
         NukiLock::NewKeypadEntry entry;
@@ -603,41 +848,39 @@ void NukiOpenerWrapper::onKeypadCommandReceived(const char *command, const uint
         memcpy(&entry.name, name.c_str(), nameLen > 20 ? 20 : nameLen);
         entry.code = codeInt;
         result = _nukiOpener.addKeypadEntry(entry);
-        Log->print("Add keypad code: "); Log->println((int)result);
-        updateKeypad();
+        LOG_INFO("Add keypad code: %d", (int)result);
     }
     else if(strcmp(command, "delete") == 0)
     {
         if(!idExists)
         {
-            _network->publishKeypadCommandResult("UnknownId");
-            return;
+            strcpy(resultStr, "UnknownId");
+            return false;
         }
         result = _nukiOpener.deleteKeypadEntry(id);
-        Log->print("Delete keypad code: "); Log->println((int)result);
-        updateKeypad();
+        LOG_INFO("Delete keypad code: %d", (int)result);
     }
     else if(strcmp(command, "update") == 0)
     {
         if(name == "" || name == "--")
         {
-            _network->publishKeypadCommandResult("MissingParameterName");
-            return;
+            strcpy(resultStr, "MissingParameterName");
+            return false;
         }
         if(codeInt == 0)
         {
-            _network->publishKeypadCommandResult("MissingParameterCode");
-            return;
+            strcpy(resultStr, "MissingParameterCode");
+            return false;
         }
         if(!codeValid)
         {
-            _network->publishKeypadCommandResult("CodeInvalid");
-            return;
+            strcpy(resultStr, "CodeInvalid");
+            return false;
         }
         if(!idExists)
         {
-            _network->publishKeypadCommandResult("UnknownId");
-            return;
+            strcpy(resultStr, "UnknownId");
+            return false;
         }
 
         NukiLock::UpdatedKeypadEntry entry;
@@ -648,26 +891,16 @@ void NukiOpenerWrapper::onKeypadCommandReceived(const char *command, const uint
         entry.code = codeInt;
         entry.enabled = enabled == 0 ? 0 : 1;
         result = _nukiOpener.updateKeypadEntry(entry);
-        Log->print("Update keypad code: "); Log->println((int)result);
-        updateKeypad();
-    }
-    else if(command == "--")
-    {
-        return;
+        LOG_INFO("Update keypad code: %d", (int)result);
     }
     else
     {
-        _network->publishKeypadCommandResult("UnknownCommand");
-        return;
+        strcpy(resultStr, "UnknownCommand");
+        return false;
     }
 
-    if((int)result != -1)
-    {
-        char resultStr[15];
-        memset(&resultStr, 0, sizeof(resultStr));
-        NukiOpener::cmdResultToString(result, resultStr);
-        _network->publishKeypadCommandResult(resultStr);
-    }
+    NukiOpener::cmdResultToString(result, resultStr);
+    return true;
 }
 
 const NukiOpener::OpenerState &NukiOpenerWrapper::keyTurnerState()
@@ -700,28 +933,23 @@ void NukiOpenerWrapper::notify(Nuki::EventType eventType)
     if(eventType == Nuki::EventType::KeyTurnerStatusUpdated)
     {
         _statusUpdated = true;
+        wakeNukiTask();
     }
 }
 
 void NukiOpenerWrapper::readConfig()
 {
-    Log->print(F("Reading opener config. Result: "));
     Nuki::CmdResult result = _nukiOpener.requestConfig(&_nukiConfig);
     _nukiConfigValid = result == Nuki::CmdResult::Success;
-    char resultStr[20];
-    NukiOpener::cmdResultToString(result, resultStr);
-    Log->println(resultStr);
+    printCommandResult("Reading opener config", result);
     postponeBleWatchdog();
 }
 
 void NukiOpenerWrapper::readAdvancedConfig()
 {
-    Log->print(F("Reading opener advanced config. Result: "));
     Nuki::CmdResult result = _nukiOpener.requestAdvancedConfig(&_nukiAdvancedConfig);
     _nukiAdvancedConfigValid = result == Nuki::CmdResult::Success;
-    char resultStr[20];
-    NukiOpener::cmdResultToString(result, resultStr);
-    Log->println(resultStr);
+    printCommandResult("Reading opener advanced config", result);
     postponeBleWatchdog();
 }
 
@@ -734,12 +962,29 @@ void NukiOpenerWrapper::setupHASS()
     itoa(_nukiConfig.nukiId, uidString, 16);
     _network->publishHASSConfig("Opener",baseTopic.c_str(),(char*)_nukiConfig.name,uidString, "deactivateRTO","activateRTO","electricStrikeActuation","locked","unlocked");
     _hassSetupCompleted = true;
-
-    Log->println("HASS setup for opener completed.");
 }
 
 void NukiOpenerWrapper::disableHASS()
 {
+    _disableHassRequested = true;
+    wakeNukiTask();
+
+    unsigned long timeout = millis() + NUKI_DISABLE_HASS_TIMEOUT;
+    while(_disableHassRequested && millis() < timeout)
+    {
+        delay(50);
+    }
+    if(_disableHassRequested)
+    {
+        LOG_WARN("Timeout removing the HASS config of the opener.");
+    }
+}
+
+void NukiOpenerWrapper::removeHASSConfig()
+{
+    // Stops a discovery run in progress, so the removed configs aren't published again
+    _hassEnabled = false;
+
     if(!_nukiConfigValid) // only ask for config once to save battery life
     {
         Nuki::CmdResult result = _nukiOpener.requestConfig(&_nukiConfig);
@@ -753,15 +998,15 @@ void NukiOpenerWrapper::disableHASS()
     }
     else
     {
-        Log->println(F("Unable to disable HASS. Invalid config received."));
+        LOG_WARN("Unable to disable HASS. Invalid config received.");
     }
 }
 
-void NukiOpenerWrapper::printCommandResult(Nuki::CmdResult result)
+void NukiOpenerWrapper::printCommandResult(const char* operation, Nuki::CmdResult result)
 {
     char resultStr[15];
     NukiOpener::cmdResultToString(result, resultStr);
-    Log->println(resultStr);
+    LOG_DEBUG("%s: %s", operation, resultStr);
 }
 
 std::string NukiOpenerWrapper::firmwareVersion() const
@@ -805,4 +1050,35 @@ void NukiOpenerWrapper::updateGpioOutputs()
                 break;
         }
     }
-}
\ No newline at end of file
+}
+void NukiOpenerWrapper::updateStatusSnapshot()
+{
+    memset(&_status, 0, sizeof(_status));
+
+    _status.enabled = true;
+    _status.paired = _paired;
+    if(_paired)
+    {
+        strlcpy(_status.bleAddress, _nukiOpener.getBleAddress().toString().c_str(), sizeof(_status.bleAddress));
+    }
+    strlcpy(_status.firmwareVersion, _firmwareVersion.c_str(), sizeof(_status.firmwareVersion));
+    strlcpy(_status.hardwareVersion, _hardwareVersion.c_str(), sizeof(_status.hardwareVersion));
+
+    if(_keyTurnerState.nukiState == NukiOpener::State::ContinuousMode)
+    {
+        strcpy(_status.lockState, "ContinuousMode");
+    }
+    else
+    {
+        NukiOpener::lockstateToString(_keyTurnerState.lockState, _status.lockState);
+    }
+    NukiOpener::triggerToString(_keyTurnerState.trigger, _status.trigger);
+    NukiOpener::completionStatusToString(_keyTurnerState.lastLockActionCompletionStatus, _status.lastLockActionCompletionStatus);
+    NukiOpener::doorSensorStateToString(_keyTurnerState.doorSensorState, _status.doorSensorState);
+
+    _status.batteryCritical = (_keyTurnerState.criticalBatteryState & 0b00000001) > 0;
+    _status.batteryVoltage = _batteryReport.batteryVoltage;
+    _status.rssi = (int)_lastRssi;
+
+    _statusSnapshot->updateOpener(_status);
+}
@@ -8,15 +8,21 @@
 #include "Gpio.h"
 #include "AccessLevel.h"
 #include "NukiDeviceId.h"
+#include "NukiCommandQueue.h"
+#include "NukiKeypadBatch.h"
+#include "StatusSnapshot.h"
+#include <atomic>
 
 class NukiOpenerWrapper : public NukiOpener::SmartlockEventHandler
 {
 public:
-    NukiOpenerWrapper(const std::string& deviceName, NukiDeviceId* deviceId, BleScanner::Scanner* scanner, NetworkOpener* network, Gpio* gpio, Preferences* preferences);
+    NukiOpenerWrapper(const std::string& deviceName, NukiDeviceId* deviceId, BleScanner::Scanner* scanner, NetworkOpener* network, Gpio* gpio, StatusSnapshot* statusSnapshot, Preferences* preferences);
     virtual ~NukiOpenerWrapper();
 
     void initialize();
     void update();
+    unsigned long nextUpdateTs() const;
+    bool bleWorkPending(const unsigned long ts) const; // true if the next update() talks to the device
 
     void electricStrikeActuation();
     void activateRTO();
@@ -28,6 +34,8 @@ public:
 
     void unpair();
     
+    // Removes the HASS discovery configs on the nuki task and waits until that is done (at most NUKI_DISABLE_HASS_TIMEOUT).
+    // Discovery stays disabled until the next restart.
     void disableHASS();
 
     void disableWatchdog();
@@ -48,10 +56,18 @@ private:
     static LockActionResult onLockActionReceivedCallback(const char* value);
     static void onConfigUpdateReceivedCallback(const char* topic, const char* value);
     static void onKeypadCommandReceivedCallback(const char* command, const uint& id, const String& name, const String& code, const int& enabled);
+    static void onKeypadJsonCommandReceivedCallback(char* json);
     static void gpioActionCallback(const GpioAction& action, const int& pin);
-    void onConfigUpdateReceived(const char* topic, const char* value);
-    void onKeypadCommandReceived(const char* command, const uint& id, const String& name, const String& code, const int& enabled);
-
+    LockActionResult onLockActionAccepted(const NukiOpener::LockAction& action);
+    uint32_t enqueueLockAction(const NukiOpener::LockAction& action);
+    bool processLockAction(const NukiCommand& command);
+    void onConfigUpdateReceived(const uint32_t& commandId, const char* topic, const char* value);
+    void onKeypadCommandReceived(const uint32_t& commandId, const char* command, const uint& id, const String& name, const String& code, const int& enabled);
+    void onKeypadBatchReceived(const uint32_t& commandId);
+    bool executeKeypadCommand(const char* command, const uint& id, const String& name, const String& code, const int& enabled, char* resultStr); // resultStr at least 21 characters
+
+    void updateBleScannerFilter();
+    bool refreshDue(const unsigned long ts) const; // true if at least one status refresh is due
     void updateKeyTurnerState();
     void updateBatteryState();
     void updateConfig();
@@ -60,13 +76,15 @@ private:
     void postponeBleWatchdog();
 
     void updateGpioOutputs();
+    void updateStatusSnapshot();
+    void removeHASSConfig();
 
     void readConfig();
     void readAdvancedConfig();
     
     void setupHASS();
 
-    void printCommandResult(Nuki::CmdResult result);
+    void printCommandResult(const char* operation, Nuki::CmdResult result);
 
     NukiOpener::LockAction lockActionToEnum(const char* str); // char array at least 14 characters
 
@@ -76,6 +94,8 @@ private:
     BleScanner::Scanner* _bleScanner = nullptr;
     NetworkOpener* _network = nullptr;
     Gpio* _gpio = nullptr;
+    StatusSnapshot* _statusSnapshot = nullptr;
+    DeviceStatus _status; // rebuilt by updateStatusSnapshot(), a member to keep it off the nuki task stack
     Preferences* _preferences = nullptr;
     int _intervalLockstate = 0; // seconds
     int _intervalBattery = 0; // seconds
@@ -104,6 +124,7 @@ private:
     bool _nukiAdvancedConfigValid = false;
     bool _hassEnabled = false;
     bool _hassSetupCompleted = false;
+    std::atomic<bool> _disableHassRequested{false}; // set by disableHASS(), cleared by the nuki task
 
     bool _paired = false;
     bool _statusUpdated = false;
@@ -122,5 +143,6 @@ private:
     unsigned long _disableBleWatchdogTs = 0;
     std::string _firmwareVersion = "";
     std::string _hardwareVersion = "";
-    NukiOpener::LockAction _nextLockAction = (NukiOpener::LockAction)0xff;
+    NukiCommandQueue _commandQueue;
+    NukiKeypadBatch _keypadBatch;
 };
@@ -0,0 +1,4 @@
+#pragma once
+
+// Wakes the nuki task from its idle wait. Safe to call from task and ISR context.
+void wakeNukiTask();
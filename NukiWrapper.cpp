@@ -3,35 +3,38 @@
 #include "PreferencesKeys.h"
 #include "MqttTopics.h"
 #include "Logger.h"
+#include "NukiTask.h"
 #include "RestartReason.h"
 #include <NukiLockUtils.h>
 
 NukiWrapper* nukiInst;
 AccessLevel NukiWrapper::_accessLevel = AccessLevel::ReadOnly;
 
-NukiWrapper::NukiWrapper(const std::string& deviceName, NukiDeviceId* deviceId, BleScanner::Scanner* scanner, NetworkLock* network, Gpio* gpio, Preferences* preferences)
+NukiWrapper::NukiWrapper(const std::string& deviceName, NukiDeviceId* deviceId, BleScanner::Scanner* scanner, NetworkLock* network, Gpio* gpio, StatusSnapshot* statusSnapshot, Preferences* preferences)
 : _deviceName(deviceName),
   _deviceId(deviceId),
   _bleScanner(scanner),
   _nukiLock(deviceName, _deviceId->get()),
   _network(network),
   _gpio(gpio),
+  _statusSnapshot(statusSnapshot),
   _preferences(preferences)
 {
-    Log->print("Device id lock: ");
-    Log->println(_deviceId->get());
+    LOG_INFO("Device id lock: %u", _deviceId->get());
 
     nukiInst = this;
 
-    memset(&_lastKeyTurnerState, sizeof(NukiLock::KeyTurnerState), 0);
-    memset(&_lastBatteryReport, sizeof(NukiLock::BatteryReport), 0);
-    memset(&_batteryReport, sizeof(NukiLock::BatteryReport), 0);
-    memset(&_keyTurnerState, sizeof(NukiLock::KeyTurnerState), 0);
+    memset(&_lastKeyTurnerState, 0, sizeof(NukiLock::KeyTurnerState));
+    memset(&_lastBatteryReport, 0, sizeof(NukiLock::BatteryReport));
+    memset(&_batteryReport, 0, sizeof(NukiLock::BatteryReport));
+    memset(&_keyTurnerState, 0, sizeof(NukiLock::KeyTurnerState));
+    memset(&_status, 0, sizeof(DeviceStatus));
     _keyTurnerState.lockState = NukiLock::LockState::Undefined;
 
     network->setLockActionReceivedCallback(nukiInst->onLockActionReceivedCallback);
     network->setConfigUpdateReceivedCallback(nukiInst->onConfigUpdateReceivedCallback);
     network->setKeypadCommandReceivedCallback(nukiInst->onKeypadCommandReceivedCallback);
+    network->setKeypadJsonCommandReceivedCallback(nukiInst->onKeypadJsonCommandReceivedCallback);
 
     _gpio->addCallback(NukiWrapper::gpioActionCallback);
 }
@@ -50,7 +53,7 @@ void NukiWrapper::initialize(const bool& firstStart)
     _nukiLock.registerBleScanner(_bleScanner);
 
     _intervalLockstate = _preferences->getInt(preference_query_interval_lockstate);
-    _intervalConfig = _preferences->getInt(preference_query_interval_battery);
+    _intervalConfig = _preferences->getInt(preference_query_interval_configuration);
     _intervalBattery = _preferences->getInt(preference_query_interval_battery);
     _intervalKeypad = _preferences->getInt(preference_query_interval_keypad);
     _keypadEnabled = _preferences->getBool(preference_keypad_control_enabled);
@@ -62,6 +65,8 @@ void NukiWrapper::initialize(const bool& firstStart)
     _retryDelay = _preferences->getInt(preference_command_retry_delay);
     _rssiPublishInterval = _preferences->getInt(preference_rssi_publish_interval) * 1000;
     _accessLevel = (AccessLevel)_preferences->getInt(preference_access_level);
+    int bleSessionTimeout = _preferences->getInt(preference_ble_session_timeout);
+    _bleSessionTimeout = bleSessionTimeout > 0 ? bleSessionTimeout * 1000 : 0;
 
     if(firstStart)
     {
@@ -102,26 +107,34 @@ void NukiWrapper::initialize(const bool& firstStart)
         _preferences->putInt(preference_restart_ble_beacon_lost, _restartBeaconTimeout);
     }
 
+    _lockStatePoll.setBaseInterval(_intervalLockstate * 1000);
+    _batteryPoll.setBaseInterval(_intervalBattery * 1000);
+    _configPoll.setBaseInterval(_intervalConfig * 1000);
+    _keypadPoll.setBaseInterval(_intervalKeypad * 1000);
+
     _nukiLock.setEventHandler(this);
 
-    Log->print(F("Lock state interval: "));
-    Log->print(_intervalLockstate);
-    Log->print(F(" | Battery interval: "));
-    Log->print(_intervalBattery);
-    Log->print(F(" | Publish auth data: "));
-    Log->println(_publishAuthData ? "yes" : "no");
+    LOG_INFO("Lock state interval: %d | Battery interval: %d | Publish auth data: %s", _intervalLockstate, _intervalBattery, _publishAuthData ? "yes" : "no");
 
     if(!_publishAuthData)
     {
         _clearAuthData = true;
     }
+
+    updateStatusSnapshot();
 }
 
 void NukiWrapper::update()
 {
+    if(_disableHassRequested)
+    {
+        removeHASSConfig();
+        _disableHassRequested = false;
+    }
+
     if (!_paired)
     {
-        Log->println(F("Nuki lock start pairing"));
+        LOG_INFO("Nuki lock start pairing");
         _network->publishBleAddress("");
 
         Nuki::AuthorizationIdType idType = _preferences->getBool(preference_register_as_app) ?
@@ -130,9 +143,11 @@ void NukiWrapper::update()
 
         if (_nukiLock.pairNuki(idType) == Nuki::PairingResult::Success)
         {
-            Log->println(F("Nuki paired"));
+            LOG_INFO("Nuki paired");
             _paired = true;
             _network->publishBleAddress(_nukiLock.getBleAddress().toString());
+            updateBleScannerFilter();
+            updateStatusSnapshot();
         }
         else
         {
@@ -151,29 +166,36 @@ void NukiWrapper::update()
        _disableBleWatchdogTs < ts &&
        (ts - lastReceivedBeaconTs > _restartBeaconTimeout * 1000))
     {
-        Log->print("No BLE beacon received from the lock for ");
-        Log->print((millis() - _nukiLock.getLastReceivedBeaconTs()) / 1000);
-        Log->println(" seconds, restarting device.");
+        LOG_ERROR("No BLE beacon received from the lock for %lu seconds, restarting device.", (millis() - _nukiLock.getLastReceivedBeaconTs()) / 1000);
         delay(200);
         restartEsp(RestartReason::BLEBeaconWatchdog);
     }
 
+    updateBleSession(ts);
     _nukiLock.updateConnectionState();
 
-    if(_statusUpdated || _nextLockStateUpdateTs == 0 || ts >= _nextLockStateUpdateTs || (queryCommands & QUERY_COMMAND_LOCKSTATE) > 0)
+    // Refreshes that are due soon are pulled forward into the same connection
+    unsigned long horizon = refreshDue(ts) ? ts + NUKI_REFRESH_BATCH_WINDOW : ts;
+
+    if(_statusUpdated)
+    {
+        // A beacon reported a change, more are likely to follow
+        _lockStatePoll.tighten();
+    }
+    if(_statusUpdated || _nextLockStateUpdateTs == 0 || horizon >= _nextLockStateUpdateTs || (queryCommands & QUERY_COMMAND_LOCKSTATE) > 0)
     {
         _statusUpdated = false;
-        _nextLockStateUpdateTs = ts + _intervalLockstate * 1000;
+        _nextLockStateUpdateTs = ts + _lockStatePoll.interval();
         updateKeyTurnerState();
     }
-    if(_nextBatteryReportTs == 0 || ts > _nextBatteryReportTs || (queryCommands & QUERY_COMMAND_BATTERY) > 0)
+    if(_nextBatteryReportTs == 0 || horizon >= _nextBatteryReportTs || (queryCommands & QUERY_COMMAND_BATTERY) > 0)
     {
-        _nextBatteryReportTs = ts + _intervalBattery * 1000;
+        _nextBatteryReportTs = ts + _batteryPoll.interval();
         updateBatteryState();
     }
-    if(_nextConfigUpdateTs == 0 || ts > _nextConfigUpdateTs || (queryCommands & QUERY_COMMAND_CONFIG) > 0)
+    if(_nextConfigUpdateTs == 0 || horizon >= _nextConfigUpdateTs || (queryCommands & QUERY_COMMAND_CONFIG) > 0)
     {
-        _nextConfigUpdateTs = ts + _intervalConfig * 1000;
+        _nextConfigUpdateTs = ts + _configPoll.interval();
         updateConfig();
         if(_hassEnabled && !_hassSetupCompleted)
         {
@@ -193,88 +215,182 @@ void NukiWrapper::update()
         {
             _network->publishRssi(rssi);
             _lastRssi = rssi;
+            updateStatusSnapshot();
         }
     }
 
-    if(_hasKeypad && _keypadEnabled && (_nextKeypadUpdateTs == 0 || ts > _nextKeypadUpdateTs || (queryCommands & QUERY_COMMAND_KEYPAD) > 0))
+    if(_hasKeypad && _keypadEnabled && (_nextKeypadUpdateTs == 0 || horizon >= _nextKeypadUpdateTs || (queryCommands & QUERY_COMMAND_KEYPAD) > 0))
     {
-        _nextKeypadUpdateTs = ts + _intervalKeypad * 1000;
+        _nextKeypadUpdateTs = ts + _keypadPoll.interval();
         updateKeypad();
     }
 
-    if(_nextLockAction != (NukiLock::LockAction)0xff && ts > _nextRetryTs)
+    NukiCommand* command = _commandQueue.front();
+    if(command != nullptr && ts > _nextRetryTs)
+    {
+        switch(command->type)
+        {
+            case NukiCommandType::LockAction:
+                if(processLockAction(*command))
+                {
+                    _commandQueue.pop();
+                }
+                break;
+            case NukiCommandType::KeypadCommand:
+                onKeypadCommandReceived(command->id, command->keypad.action, command->keypad.codeId, command->keypad.name, command->keypad.code, command->keypad.enabled);
+                _commandQueue.pop();
+                break;
+            case NukiCommandType::KeypadBatch:
+                onKeypadBatchReceived(command->id);
+                _keypadBatch.release();
+                _commandQueue.pop();
+                break;
+            case NukiCommandType::ConfigUpdate:
+                onConfigUpdateReceived(command->id, command->config.topic, command->config.value);
+                _commandQueue.pop();
+                break;
+        }
+    }
+
+    if(_commandQueue.empty())
     {
-        Nuki::CmdResult cmdResult = _nukiLock.lockAction(_nextLockAction, 0, 0);
+        _network->updateHASSConfig();
+    }
 
-        char resultStr[15] = {0};
-        NukiLock::cmdResultToString(cmdResult, resultStr);
+    if(_clearAuthData)
+    {
+        _network->clearAuthorizationInfo();
+        _clearAuthData = false;
+    }
+
+    memcpy(&_lastKeyTurnerState, &_keyTurnerState, sizeof(NukiLock::KeyTurnerState));
+}
+
+bool NukiWrapper::processLockAction(const NukiCommand& command)
+{
+    unsigned long startTs = millis();
+    Nuki::CmdResult cmdResult = _nukiLock.lockAction((NukiLock::LockAction)command.lockAction, 0, 0);
+    unsigned long ts = millis();
+
+    if(_bleSessionActive)
+    {
+        _lockActionSessionLatency.add(ts - startTs);
+    }
+    else
+    {
+        _lockActionLatency.add(ts - startTs);
+    }
+
+    char resultStr[15] = {0};
+    NukiLock::cmdResultToString(cmdResult, resultStr);
 
-        _network->publishCommandResult(resultStr);
+    LOG_INFO("Lock action result: %s", resultStr);
 
-        Log->print(F("Lock action result: "));
-        Log->println(resultStr);
+    bool finished = true;
 
-        if(cmdResult == Nuki::CmdResult::Success)
+    if(cmdResult == Nuki::CmdResult::Success)
+    {
+        _commandLatency.add(ts - command.enqueuedTs);
+        _retryCount = 0;
+        _nextRetryTs = 0;
+        _network->publishCommandResult(resultStr, command.id);
+        _network->publishRetry("--");
+        _lockStatePoll.tighten();
+        _batteryPoll.tighten();
+        _nextLockStateUpdateTs = std::min(_nextLockStateUpdateTs, millis() + NUKI_LOCK_ACTION_REFRESH_DELAY);
+    }
+    else
+    {
+        if(_retryCount < _nrOfRetries)
         {
-            _retryCount = 0;
-            _nextLockAction = (NukiLock::LockAction) 0xff;
-            _network->publishRetry("--");
-            if (_intervalLockstate > 10)
-            {
-                _nextLockStateUpdateTs = ts + 10 * 1000;
-            }
+            LOG_WARN("Lock: Last command failed, retrying after %d milliseconds. Retry %d of %d", _retryDelay, _retryCount + 1, _nrOfRetries);
+
+            _network->publishCommandResult(resultStr);
+            _network->publishRetry(std::to_string(_retryCount + 1));
+
+            _nextRetryTs = millis() + _retryDelay;
+
+            ++_retryCount;
+            finished = false;
         }
         else
         {
-            if(_retryCount < _nrOfRetries)
-            {
-                Log->print(F("Lock: Last command failed, retrying after "));
-                Log->print(_retryDelay);
-                Log->print(F(" milliseconds. Retry "));
-                Log->print(_retryCount + 1);
-                Log->print(" of ");
-                Log->println(_nrOfRetries);
-
-                _network->publishRetry(std::to_string(_retryCount + 1));
+            LOG_ERROR("Lock: Maximum number of retries exceeded, aborting.");
+            _network->publishCommandResult(resultStr, command.id);
+            _network->publishRetry("failed");
+            _retryCount = 0;
+            _nextRetryTs = 0;
+        }
+    }
+    postponeBleWatchdog();
 
-                _nextRetryTs = millis() + _retryDelay;
+    return finished;
+}
 
-                ++_retryCount;
-            }
-            else
-            {
-                Log->println(F("Lock: Maximum number of retries exceeded, aborting."));
-                _network->publishRetry("failed");
-                _retryCount = 0;
-                _nextRetryTs = 0;
-                _nextLockAction = (NukiLock::LockAction) 0xff;
-            }
-        }
-        postponeBleWatchdog();
+bool NukiWrapper::refreshDue(const unsigned long ts) const
+{
+    bool due = ts >= _nextLockStateUpdateTs || ts >= _nextBatteryReportTs || ts >= _nextConfigUpdateTs;
+    if(_hasKeypad && _keypadEnabled)
+    {
+        due = due || ts >= _nextKeypadUpdateTs;
     }
+    return due;
+}
 
-    if(_clearAuthData)
+bool NukiWrapper::bleWorkPending(const unsigned long ts) const
+{
+    // Mirrors the conditions in update() that start a GATT exchange. RSSI and HASS updates only use cached data or MQTT.
+    if(_statusUpdated || _disableHassRequested || _network->pendingQueryCommands() != 0)
     {
-        _network->clearAuthorizationInfo();
-        _clearAuthData = false;
+        return true;
     }
+    // A due refresh pulls the ones within NUKI_REFRESH_BATCH_WINDOW into the same connection
+    if(refreshDue(ts))
+    {
+        return true;
+    }
+    return !_commandQueue.empty() && ts > _nextRetryTs;
+}
 
-    memcpy(&_lastKeyTurnerState, &_keyTurnerState, sizeof(NukiLock::KeyTurnerState));
+unsigned long NukiWrapper::nextUpdateTs() const
+{
+    unsigned long ts = std::min(_nextLockStateUpdateTs, std::min(_nextBatteryReportTs, _nextConfigUpdateTs));
+    if(_hasKeypad && _keypadEnabled)
+    {
+        ts = std::min(ts, _nextKeypadUpdateTs);
+    }
+    if(_rssiPublishInterval > 0)
+    {
+        ts = std::min(ts, (unsigned long)_nextRssiTs);
+    }
+    if(!_commandQueue.empty())
+    {
+        ts = std::min(ts, _nextRetryTs);
+    }
+    if(_network->hassConfigPending())
+    {
+        ts = std::min(ts, _network->hassConfigNextUpdateTs());
+    }
+    if(_bleSessionActive)
+    {
+        ts = std::min(ts, _bleSessionEndTs);
+    }
+    return ts;
 }
 
 void NukiWrapper::lock()
 {
-    _nextLockAction = NukiLock::LockAction::Lock;
+    enqueueLockAction(NukiLock::LockAction::Lock);
 }
 
 void NukiWrapper::unlock()
 {
-    _nextLockAction = NukiLock::LockAction::Unlock;
+    enqueueLockAction(NukiLock::LockAction::Unlock);
 }
 
 void NukiWrapper::unlatch()
 {
-    _nextLockAction = NukiLock::LockAction::Unlatch;
+    enqueueLockAction(NukiLock::LockAction::Unlatch);
 }
 
 bool NukiWrapper::isPinSet()
@@ -292,11 +408,43 @@ void NukiWrapper::unpair()
     _nukiLock.unPairNuki();
     _deviceId->assignNewId();
     _paired = false;
+    updateBleScannerFilter();
+}
+
+void NukiWrapper::updateBleScannerFilter()
+{
+    // Once paired only advertisements of the own device are forwarded, pairing needs to see all devices
+    BleScanner::AdvertisementFilter filter;
+    if(_paired)
+    {
+        filter.addAddress(_nukiLock.getBleAddress());
+    }
+    _bleScanner->setFilter(&_nukiLock, filter);
+}
+
+// A session starts (or is extended) when commands are likely: after a beacon event, a GPIO or MQTT lock action.
+// The library then keeps the connection open for the session timeout instead of disconnecting right away.
+void NukiWrapper::updateBleSession(const unsigned long ts)
+{
+    if(_bleSessionTimeout == 0) return;
+
+    if(_bleSessionRequested)
+    {
+        _bleSessionRequested = false;
+        _bleSessionEndTs = ts + _bleSessionTimeout;
+    }
+
+    bool active = (long)(_bleSessionEndTs - ts) > 0;
+    if(active != _bleSessionActive)
+    {
+        _bleSessionActive = active;
+        _nukiLock.setDisconnectTimeout(active ? _bleSessionTimeout : NUKI_BLE_DISCONNECT_TIMEOUT);
+        LOG_DEBUG("BLE session %s", active ? "started" : "ended");
+    }
 }
 
 void NukiWrapper::updateKeyTurnerState()
 {
-    Log->print(F("Querying lock state: "));
     Nuki::CmdResult result =_nukiLock.requestKeyTurnerState(&_keyTurnerState);
 
     char resultStr[15];
@@ -306,6 +454,7 @@ void NukiWrapper::updateKeyTurnerState()
 
     if(result != Nuki::CmdResult::Success)
     {
+        LOG_WARN("Querying lock state: %s", resultStr);
         _retryLockstateCount++;
         postponeBleWatchdog();
         if(_retryLockstateCount < _nrOfRetries)
@@ -316,12 +465,21 @@ void NukiWrapper::updateKeyTurnerState()
     }
     _retryLockstateCount = 0;
 
+    bool changed = _keyTurnerState.lockState != _lastKeyTurnerState.lockState ||
+                   _keyTurnerState.trigger != _lastKeyTurnerState.trigger ||
+                   _keyTurnerState.lastLockAction != _lastKeyTurnerState.lastLockAction ||
+                   _keyTurnerState.lastLockActionCompletionStatus != _lastKeyTurnerState.lastLockActionCompletionStatus ||
+                   _keyTurnerState.doorSensorState != _lastKeyTurnerState.doorSensorState;
+    _lockStatePoll.onPoll(changed);
+    _nextLockStateUpdateTs = millis() + _lockStatePoll.interval();
+
     _network->publishKeyTurnerState(_keyTurnerState, _lastKeyTurnerState);
     updateGpioOutputs();
+    updateStatusSnapshot();
 
     char lockStateStr[20];
     lockstateToString(_keyTurnerState.lockState, lockStateStr);
-    Log->println(lockStateStr);
+    LOG_DEBUG("Lock state: %s", lockStateStr);
 
     if(_publishAuthData)
     {
@@ -333,21 +491,47 @@ void NukiWrapper::updateKeyTurnerState()
 
 void NukiWrapper::updateBatteryState()
 {
-    Log->print("Querying lock battery state: ");
     Nuki::CmdResult result = _nukiLock.requestBatteryReport(&_batteryReport);
-    printCommandResult(result);
+    printCommandResult("Querying lock battery state", result);
     if(result == Nuki::CmdResult::Success)
     {
+        // The voltage jitters between reports, only count larger steps as new data
+        bool changed = abs((int)_batteryReport.batteryVoltage - (int)_lastBatteryReport.batteryVoltage) >= NUKI_BATTERY_VOLTAGE_STEP ||
+                       _batteryReport.batteryDrain != _lastBatteryReport.batteryDrain ||
+                       _batteryReport.maxTurnCurrent != _lastBatteryReport.maxTurnCurrent ||
+                       _batteryReport.lockDistance != _lastBatteryReport.lockDistance;
+        _batteryPoll.onPoll(changed);
+        _nextBatteryReportTs = millis() + _batteryPoll.interval();
+        memcpy(&_lastBatteryReport, &_batteryReport, sizeof(NukiLock::BatteryReport));
+
         _network->publishBatteryReport(_batteryReport);
+        updateStatusSnapshot();
     }
     postponeBleWatchdog();
 }
 
 void NukiWrapper::updateConfig()
 {
+    NukiLock::Config previousConfig = _nukiConfig;
+    NukiLock::AdvancedConfig previousAdvancedConfig = _nukiAdvancedConfig;
+
     readConfig();
     readAdvancedConfig();
     _configRead = true;
+
+    if(_nukiConfigValid && _nukiAdvancedConfigValid)
+    {
+        // Only the published settings, the config also carries the lock's current time
+        bool changed = _nukiConfig.buttonEnabled != previousConfig.buttonEnabled ||
+                       _nukiConfig.ledEnabled != previousConfig.ledEnabled ||
+                       _nukiConfig.ledBrightness != previousConfig.ledBrightness ||
+                       _nukiConfig.singleLock != previousConfig.singleLock ||
+                       memcmp(_nukiConfig.firmwareVersion, previousConfig.firmwareVersion, sizeof(_nukiConfig.firmwareVersion)) != 0 ||
+                       _nukiAdvancedConfig.autoUnLockDisabled != previousAdvancedConfig.autoUnLockDisabled ||
+                       _nukiAdvancedConfig.autoLockEnabled != previousAdvancedConfig.autoLockEnabled;
+        _configPoll.onPoll(changed);
+        _nextConfigUpdateTs = millis() + _configPoll.interval();
+    }
     _hasKeypad = _nukiConfig.hasKeypad > 0 || _nukiConfig.hasKeypadV2;
     if(_nukiConfigValid)
     {
@@ -359,6 +543,7 @@ void NukiWrapper::updateConfig()
     {
         _network->publishAdvancedConfig(_nukiAdvancedConfig);
     }
+    updateStatusSnapshot();
 }
 
 void NukiWrapper::updateAuthData()
@@ -368,19 +553,36 @@ void NukiWrapper::updateAuthData()
     {
         return;
     }
-    delay(100);
 
+    // The count and the entries arrive as separate notifications, wait for them instead of sleeping a fixed time
+    unsigned long timeoutTs = millis() + NUKI_LOG_COUNT_TIMEOUT;
     uint16_t count = _nukiLock.getLogEntryCount();
+    while(count == 0 && (long)(millis() - timeoutTs) < 0)
+    {
+        delay(NUKI_LOG_POLL_INTERVAL);
+        count = _nukiLock.getLogEntryCount();
+    }
+    if(count == 0)
+    {
+        return;
+    }
 
-    result = _nukiLock.retrieveLogEntries(0, count < 5 ? count : 5, 1, false);
+    uint16_t requested = count < 5 ? count : 5;
+    result = _nukiLock.retrieveLogEntries(0, requested, 1, false);
     if(result != Nuki::CmdResult::Success)
     {
         return;
     }
-    delay(1000);
 
     std::list<NukiLock::LogEntry> log;
+    timeoutTs = millis() + NUKI_LOG_ENTRIES_TIMEOUT;
     _nukiLock.getLogEntries(&log);
+    while(log.size() < requested && (long)(millis() - timeoutTs) < 0)
+    {
+        delay(NUKI_LOG_POLL_INTERVAL);
+        log.clear();
+        _nukiLock.getLogEntries(&log);
+    }
 
     if(log.size() > 0)
     {
@@ -391,9 +593,8 @@ void NukiWrapper::updateAuthData()
 
 void NukiWrapper::updateKeypad()
 {
-    Log->print(F("Querying lock keypad: "));
     Nuki::CmdResult result = _nukiLock.retrieveKeypadEntries(0, 0xffff);
-    printCommandResult(result);
+    printCommandResult("Querying lock keypad", result);
     if(result == Nuki::CmdResult::Success)
     {
         std::list<NukiLock::KeypadEntry> entries;
@@ -408,7 +609,9 @@ void NukiWrapper::updateKeypad()
             _preferences->putUInt(preference_lock_max_keypad_code_count, _maxKeypadCodeCount);
         }
 
-        _network->publishKeypad(entries, _maxKeypadCodeCount);
+        bool changed = _network->publishKeypad(entries, _maxKeypadCodeCount);
+        _keypadPoll.onPoll(changed);
+        _nextKeypadUpdateTs = millis() + _keypadPoll.interval();
 
         _keypadCodeIds.clear();
         _keypadCodeIds.reserve(entries.size());
@@ -452,14 +655,12 @@ LockActionResult NukiWrapper::onLockActionReceivedCallback(const char *value)
     switch(_accessLevel)
     {
         case AccessLevel::Full:
-            nukiInst->_nextLockAction = action;
-            return LockActionResult::Success;
+            return nukiInst->onLockActionAccepted(action);
             break;
         case AccessLevel::LockOnly:
             if(action == NukiLock::LockAction::Lock)
             {
-                nukiInst->_nextLockAction = action;
-                return LockActionResult::Success;
+                return nukiInst->onLockActionAccepted(action);
             }
             return LockActionResult::AccessDenied;
             break;
@@ -470,14 +671,94 @@ LockActionResult NukiWrapper::onLockActionReceivedCallback(const char *value)
     }
 }
 
+LockActionResult NukiWrapper::onLockActionAccepted(const NukiLock::LockAction& action)
+{
+    uint32_t commandId = enqueueLockAction(action);
+    if(commandId == 0)
+    {
+        LOG_WARN("Lock: Command queue full, lock action dropped.");
+        return LockActionResult::QueueFull;
+    }
+    _network->publishCommandId(commandId);
+    return LockActionResult::Success;
+}
+
+uint32_t NukiWrapper::enqueueLockAction(const NukiLock::LockAction& action)
+{
+    NukiCommand command;
+    command.type = NukiCommandType::LockAction;
+    command.lockAction = (uint8_t)action;
+    command.enqueuedTs = millis();
+
+    uint32_t commandId = _commandQueue.push(command);
+    if(commandId != 0)
+    {
+        _bleSessionRequested = true;
+        wakeNukiTask();
+    }
+    return commandId;
+}
+
 void NukiWrapper::onConfigUpdateReceivedCallback(const char *topic, const char *value)
 {
-    nukiInst->onConfigUpdateReceived(topic, value);
+    NukiCommand command;
+    command.type = NukiCommandType::ConfigUpdate;
+    command.config.topic = topic;
+    strncpy(command.config.value, value, sizeof(command.config.value) - 1);
+
+    if(nukiInst->_commandQueue.push(command) == 0)
+    {
+        LOG_WARN("Lock: Command queue full, config update dropped.");
+        return;
+    }
+    wakeNukiTask();
 }
 
 void NukiWrapper::onKeypadCommandReceivedCallback(const char *command, const uint &id, const String &name, const String &code, const int& enabled)
 {
-    nukiInst->onKeypadCommandReceived(command, id, name, code, enabled);
+    NukiCommand keypadCommand;
+    keypadCommand.type = NukiCommandType::KeypadCommand;
+    strncpy(keypadCommand.keypad.action, command, sizeof(keypadCommand.keypad.action) - 1);
+    keypadCommand.keypad.codeId = id;
+    strncpy(keypadCommand.keypad.name, name.c_str(), sizeof(keypadCommand.keypad.name) - 1);
+    strncpy(keypadCommand.keypad.code, code.c_str(), sizeof(keypadCommand.keypad.code) - 1);
+    keypadCommand.keypad.enabled = enabled;
+
+    if(nukiInst->_commandQueue.push(keypadCommand) == 0)
+    {
+        nukiInst->_network->publishKeypadCommandResult("QueueFull");
+        return;
+    }
+    wakeNukiTask();
+}
+
+void NukiWrapper::onKeypadJsonCommandReceivedCallback(char* json)
+{
+    NukiKeypadBatch& batch = nukiInst->_keypadBatch;
+    if(!batch.acquire())
+    {
+        nukiInst->_network->publishKeypadJsonCommandResult("Busy");
+        return;
+    }
+
+    const char* error = batch.parse(json);
+    if(error != nullptr)
+    {
+        batch.release();
+        nukiInst->_network->publishKeypadJsonCommandResult(error);
+        return;
+    }
+
+    NukiCommand batchCommand;
+    batchCommand.type = NukiCommandType::KeypadBatch;
+
+    if(nukiInst->_commandQueue.push(batchCommand) == 0)
+    {
+        batch.release();
+        nukiInst->_network->publishKeypadJsonCommandResult("QueueFull");
+        return;
+    }
+    wakeNukiTask();
 }
 
 void NukiWrapper::gpioActionCallback(const GpioAction &action, const int& pin)
@@ -496,62 +777,96 @@ void NukiWrapper::gpioActionCallback(const GpioAction &action, const int& pin)
     }
 }
 
-void NukiWrapper::onConfigUpdateReceived(const char *topic, const char *value)
+void NukiWrapper::onConfigUpdateReceived(const uint32_t& commandId, const char *topic, const char *value)
 {
     if(_accessLevel != AccessLevel::Full) return;
 
+    Nuki::CmdResult result = (Nuki::CmdResult)-1;
+
     if(strcmp(topic, mqtt_topic_config_button_enabled) == 0)
     {
         bool newValue = atoi(value) > 0;
         if(!_nukiConfigValid || _nukiConfig.buttonEnabled == newValue) return;
-        _nukiLock.enableButton(newValue);
+        result = _nukiLock.enableButton(newValue);
         _nextConfigUpdateTs = millis() + 300;
     }
     if(strcmp(topic, mqtt_topic_config_led_enabled) == 0)
     {
         bool newValue = atoi(value) > 0;
         if(!_nukiConfigValid || _nukiConfig.ledEnabled == newValue) return;
-        _nukiLock.enableLedFlash(newValue);
+        result = _nukiLock.enableLedFlash(newValue);
         _nextConfigUpdateTs = millis() + 300;
     }
     else if(strcmp(topic, mqtt_topic_config_led_brightness) == 0)
     {
         int newValue = atoi(value);
         if(!_nukiConfigValid || _nukiConfig.ledBrightness == newValue) return;
-        _nukiLock.setLedBrightness(newValue);
+        result = _nukiLock.setLedBrightness(newValue);
         _nextConfigUpdateTs = millis() + 300;
     }
     if(strcmp(topic, mqtt_topic_config_single_lock) == 0)
     {
         bool newValue = atoi(value) > 0;
         if(!_nukiConfigValid || _nukiConfig.singleLock == newValue) return;
-        _nukiLock.enableSingleLock(newValue);
+        result = _nukiLock.enableSingleLock(newValue);
         _nextConfigUpdateTs = millis() + 300;
     }
     else if(strcmp(topic, mqtt_topic_config_auto_unlock) == 0)
     {
         bool newValue = !(atoi(value) > 0);
         if(!_nukiAdvancedConfigValid || _nukiAdvancedConfig.autoUnLockDisabled == newValue) return;
-        _nukiLock.disableAutoUnlock(newValue);
+        result = _nukiLock.disableAutoUnlock(newValue);
         _nextConfigUpdateTs = millis() + 300;
     }
     else if(strcmp(topic, mqtt_topic_config_auto_lock) == 0)
     {
         bool newValue = atoi(value) > 0;
         if(!_nukiAdvancedConfigValid || _nukiAdvancedConfig.autoLockEnabled == newValue) return;
-        _nukiLock.enableAutoLock(newValue);
+        result = _nukiLock.enableAutoLock(newValue);
         _nextConfigUpdateTs = millis() + 300;
     }
     else if(strcmp(topic, mqtt_topic_config_auto_lock) == 0)
     {
         bool newValue = atoi(value) > 0;
         if(!_nukiAdvancedConfigValid || _nukiAdvancedConfig.autoLockEnabled == newValue) return;
-        _nukiLock.enableAutoLock(newValue);
+        result = _nukiLock.enableAutoLock(newValue);
         _nextConfigUpdateTs = millis() + 300;
     }
+
+    if((int)result != -1)
+    {
+        char resultStr[15] = {0};
+        NukiLock::cmdResultToString(result, resultStr);
+        _network->publishConfigCommandResult(resultStr, commandId);
+    }
+}
+
+void NukiWrapper::onKeypadCommandReceived(const uint32_t& commandId, const char *command, const uint &id, const String &name, const String &code, const int& enabled)
+{
+    if(_accessLevel != AccessLevel::Full) return;
+
+    if(!_hasKeypad)
+    {
+        if(_configRead)
+        {
+            _network->publishKeypadCommandResult("KeypadNotAvailable", commandId);
+        }
+        return;
+    }
+    if(!_keypadEnabled || strcmp(command, "--") == 0)
+    {
+        return;
+    }
+
+    char resultStr[21] = {0};
+    if(executeKeypadCommand(command, id, name, code, enabled, resultStr))
+    {
+        updateKeypad();
+    }
+    _network->publishKeypadCommandResult(resultStr, commandId);
 }
 
-void NukiWrapper::onKeypadCommandReceived(const char *command, const uint &id, const String &name, const String &code, const int& enabled)
+void NukiWrapper::onKeypadBatchReceived(const uint32_t& commandId)
 {
     if(_accessLevel != AccessLevel::Full) return;
 
@@ -559,7 +874,7 @@ void NukiWrapper::onKeypadCommandReceived(const char *command, const uint &id, c
     {
         if(_configRead)
         {
-            _network->publishKeypadCommandResult("KeypadNotAvailable");
+            _network->publishKeypadJsonCommandResult("KeypadNotAvailable", commandId);
         }
         return;
     }
@@ -568,27 +883,47 @@ void NukiWrapper::onKeypadCommandReceived(const char *command, const uint &id, c
         return;
     }
 
+    // The entries are sent back to back so the BLE connection stays up, the keypad is only queried once afterwards
+    bool keypadChanged = false;
+    for(size_t i = 0; i < _keypadBatch.count(); ++i)
+    {
+        NukiKeypadOperation& operation = _keypadBatch[i];
+        if(executeKeypadCommand(operation.action, operation.codeId, operation.name, operation.code, operation.enabled, operation.result))
+        {
+            keypadChanged = true;
+        }
+    }
+
+    if(keypadChanged)
+    {
+        updateKeypad();
+    }
+    _network->publishKeypadJsonCommandResult("Completed", commandId, &_keypadBatch);
+}
+
+bool NukiWrapper::executeKeypadCommand(const char *command, const uint &id, const String &name, const String &code, const int& enabled, char* resultStr)
+{
     bool idExists = std::find(_keypadCodeIds.begin(), _keypadCodeIds.end(), id) != _keypadCodeIds.end();
     int codeInt = code.toInt();
     bool codeValid = codeInt > 100000 && codeInt < 1000000 && (code.indexOf('0') == -1);
-    NukiLock::CmdResult result = (NukiLock::CmdResult)-1;
+    NukiLock::CmdResult result;
 
     if(strcmp(command, "add") == 0)
     {
         if(name == "" || name == "--")
         {
-            _network->publishKeypadCommandResult("MissingParameterName");
-            return;
+            strcpy(resultStr, "MissingParameterName");
+            return false;
         }
         if(codeInt == 0)
         {
-            _network->publishKeypadCommandResult("MissingParameterCode");
-            return;
+            strcpy(resultStr, "MissingParameterCode");
+            return false;
         }
         if(!codeValid)
         {
-            _network->publishKeypadCommandResult("CodeInvalid");
-            return;
+            strcpy(resultStr, "CodeInvalid");
+            return false;
         }
 
         NukiLock::NewKeypadEntry entry;
@@ -597,41 +932,39 @@ void NukiWrapper::onKeypadCommandReceived(const char *command, const uint &id, c
         memcpy(&entry.name, name.c_str(), nameLen > 20 ? 20 : nameLen);
         entry.code = codeInt;
         result = _nukiLock.addKeypadEntry(entry);
-        Log->print("Add keypad code: "); Log->println((int)result);
-        updateKeypad();
+        LOG_INFO("Add keypad code: %d", (int)result);
     }
     else if(strcmp(command, "delete") == 0)
     {
         if(!idExists)
         {
-            _network->publishKeypadCommandResult("UnknownId");
-            return;
+            strcpy(resultStr, "UnknownId");
+            return false;
         }
         result = _nukiLock.deleteKeypadEntry(id);
-        Log->print("Delete keypad code: "); Log->println((int)result);
-        updateKeypad();
+        LOG_INFO("Delete keypad code: %d", (int)result);
     }
     else if(strcmp(command, "update") == 0)
     {
         if(name == "" || name == "--")
         {
-            _network->publishKeypadCommandResult("MissingParameterName");
-            return;
+            strcpy(resultStr, "MissingParameterName");
+            return false;
         }
         if(codeInt == 0)
         {
-            _network->publishKeypadCommandResult("MissingParameterCode");
-            return;
+            strcpy(resultStr, "MissingParameterCode");
+            return false;
         }
         if(!codeValid)
         {
-            _network->publishKeypadCommandResult("CodeInvalid");
-            return;
+            strcpy(resultStr, "CodeInvalid");
+            return false;
         }
         if(!idExists)
         {
-            _network->publishKeypadCommandResult("UnknownId");
-            return;
+            strcpy(resultStr, "UnknownId");
+            return false;
         }
 
         NukiLock::UpdatedKeypadEntry entry;
@@ -642,26 +975,16 @@ void NukiWrapper::onKeypadCommandReceived(const char *command, const uint &id, c
         entry.code = codeInt;
         entry.enabled = enabled == 0 ? 0 : 1;
         result = _nukiLock.updateKeypadEntry(entry);
-        Log->print("Update keypad code: "); Log->println((int)result);
-        updateKeypad();
-    }
-    else if(command == "--")
-    {
-        return;
+        LOG_INFO("Update keypad code: %d", (int)result);
     }
     else
     {
-        _network->publishKeypadCommandResult("UnknownCommand");
-        return;
+        strcpy(resultStr, "UnknownCommand");
+        return false;
     }
 
-    if((int)result != -1)
-    {
-        char resultStr[15];
-        memset(&resultStr, 0, sizeof(resultStr));
-        NukiLock::cmdResultToString(result, resultStr);
-        _network->publishKeypadCommandResult(resultStr);
-    }
+    NukiLock::cmdResultToString(result, resultStr);
+    return true;
 }
 
 const NukiLock::KeyTurnerState &NukiWrapper::keyTurnerState()
@@ -679,32 +1002,60 @@ const bool NukiWrapper::hasKeypad() const
     return _hasKeypad;
 }
 
+void NukiWrapper::getBleLatencyText(String& text, const String& linebreak) const
+{
+    text.concat("Lock action (BLE): ");
+    _lockActionLatency.getText(text);
+    text.concat(linebreak);
+    text.concat("Lock action in session (BLE): ");
+    _lockActionSessionLatency.getText(text);
+    text.concat(linebreak);
+    text.concat("Lock action (queued to result): ");
+    _commandLatency.getText(text);
+    text.concat(linebreak);
+}
+
+void NukiWrapper::getPollingText(String& text, const String& linebreak) const
+{
+    text.concat("Lock state: ");
+    _lockStatePoll.getText(text);
+    text.concat(linebreak);
+    text.concat("Battery: ");
+    _batteryPoll.getText(text);
+    text.concat(linebreak);
+    text.concat("Configuration: ");
+    _configPoll.getText(text);
+    text.concat(linebreak);
+    if(_hasKeypad && _keypadEnabled)
+    {
+        text.concat("Keypad: ");
+        _keypadPoll.getText(text);
+        text.concat(linebreak);
+    }
+}
+
 void NukiWrapper::notify(Nuki::EventType eventType)
 {
     if(eventType == Nuki::EventType::KeyTurnerStatusUpdated)
     {
         _statusUpdated = true;
+        _bleSessionRequested = true;
+        wakeNukiTask();
     }
 }
 
 void NukiWrapper::readConfig()
 {
-    Log->print(F("Reading config. Result: "));
     Nuki::CmdResult result = _nukiLock.requestConfig(&_nukiConfig);
     _nukiConfigValid = result == Nuki::CmdResult::Success;
-    char resultStr[20];
-    NukiLock::cmdResultToString(result, resultStr);
-    Log->println(resultStr);
+    printCommandResult("Reading config", result);
 }
 
 void NukiWrapper::readAdvancedConfig()
 {
-    Log->print(F("Reading advanced config. Result: "));
     Nuki::CmdResult result = _nukiLock.requestAdvancedConfig(&_nukiAdvancedConfig);
     _nukiAdvancedConfigValid = result == Nuki::CmdResult::Success;
-    char resultStr[20];
-    NukiLock::cmdResultToString(result, resultStr);
-    Log->println(resultStr);
+    printCommandResult("Reading advanced config", result);
 }
 
 void NukiWrapper::setupHASS()
@@ -717,8 +1068,6 @@ void NukiWrapper::setupHASS()
 
     _network->publishHASSConfig("SmartLock", baseTopic.c_str(),(char*)_nukiConfig.name, uidString, hasDoorSensor(), _hasKeypad, _publishAuthData,"lock", "unlock", "unlatch", "locked", "unlocked");
     _hassSetupCompleted = true;
-
-    Log->println("HASS setup for lock completed.");
 }
 
 bool NukiWrapper::hasDoorSensor() const
@@ -730,6 +1079,25 @@ bool NukiWrapper::hasDoorSensor() const
 
 void NukiWrapper::disableHASS()
 {
+    _disableHassRequested = true;
+    wakeNukiTask();
+
+    unsigned long timeout = millis() + NUKI_DISABLE_HASS_TIMEOUT;
+    while(_disableHassRequested && millis() < timeout)
+    {
+        delay(50);
+    }
+    if(_disableHassRequested)
+    {
+        LOG_WARN("Timeout removing the HASS config of the lock.");
+    }
+}
+
+void NukiWrapper::removeHASSConfig()
+{
+    // Stops a discovery run in progress, so the removed configs aren't published again
+    _hassEnabled = false;
+
     if(!_nukiConfigValid) // only ask for config once to save battery life
     {
         Nuki::CmdResult result = _nukiLock.requestConfig(&_nukiConfig);
@@ -743,7 +1111,7 @@ void NukiWrapper::disableHASS()
     }
     else
     {
-        Log->println(F("Unable to disable HASS. Invalid config received."));
+        LOG_WARN("Unable to disable HASS. Invalid config received.");
     }
 }
 
@@ -752,11 +1120,11 @@ const BLEAddress NukiWrapper::getBleAddress() const
     return _nukiLock.getBleAddress();
 }
 
-void NukiWrapper::printCommandResult(Nuki::CmdResult result)
+void NukiWrapper::printCommandResult(const char* operation, Nuki::CmdResult result)
 {
     char resultStr[15];
     NukiLock::cmdResultToString(result, resultStr);
-    Log->println(resultStr);
+    LOG_DEBUG("%s: %s", operation, resultStr);
 }
 
 std::string NukiWrapper::firmwareVersion() const
@@ -799,3 +1167,32 @@ void NukiWrapper::updateGpioOutputs()
     }
 }
 
+
+void NukiWrapper::updateStatusSnapshot()
+{
+    memset(&_status, 0, sizeof(_status));
+
+    _status.enabled = true;
+    _status.paired = _paired;
+    if(_paired)
+    {
+        strlcpy(_status.bleAddress, _nukiLock.getBleAddress().toString().c_str(), sizeof(_status.bleAddress));
+    }
+    strlcpy(_status.firmwareVersion, _firmwareVersion.c_str(), sizeof(_status.firmwareVersion));
+    strlcpy(_status.hardwareVersion, _hardwareVersion.c_str(), sizeof(_status.hardwareVersion));
+
+    NukiLock::lockstateToString(_keyTurnerState.lockState, _status.lockState);
+    NukiLock::triggerToString(_keyTurnerState.trigger, _status.trigger);
+    NukiLock::lockactionToString(_keyTurnerState.lastLockAction, _status.lastLockAction);
+    NukiLock::completionStatusToString(_keyTurnerState.lastLockActionCompletionStatus, _status.lastLockActionCompletionStatus);
+    NukiLock::doorSensorStateToString(_keyTurnerState.doorSensorState, _status.doorSensorState);
+
+    _status.batteryCritical = (_keyTurnerState.criticalBatteryState & 0b00000001) > 0;
+    _status.batteryCharging = (_keyTurnerState.criticalBatteryState & 0b00000010) > 0;
+    _status.batteryLevel = (_keyTurnerState.criticalBatteryState & 0b11111100) >> 1;
+    _status.keypadBatteryCritical = (_keyTurnerState.accessoryBatteryState & (1 << 7)) != 0 ? (_keyTurnerState.accessoryBatteryState & (1 << 6)) != 0 : false;
+    _status.batteryVoltage = _batteryReport.batteryVoltage;
+    _status.rssi = (int)_lastRssi;
+
+    _statusSnapshot->updateLock(_status);
+}
@@ -4,20 +4,28 @@
 #include "NukiConstants.h"
 #include "NukiDataTypes.h"
 #include "BleScanner.h"
+#include "LatencyHistogram.h"
+#include "AdaptivePollInterval.h"
 #include "NukiLock.h"
 #include "Gpio.h"
 #include "AccessLevel.h"
 #include "LockActionResult.h"
 #include "NukiDeviceId.h"
+#include "NukiCommandQueue.h"
+#include "NukiKeypadBatch.h"
+#include "StatusSnapshot.h"
+#include <atomic>
 
 class NukiWrapper : public Nuki::SmartlockEventHandler
 {
 public:
-    NukiWrapper(const std::string& deviceName, NukiDeviceId* deviceId, BleScanner::Scanner* scanner, NetworkLock* network, Gpio* gpio, Preferences* preferences);
+    NukiWrapper(const std::string& deviceName, NukiDeviceId* deviceId, BleScanner::Scanner* scanner, NetworkLock* network, Gpio* gpio, StatusSnapshot* statusSnapshot, Preferences* preferences);
     virtual ~NukiWrapper();
 
     void initialize(const bool& firstStart);
     void update();
+    unsigned long nextUpdateTs() const;
+    bool bleWorkPending(const unsigned long ts) const; // true if the next update() talks to the device
 
     void lock();
     void unlock();
@@ -27,6 +35,8 @@ public:
     void setPin(const uint16_t pin);
     void unpair();
     
+    // Removes the HASS discovery configs on the nuki task and waits until that is done (at most NUKI_DISABLE_HASS_TIMEOUT).
+    // Discovery stays disabled until the next restart.
     void disableHASS();
 
     void disableWatchdog();
@@ -34,6 +44,8 @@ public:
     const NukiLock::KeyTurnerState& keyTurnerState();
     const bool isPaired() const;
     const bool hasKeypad() const;
+    void getBleLatencyText(String& text, const String& linebreak = "\n") const;
+    void getPollingText(String& text, const String& linebreak = "\n") const;
     bool hasDoorSensor() const;
     const BLEAddress getBleAddress() const;
 
@@ -46,11 +58,20 @@ private:
     static LockActionResult onLockActionReceivedCallback(const char* value);
     static void onConfigUpdateReceivedCallback(const char* topic, const char* value);
     static void onKeypadCommandReceivedCallback(const char* command, const uint& id, const String& name, const String& code, const int& enabled);
+    static void onKeypadJsonCommandReceivedCallback(char* json);
     static void gpioActionCallback(const GpioAction& action, const int& pin);
 
-    void onConfigUpdateReceived(const char* topic, const char* value);
-    void onKeypadCommandReceived(const char* command, const uint& id, const String& name, const String& code, const int& enabled);
-
+    LockActionResult onLockActionAccepted(const NukiLock::LockAction& action);
+    uint32_t enqueueLockAction(const NukiLock::LockAction& action);
+    bool processLockAction(const NukiCommand& command);
+    void onConfigUpdateReceived(const uint32_t& commandId, const char* topic, const char* value);
+    void onKeypadCommandReceived(const uint32_t& commandId, const char* command, const uint& id, const String& name, const String& code, const int& enabled);
+    void onKeypadBatchReceived(const uint32_t& commandId);
+    bool executeKeypadCommand(const char* command, const uint& id, const String& name, const String& code, const int& enabled, char* resultStr); // resultStr at least 21 characters
+
+    void updateBleScannerFilter();
+    void updateBleSession(const unsigned long ts);
+    bool refreshDue(const unsigned long ts) const; // true if at least one status refresh is due
     void updateKeyTurnerState();
     void updateBatteryState();
     void updateConfig();
@@ -59,13 +80,15 @@ private:
     void postponeBleWatchdog();
 
     void updateGpioOutputs();
+    void updateStatusSnapshot();
+    void removeHASSConfig();
 
     void readConfig();
     void readAdvancedConfig();
     
     void setupHASS();
 
-    void printCommandResult(Nuki::CmdResult result);
+    void printCommandResult(const char* operation, Nuki::CmdResult result);
 
     NukiLock::LockAction lockActionToEnum(const char* str); // char array at least 14 characters
 
@@ -75,6 +98,8 @@ private:
     BleScanner::Scanner* _bleScanner = nullptr;
     NetworkLock* _network = nullptr;
     Gpio* _gpio = nullptr;
+    StatusSnapshot* _statusSnapshot = nullptr;
+    DeviceStatus _status; // rebuilt by updateStatusSnapshot(), a member to keep it off the nuki task stack
     Preferences* _preferences;
     int _intervalLockstate = 0; // seconds
     int _intervalBattery = 0; // seconds
@@ -97,6 +122,7 @@ private:
     bool _nukiAdvancedConfigValid = false;
     bool _hassEnabled = false;
     bool _hassSetupCompleted = false;
+    std::atomic<bool> _disableHassRequested{false}; // set by disableHASS(), cleared by the nuki task
 
     bool _paired = false;
     bool _statusUpdated = false;
@@ -118,7 +144,24 @@ private:
     unsigned long _nextRssiTs = 0;
     unsigned long _lastRssi = 0;
     unsigned long _disableBleWatchdogTs = 0;
+
+    // Effective refresh intervals, backed off while polls return unchanged data
+    AdaptivePollInterval _lockStatePoll;
+    AdaptivePollInterval _batteryPoll;
+    AdaptivePollInterval _configPoll;
+    AdaptivePollInterval _keypadPoll;
+
+    // While a session is active the connection is kept open after each exchange, so follow-up commands skip the handshake
+    unsigned long _bleSessionTimeout = 0; // ms, 0 = disconnect after each exchange
+    unsigned long _bleSessionEndTs = 0;
+    bool _bleSessionActive = false;
+    volatile bool _bleSessionRequested = false; // set by command producers and the beacon event handler
+
+    LatencyHistogram _lockActionLatency; // BLE lock action call, outside of a session
+    LatencyHistogram _lockActionSessionLatency; // BLE lock action call, during a session
+    LatencyHistogram _commandLatency; // from enqueueing to a successful result
     std::string _firmwareVersion = "";
     std::string _hardwareVersion = "";
-    volatile NukiLock::LockAction _nextLockAction = (NukiLock::LockAction)0xff;
+    NukiCommandQueue _commandQueue;
+    NukiKeypadBatch _keypadBatch;
 };
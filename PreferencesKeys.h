@@ -45,6 +45,7 @@
 #define preference_cred_user "crdusr"
 #define preference_cred_password "crdpass"
 #define preference_publish_authdata "pubauth"
+#define preference_publish_json_state "pubjsonstate"
 #define preference_gpio_locking_enabled "gpiolck" // obsolete
 #define preference_gpio_configuration "gpiocfg"
 #define preference_publish_debug_info "pubdbg"
@@ -53,6 +54,9 @@
 #define preference_has_mac_byte_0 "macb0"
 #define preference_has_mac_byte_1 "macb1"
 #define preference_has_mac_byte_2 "macb2"
+#define preference_hass_hashes_lock "hasshashlck"
+#define preference_hass_hashes_opener "hasshashopn"
+#define preference_ble_session_timeout "bleSession"
 
 class DebugPreferences
 {
@@ -72,8 +76,9 @@ private:
             preference_keypad_control_enabled, preference_access_level,
             preference_register_as_app, preference_command_nr_of_retries,
             preference_command_retry_delay, preference_cred_user, preference_cred_password, preference_publish_authdata,
-            preference_publish_debug_info, preference_presence_detection_timeout,
+            preference_publish_json_state, preference_publish_debug_info, preference_presence_detection_timeout,
             preference_has_mac_saved, preference_has_mac_byte_0, preference_has_mac_byte_1, preference_has_mac_byte_2,
+            preference_ble_session_timeout,
     };
     std::vector<char*> _redact =
     {
@@ -85,7 +90,7 @@ private:
     {
             preference_started_before, preference_mqtt_log_enabled, preference_lock_enabled, preference_opener_enabled,
             preference_restart_on_disconnect, preference_keypad_control_enabled, preference_register_as_app, preference_ip_dhcp_enabled,
-            preference_publish_authdata, preference_has_mac_saved, preference_publish_debug_info
+            preference_publish_authdata, preference_publish_json_state, preference_has_mac_saved, preference_publish_debug_info
     };
 
     const bool isRedacted(const char* key) const
@@ -113,70 +118,80 @@ private:
         return i == 0 ? "" : "***";
     }
 
-    const void appendPreferenceInt8(Preferences *preferences, String& s, const char* description, const char* key)
+    template<typename T>
+    const void appendPreferenceInt8(Preferences *preferences, T& s, const char* description, const char* key)
     {
         s.concat(description);
         s.concat(": ");
         s.concat(isRedacted(key) ? redact(preferences->getChar(key)) : String(preferences->getChar(key)));
         s.concat("\n");
     }
-    const void appendPreferenceUInt8(Preferences *preferences, String& s, const char* description, const char* key)
+    template<typename T>
+    const void appendPreferenceUInt8(Preferences *preferences, T& s, const char* description, const char* key)
     {
         s.concat(description);
         s.concat(": ");
         s.concat(isRedacted(key) ? redact(preferences->getUChar(key)) : String(preferences->getUChar(key)));
         s.concat("\n");
     }
-    const void appendPreferenceInt16(Preferences *preferences, String& s, const char* description, const char* key)
+    template<typename T>
+    const void appendPreferenceInt16(Preferences *preferences, T& s, const char* description, const char* key)
     {
         s.concat(description);
         s.concat(": ");
         s.concat(isRedacted(key) ? redact(preferences->getShort(key)) : String(preferences->getShort(key)));
         s.concat("\n");
     }
-    const void appendPreferenceUInt16(Preferences *preferences, String& s, const char* description, const char* key)
+    template<typename T>
+    const void appendPreferenceUInt16(Preferences *preferences, T& s, const char* description, const char* key)
     {
         s.concat(description);
         s.concat(": ");
         s.concat(isRedacted(key) ? redact(preferences->getUShort(key)) : String(preferences->getUShort(key)));
         s.concat("\n");
     }
-    const void appendPreferenceInt32(Preferences *preferences, String& s, const char* description, const char* key)
+    template<typename T>
+    const void appendPreferenceInt32(Preferences *preferences, T& s, const char* description, const char* key)
     {
         s.concat(description);
         s.concat(": ");
         s.concat(isRedacted(key) ? redact(preferences->getInt(key)) : String(preferences->getInt(key)));
         s.concat("\n");
     }
-    const void appendPreferenceUInt32(Preferences *preferences, String& s, const char* description, const char* key)
+    template<typename T>
+    const void appendPreferenceUInt32(Preferences *preferences, T& s, const char* description, const char* key)
     {
         s.concat(description);
         s.concat(": ");
         s.concat(isRedacted(key) ? redact(preferences->getUInt(key)) : String(preferences->getUInt(key)));
         s.concat("\n");
     }
-    const void appendPreferenceInt64(Preferences *preferences, String& s, const char* description, const char* key)
+    template<typename T>
+    const void appendPreferenceInt64(Preferences *preferences, T& s, const char* description, const char* key)
     {
         s.concat(description);
         s.concat(": ");
         s.concat(isRedacted(key) ? redact(preferences->getLong64(key)) : String(preferences->getLong64(key)));
         s.concat("\n");
     }
-    const void appendPreferenceUInt64(Preferences *preferences, String& s, const char* description, const char* key)
+    template<typename T>
+    const void appendPreferenceUInt64(Preferences *preferences, T& s, const char* description, const char* key)
     {
         s.concat(description);
         s.concat(": ");
         s.concat(isRedacted(key) ? redact(preferences->getULong64(key)) : String(preferences->getULong64(key)));
         s.concat("\n");
     }
-    const void appendPreferenceBool(Preferences *preferences, String& s, const char* description, const char* key)
+    template<typename T>
+    const void appendPreferenceBool(Preferences *preferences, T& s, const char* description, const char* key)
     {
         s.concat(description);
         s.concat(": ");
         s.concat(preferences->getBool(key) ? "true" : "false");
         s.concat("\n");
     }
-    const void appendPreferenceString(Preferences *preferences, String& s, const char* description, const char* key)
+    template<typename T>
+    const void appendPreferenceString(Preferences *preferences, T& s, const char* description, const char* key)
     {
         s.concat(description);
         s.concat(": ");
@@ -184,7 +199,8 @@ private:
         s.concat("\n");
     }
 
-    const void appendPreference(Preferences *preferences, String& s, const char* key)
+    template<typename T>
+    const void appendPreference(Preferences *preferences, T& s, const char* key)
     {
         if(std::find(_boolPrefs.begin(), _boolPrefs.end(), key) != _boolPrefs.end())
         {
@@ -231,13 +247,18 @@ public:
     const String preferencesToString(Preferences *preferences)
     {
         String s = "";
+        appendPreferences(preferences, s);
+        return s;
+    }
 
+    // Appends to anything with String compatible concat(), e.g. a streamed web page
+    template<typename T>
+    void appendPreferences(Preferences *preferences, T& s)
+    {
         for(const auto& key : _keys)
         {
             appendPreference(preferences, s, key);
         }
-
-        return s;
     }
 
 };
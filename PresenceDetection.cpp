@@ -1,15 +1,15 @@
 #include "PresenceDetection.h"
 #include "PreferencesKeys.h"
 #include "Logger.h"
-#include "CharBuffer.h"
 
-PresenceDetection::PresenceDetection(Preferences* preferences, BleScanner::Scanner *bleScanner, Network* network, char* buffer, size_t bufferSize)
+PresenceDetection::PresenceDetection(Preferences* preferences, BleScanner::Scanner *bleScanner, Network* network)
 : _preferences(preferences),
   _bleScanner(bleScanner),
-  _network(network),
-  _csv(buffer),
-  _bufferSize(bufferSize)
+  _network(network)
 {
+    _csv = new char[PRESENCE_CSV_BUFFER_SIZE];
+    _events = new char[PRESENCE_EVENTS_BUFFER_SIZE];
+
     _timeout = _preferences->getInt(preference_presence_detection_timeout) * 1000;
     if(_timeout == 0)
     {
@@ -28,8 +28,10 @@ PresenceDetection::~PresenceDetection()
 
     _network = nullptr;
 
-    delete _csv;
+    delete[] _csv;
     _csv = nullptr;
+    delete[] _events;
+    _events = nullptr;
 }
 
 void PresenceDetection::initialize()
@@ -37,51 +39,160 @@ void PresenceDetection::initialize()
     _bleScanner->subscribe(this);
 }
 
+bool PresenceDetection::enabled() const
+{
+    return _timeout >= 0;
+}
+
 void PresenceDetection::update()
 {
     delay(3000);
 
     if(_timeout < 0) return;
-    memset(_csv, 0, _bufferSize);
 
-    if(_devices.size() == 0)
+    // The network task hasn't published the previous output yet, the buffers are still in use
+    if(_network->presencePublishPending()) return;
+
+    unsigned long ts = millis();
+    bool devicesChanged = buildEvents(ts);
+
+    if(devicesChanged || _nextSnapshotTs == 0 || (long)(ts - _nextSnapshotTs) >= 0)
     {
-        strcpy(_csv, ";;");
+        _nextSnapshotTs = ts + PRESENCE_SNAPSHOT_INTERVAL;
+        buildCsv(ts);
         _network->publishPresenceDetection(_csv);
-        return;
     }
+}
 
-    _csvIndex = 0;
-    long ts = millis();
-    for(auto it : _devices)
+bool PresenceDetection::buildEvents(const unsigned long ts)
+{
+    JsonWriter json(_events, PRESENCE_EVENTS_BUFFER_SIZE);
+    json.beginArray();
+
+    bool devicesChanged = false;
+    bool hasEvents = false;
+    size_t index = 0;
+
+    while(index < PRESENCE_TABLE_SIZE)
     {
-        if(ts - _timeout < it.second.timestamp)
+        // Devices that don't fit are handled on the next pass
+        if(json.length() + PRESENCE_EVENT_MAX_SIZE >= PRESENCE_EVENTS_BUFFER_SIZE)
         {
-            buildCsv(it.second);
+            break;
         }
 
-        // Prevent csv buffer overflow
-        if(_csvIndex > _bufferSize - (sizeof(it.second.name) + sizeof(it.second.address) + 10))
+        // The slot is updated under the lock, the event is written from a copy afterwards
+        const char* event = nullptr;
+        bool removed = false;
+        bool arrived = false;
+
+        portENTER_CRITICAL(&_devicesMux);
+        PdDevice& slot = _devices.slot(index);
+        PdDevice device = slot;
+        if(device.address != 0)
         {
-            break;
+            if(expired(device, ts))
+            {
+                event = device.announced ? "leave" : nullptr;
+                _devices.removeSlot(index);
+                removed = true;
+            }
+            else if(!device.announced)
+            {
+                event = "arrive";
+                arrived = true;
+                slot.announced = true;
+                slot.rssiBucket = rssiBucket(device);
+            }
+            else if(device.hasRssi && rssiBucket(device) != device.rssiBucket)
+            {
+                event = "rssi";
+                slot.rssiBucket = rssiBucket(device);
+            }
+        }
+        portEXIT_CRITICAL(&_devicesMux);
+
+        if(event != nullptr)
+        {
+            addEvent(json, device, event);
+            hasEvents = true;
+        }
+        if(removed || arrived)
+        {
+            devicesChanged = true;
+        }
+
+        // Backward shift may have moved the next device of the cluster into this slot
+        if(!removed)
+        {
+            ++index;
         }
     }
 
-    _csv[_csvIndex-1] = 0x00;
+    json.endArray();
+
+    if(hasEvents && json.ok())
+    {
+        _network->publishPresenceEvents(_events);
+    }
 
-//    Log->print("Devices found: ");
-//    Log->println(_devices.size());
-    _network->publishPresenceDetection(_csv);
+    return devicesChanged;
 }
 
+void PresenceDetection::addEvent(JsonWriter& json, const PdDevice& device, const char* event)
+{
+    char address[18];
+    formatAddress(device.address, address);
+
+    json.beginObject();
+    json.add("event", event);
+    json.add("address", address);
+    json.add("name", device.name);
+    if(device.hasRssi)
+    {
+        json.addInt("rssi", device.rssi);
+    }
+    json.endObject();
+}
 
-void PresenceDetection::buildCsv(const PdDevice &device)
+void PresenceDetection::buildCsv(const unsigned long ts)
 {
-    for(int i = 0; i < 17; i++)
+    memset(_csv, 0, PRESENCE_CSV_BUFFER_SIZE);
+    _csvIndex = 0;
+
+    for(size_t i = 0; i < PRESENCE_TABLE_SIZE; i++)
     {
-        _csv[_csvIndex] = device.address[i];
-        ++_csvIndex;
+        portENTER_CRITICAL(&_devicesMux);
+        const PdDevice device = _devices.slot(i);
+        portEXIT_CRITICAL(&_devicesMux);
+
+        if(device.address == 0 || expired(device, ts))
+        {
+            continue;
+        }
+
+        // Prevent csv buffer overflow
+        if(_csvIndex > PRESENCE_CSV_BUFFER_SIZE - (sizeof(device.name) + 18 + 10))
+        {
+            break;
+        }
+
+        appendCsv(device);
+    }
+
+    if(_csvIndex == 0)
+    {
+        strcpy(_csv, ";;");
+        return;
     }
+
+    _csv[_csvIndex-1] = 0x00;
+}
+
+void PresenceDetection::appendCsv(const PdDevice &device)
+{
+    formatAddress(device.address, &_csv[_csvIndex]);
+    _csvIndex += 17;
     _csv[_csvIndex] = ';';
     ++_csvIndex;
 
@@ -114,86 +225,114 @@ void PresenceDetection::buildCsv(const PdDevice &device)
     _csvIndex++;
 }
 
-void PresenceDetection::onResult(NimBLEAdvertisedDevice *device)
+bool PresenceDetection::expired(const PdDevice& device, const unsigned long ts) const
 {
-    std::string addressStr = device->getAddress().toString();
-    char addrArrComp[13] = {0};
+    // Signed, the scanner may have updated the timestamp after ts was taken
+    return (long)(ts - device.timestamp) > _timeout;
+}
 
-//    Log->println(addressStr.c_str());
+int8_t PresenceDetection::rssiBucket(const PdDevice& device)
+{
+    return device.rssi / PRESENCE_RSSI_BUCKET_SIZE;
+}
 
-    addrArrComp[0] = addressStr.at(0);
-    addrArrComp[1] = addressStr.at(1);
-    addrArrComp[2] = addressStr.at(3);
-    addrArrComp[3] = addressStr.at(4);
-    addrArrComp[4] = addressStr.at(6);
-    addrArrComp[5] = addressStr.at(7);
-    addrArrComp[6] = addressStr.at(9);
-    addrArrComp[7] = addressStr.at(10);
-    addrArrComp[8] = addressStr.at(12);
-    addrArrComp[9] = addressStr.at(13);
-    addrArrComp[10] = addressStr.at(15);
-    addrArrComp[11] = addressStr.at(16);
+void PresenceDetection::formatAddress(const uint64_t address, char* out)
+{
+    static const char hex[] = "0123456789abcdef";
 
-    long long addr = strtoll(addrArrComp, nullptr, 16);
+    for(int shift = 40; shift >= 0; shift -= 8)
+    {
+        uint8_t b = (address >> shift) & 0xff;
+        *out++ = hex[b >> 4];
+        *out++ = hex[b & 0x0f];
+        *out++ = ':';
+    }
+    *(out - 1) = 0;
+}
 
-    auto it = _devices.find(addr);
-    if(it == _devices.end())
+void PresenceDetection::onResult(NimBLEAdvertisedDevice *device)
+{
+    uint64_t addr = device->getAddress();
+    unsigned long ts = millis();
+    bool hasRssi = device->haveRSSI();
+    int rssi = hasRssi ? device->getRSSI() : 0;
+
+    portENTER_CRITICAL(&_devicesMux);
+    PdDevice* pdDevice = _devices.find(addr);
+    if(pdDevice != nullptr)
     {
+        updateDevice(*pdDevice, ts, hasRssi, rssi);
+    }
+    portEXIT_CRITICAL(&_devicesMux);
 
-        PdDevice pdDevice;
+    if(pdDevice != nullptr)
+    {
+        return;
+    }
 
-        int i=0;
-        size_t len = addressStr.length();
-        while(i < len)
-        {
-            pdDevice.address[i] = addressStr.at(i);
-            ++i;
-        }
+    // Only named devices are tracked, the name is parsed outside of the lock
+    char name[sizeof(pdDevice->name)];
+    if(!readName(device, name, sizeof(name)))
+    {
+        return;
+    }
+
+    portENTER_CRITICAL(&_devicesMux);
+    pdDevice = _devices.insert(addr);
+    if(pdDevice != nullptr)
+    {
+        memcpy(pdDevice->name, name, sizeof(pdDevice->name));
+        updateDevice(*pdDevice, ts, hasRssi, rssi);
+    }
+    portEXIT_CRITICAL(&_devicesMux);
+}
+
+void PresenceDetection::updateDevice(PdDevice& device, const unsigned long ts, const bool hasRssi, const int rssi)
+{
+    device.timestamp = ts;
+    if(hasRssi)
+    {
+        device.hasRssi = true;
+        device.rssi = rssi;
+    }
+}
+
+bool PresenceDetection::readName(NimBLEAdvertisedDevice* advertisedDevice, char* name, const size_t size)
+{
+    // Walk the advertisement structures (length, type, data) instead of getName(), which allocates a std::string
+    const uint8_t* payload = advertisedDevice->getPayload();
+    size_t length = advertisedDevice->getPayloadLength();
+    size_t index = 0;
+    bool found = false;
 
-        if(device->haveRSSI())
+    while(index + 1 < length && payload[index] != 0)
+    {
+        uint8_t fieldLength = payload[index];
+        uint8_t type = payload[index + 1];
+        if(index + 1 + fieldLength > length)
         {
-            pdDevice.hasRssi = true;
-            pdDevice.rssi = device->getRSSI();
+            break;
         }
 
-        std::string nameStr = "-";
-        if(device->haveName())
+        if(type == BLE_HS_ADV_TYPE_COMP_NAME || (type == BLE_HS_ADV_TYPE_INCOMP_NAME && !found))
         {
-            std::string nameStr = device->getName();
-
-            i=0;
-            len = nameStr.length();
-            while(i < len && i < sizeof(pdDevice.name)-1)
+            size_t nameLength = fieldLength - 1;
+            if(nameLength > size - 1)
             {
-                pdDevice.name[i] = nameStr.at(i);
-                ++i;
+                nameLength = size - 1;
             }
+            memcpy(name, &payload[index + 2], nameLength);
+            name[nameLength] = 0;
+            found = true;
 
-            pdDevice.timestamp = millis();
-
-            _devices[addr] = pdDevice;
-        }
-    }
-    else
-    {
-        it->second.timestamp = millis();
-        if(device->haveRSSI())
-        {
-            it->second.hasRssi = true;
-            it->second.rssi = device->getRSSI();
+            if(type == BLE_HS_ADV_TYPE_COMP_NAME)
+            {
+                break;
+            }
         }
-    }
 
-//    if(device->haveName())
-//    {
-//        Log->print(" | ");
-//        Log->print(device->getName().c_str());
-//        if(device->haveRSSI())
-//        {
-//            Log->print(" | ");
-//            Log->print(device->getRSSI());
-//        }
-//    }
-//    Log->println();
+        index += fieldLength + 1;
+    }
 
-}
\ No newline at end of file
+    return found;
+}
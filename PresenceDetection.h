@@ -3,36 +3,47 @@
 #include "BleScanner.h"
 #include "BleInterfaces.h"
 #include "Network.h"
+#include "PresenceDeviceTable.h"
+#include "JsonWriter.h"
 
-struct PdDevice
-{
-    char address[18] = {0};
-    char name[30] = {0};
-    unsigned long timestamp = 0;
-    int rssi = 0;
-    bool hasRssi = false;
-};
+#define PRESENCE_CSV_BUFFER_SIZE 4096
+#define PRESENCE_EVENTS_BUFFER_SIZE 2048
+#define PRESENCE_EVENT_MAX_SIZE 256 // worst case size of one event, including an escaped name
+#define PRESENCE_SNAPSHOT_INTERVAL 300000 // ms, the device list is republished at least this often
+#define PRESENCE_RSSI_BUCKET_SIZE 10 // dBm, smaller RSSI changes don't generate an event
 
 class PresenceDetection : public BleScanner::Subscriber
 {
 public:
-    PresenceDetection(Preferences* preferences, BleScanner::Scanner* bleScanner, Network* network, char* buffer, size_t bufferSize);
+    PresenceDetection(Preferences* preferences, BleScanner::Scanner* bleScanner, Network* network);
     virtual ~PresenceDetection();
 
     void initialize();
     void update();
+    bool enabled() const; // disabled with a negative timeout
 
     void onResult(NimBLEAdvertisedDevice* advertisedDevice) override;
 
 private:
-    void buildCsv(const PdDevice& device);
+    bool buildEvents(const unsigned long ts);
+    void addEvent(JsonWriter& json, const PdDevice& device, const char* event);
+    void buildCsv(const unsigned long ts);
+    void appendCsv(const PdDevice& device);
+    bool expired(const PdDevice& device, const unsigned long ts) const;
+    static int8_t rssiBucket(const PdDevice& device);
+    static void formatAddress(const uint64_t address, char* out); // out at least 18 characters
+    static void updateDevice(PdDevice& device, const unsigned long ts, const bool hasRssi, const int rssi);
+    static bool readName(NimBLEAdvertisedDevice* advertisedDevice, char* name, const size_t size);
 
     Preferences* _preferences;
     BleScanner::Scanner* _bleScanner;
     Network* _network;
-    char* _csv = {0};
-    size_t _bufferSize = 0;
-    std::map<long long, PdDevice> _devices;
+    char* _csv = nullptr;
+    char* _events = nullptr;
+    PresenceDeviceTable _devices;
+    // Guards _devices, the scanner callback inserts while the presence task updates and removes. Held per slot only.
+    portMUX_TYPE _devicesMux = portMUX_INITIALIZER_UNLOCKED;
     int _timeout = 20000;
     int _csvIndex = 0;
+    unsigned long _nextSnapshotTs = 0;
 };
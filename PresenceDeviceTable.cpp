@@ -0,0 +1,116 @@
+#include "PresenceDeviceTable.h"
+
+static_assert((PRESENCE_TABLE_SIZE & (PRESENCE_TABLE_SIZE - 1)) == 0, "PRESENCE_TABLE_SIZE must be a power of two");
+
+PdDevice* PresenceDeviceTable::find(const uint64_t address)
+{
+    size_t index = home(address);
+
+    while(_slots[index].address != 0)
+    {
+        if(_slots[index].address == address)
+        {
+            return &_slots[index];
+        }
+        index = (index + 1) & (PRESENCE_TABLE_SIZE - 1);
+    }
+
+    return nullptr;
+}
+
+PdDevice* PresenceDeviceTable::insert(const uint64_t address)
+{
+    if(address == 0)
+    {
+        return nullptr;
+    }
+
+    PdDevice* device = find(address);
+    if(device != nullptr)
+    {
+        return device;
+    }
+
+    if(_count >= PRESENCE_TABLE_MAX_DEVICES && !evictOldestUnannounced())
+    {
+        return nullptr;
+    }
+
+    size_t index = home(address);
+    while(_slots[index].address != 0)
+    {
+        index = (index + 1) & (PRESENCE_TABLE_SIZE - 1);
+    }
+
+    _slots[index] = PdDevice();
+    _slots[index].address = address;
+    ++_count;
+
+    return &_slots[index];
+}
+
+size_t PresenceDeviceTable::size() const
+{
+    return _count;
+}
+
+PdDevice& PresenceDeviceTable::slot(const size_t index)
+{
+    return _slots[index];
+}
+
+const PdDevice& PresenceDeviceTable::slot(const size_t index) const
+{
+    return _slots[index];
+}
+
+size_t PresenceDeviceTable::home(const uint64_t address) const
+{
+    // Fibonacci hashing, the upper bits of the product depend on all address bytes
+    return (size_t)((address * 0x9E3779B97F4A7C15ull) >> 32) & (PRESENCE_TABLE_SIZE - 1);
+}
+
+void PresenceDeviceTable::removeSlot(size_t index)
+{
+    size_t next = (index + 1) & (PRESENCE_TABLE_SIZE - 1);
+
+    while(_slots[next].address != 0)
+    {
+        size_t nextHome = home(_slots[next].address);
+        // Move the device back unless its home slot lies cyclically in (index, next]
+        bool inRange = index <= next ? (index < nextHome && nextHome <= next) : (index < nextHome || nextHome <= next);
+        if(!inRange)
+        {
+            _slots[index] = _slots[next];
+            index = next;
+        }
+        next = (next + 1) & (PRESENCE_TABLE_SIZE - 1);
+    }
+
+    _slots[index] = PdDevice();
+    --_count;
+}
+
+bool PresenceDeviceTable::evictOldestUnannounced()
+{
+    unsigned long ts = millis();
+    size_t oldest = PRESENCE_TABLE_SIZE;
+    unsigned long oldestAge = 0;
+
+    for(size_t i = 0; i < PRESENCE_TABLE_SIZE; i++)
+    {
+        if(_slots[i].address != 0 && !_slots[i].announced && (oldest == PRESENCE_TABLE_SIZE || ts - _slots[i].timestamp >= oldestAge))
+        {
+            oldest = i;
+            oldestAge = ts - _slots[i].timestamp;
+        }
+    }
+
+    if(oldest == PRESENCE_TABLE_SIZE)
+    {
+        return false;
+    }
+
+    removeSlot(oldest);
+    return true;
+}
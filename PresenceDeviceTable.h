@@ -0,0 +1,42 @@
+#pragma once
+
+#include <Arduino.h>
+
+#define PRESENCE_TABLE_SIZE 128 // must be a power of two
+#define PRESENCE_TABLE_MAX_DEVICES (PRESENCE_TABLE_SIZE * 3 / 4)
+
+struct PdDevice
+{
+    uint64_t address = 0; // 48 bit BLE address, 0 marks a free slot
+    char name[30] = {0};
+    unsigned long timestamp = 0;
+    int rssi = 0;
+    bool hasRssi = false;
+    bool announced = false; // arrive event published
+    int8_t rssiBucket = 0; // last published RSSI bucket
+};
+
+// Fixed capacity open addressing table of the BLE devices seen by the presence detection, keyed by the raw address.
+// Linear probing with backward shift deletion, so there are no tombstones and lookups stay short. When the table is
+// full, the least recently seen device without a published arrive event is evicted. Announced devices are only removed
+// by the presence detection, so every arrive gets its leave event. No heap allocation.
+class PresenceDeviceTable
+{
+public:
+    PdDevice* find(const uint64_t address);
+    // nullptr if the table is full and all devices are announced
+    PdDevice* insert(const uint64_t address);
+    // Backward shift may move the following device of the cluster into this slot
+    void removeSlot(size_t index);
+
+    size_t size() const;
+    PdDevice& slot(const size_t index); // check address != 0 for occupied slots
+    const PdDevice& slot(const size_t index) const;
+
+private:
+    size_t home(const uint64_t address) const;
+    bool evictOldestUnannounced();
+
+    PdDevice _slots[PRESENCE_TABLE_SIZE];
+    size_t _count = 0;
+};
@@ -0,0 +1,100 @@
+#include "ScratchBuffer.h"
+#include <esp_heap_caps.h>
+
+char* ScratchBufferPool::_buffers[SCRATCH_BUFFER_COUNT];
+std::atomic<bool> ScratchBufferPool::_inUse[SCRATCH_BUFFER_COUNT];
+std::atomic<uint8_t> ScratchBufferPool::_leases(0);
+std::atomic<uint8_t> ScratchBufferPool::_peakLeases(0);
+std::atomic<uint32_t> ScratchBufferPool::_contention(0);
+std::atomic<size_t> ScratchBufferPool::_peakUsage(0);
+
+void ScratchBufferPool::initialize()
+{
+    for(uint8_t i = 0; i < SCRATCH_BUFFER_COUNT; i++)
+    {
+        // prefer PSRAM if available, the buffers are only used for payloads
+        char* buffer = (char*)heap_caps_malloc(SCRATCH_BUFFER_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+        if(buffer == nullptr)
+        {
+            buffer = new char[SCRATCH_BUFFER_SIZE];
+        }
+        buffer[0] = 0;
+        _buffers[i] = buffer;
+        _inUse[i].store(false, std::memory_order_relaxed);
+    }
+}
+
+char* ScratchBufferPool::acquire(uint8_t& index)
+{
+    bool contended = false;
+
+    while(true)
+    {
+        for(uint8_t i = 0; i < SCRATCH_BUFFER_COUNT; i++)
+        {
+            bool expected = false;
+            if(_inUse[i].compare_exchange_strong(expected, true, std::memory_order_acquire))
+            {
+                uint8_t leases = _leases.fetch_add(1, std::memory_order_relaxed) + 1;
+                uint8_t peak = _peakLeases.load(std::memory_order_relaxed);
+                while(leases > peak && !_peakLeases.compare_exchange_weak(peak, leases, std::memory_order_relaxed)) {}
+
+                index = i;
+                _buffers[i][0] = 0;
+                return _buffers[i];
+            }
+        }
+
+        if(!contended)
+        {
+            _contention.fetch_add(1, std::memory_order_relaxed);
+            contended = true;
+        }
+        vTaskDelay(1);
+    }
+}
+
+void ScratchBufferPool::release(const uint8_t index)
+{
+    size_t used = strnlen(_buffers[index], SCRATCH_BUFFER_SIZE) + 1;
+    size_t peak = _peakUsage.load(std::memory_order_relaxed);
+    while(used > peak && !_peakUsage.compare_exchange_weak(peak, used, std::memory_order_relaxed)) {}
+
+    _leases.fetch_sub(1, std::memory_order_relaxed);
+    _inUse[index].store(false, std::memory_order_release);
+}
+
+uint32_t ScratchBufferPool::contentionCount()
+{
+    return _contention.load(std::memory_order_relaxed);
+}
+
+size_t ScratchBufferPool::peakUsage()
+{
+    return _peakUsage.load(std::memory_order_relaxed);
+}
+
+uint8_t ScratchBufferPool::peakLeases()
+{
+    return _peakLeases.load(std::memory_order_relaxed);
+}
+
+ScratchBuffer::ScratchBuffer()
+{
+    _data = ScratchBufferPool::acquire(_index);
+}
+
+ScratchBuffer::~ScratchBuffer()
+{
+    ScratchBufferPool::release(_index);
+}
+
+char* ScratchBuffer::data() const
+{
+    return _data;
+}
+
+size_t ScratchBuffer::size() const
+{
+    return SCRATCH_BUFFER_SIZE;
+}
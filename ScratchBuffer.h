@@ -0,0 +1,51 @@
+#pragma once
+
+#include <Arduino.h>
+#include <atomic>
+
+// Number of buffers, at most one lease is held per task at a time (ntw, nuki, web)
+#define SCRATCH_BUFFER_COUNT 3
+#define SCRATCH_BUFFER_SIZE 4096
+
+// Fixed pool of scratch buffers for JSON and other temporary payloads. A buffer is checked out with a
+// ScratchBuffer lease and returned when the lease goes out of scope. If all buffers are in use the caller
+// waits for one to be returned, which is counted as contention.
+class ScratchBufferPool
+{
+public:
+    static void initialize();
+
+    static uint32_t contentionCount();
+    static size_t peakUsage(); // largest string length + terminator seen on release
+    static uint8_t peakLeases(); // most buffers checked out at the same time
+
+private:
+    friend class ScratchBuffer;
+
+    static char* acquire(uint8_t& index);
+    static void release(const uint8_t index);
+
+    static char* _buffers[SCRATCH_BUFFER_COUNT];
+    static std::atomic<bool> _inUse[SCRATCH_BUFFER_COUNT];
+    static std::atomic<uint8_t> _leases;
+    static std::atomic<uint8_t> _peakLeases;
+    static std::atomic<uint32_t> _contention;
+    static std::atomic<size_t> _peakUsage;
+};
+
+class ScratchBuffer
+{
+public:
+    ScratchBuffer();
+    ~ScratchBuffer();
+
+    ScratchBuffer(const ScratchBuffer&) = delete;
+    ScratchBuffer& operator=(const ScratchBuffer&) = delete;
+
+    char* data() const;
+    size_t size() const;
+
+private:
+    char* _data;
+    uint8_t _index;
+};
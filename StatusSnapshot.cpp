@@ -0,0 +1,98 @@
+#include "StatusSnapshot.h"
+#include "Config.h"
+
+StatusSnapshot::StatusSnapshot()
+{
+    memset(&_snapshot, 0, sizeof(_snapshot));
+    _bootId = esp_random();
+}
+
+void StatusSnapshot::updateLock(const DeviceStatus& status)
+{
+    update(&_snapshot.lock, &status, sizeof(DeviceStatus));
+}
+
+void StatusSnapshot::updateOpener(const DeviceStatus& status)
+{
+    update(&_snapshot.opener, &status, sizeof(DeviceStatus));
+}
+
+void StatusSnapshot::updateNetwork(const NetworkStatus& status)
+{
+    update(&_snapshot.network, &status, sizeof(NetworkStatus));
+}
+
+void StatusSnapshot::update(void* section, const void* status, const size_t size)
+{
+    portENTER_CRITICAL(&_mux);
+    if(memcmp(section, status, size) != 0)
+    {
+        memcpy(section, status, size);
+        ++_version;
+    }
+    portEXIT_CRITICAL(&_mux);
+}
+
+void StatusSnapshot::read(Snapshot& snapshot, char* etag)
+{
+    uint32_t version;
+
+    portENTER_CRITICAL(&_mux);
+    memcpy(&snapshot, &_snapshot, sizeof(Snapshot));
+    version = _version;
+    portEXIT_CRITICAL(&_mux);
+
+    snprintf(etag, STATUS_ETAG_LENGTH, "\"%08x-%u\"", _bootId, version);
+}
+
+void StatusSnapshot::toJson(const Snapshot& snapshot, JsonWriter& json)
+{
+    json.beginObject();
+    json.add("version", NUKI_HUB_VERSION);
+    json.beginObject("network");
+    json.add("device", snapshot.network.device);
+    json.add("connected", snapshot.network.networkConnected);
+    json.add("mqttConnected", snapshot.network.mqttConnected);
+    json.endObject();
+    if(snapshot.lock.enabled)
+    {
+        json.beginObject("lock");
+        deviceToJson(snapshot.lock, true, json);
+        json.endObject();
+    }
+    if(snapshot.opener.enabled)
+    {
+        json.beginObject("opener");
+        deviceToJson(snapshot.opener, false, json);
+        json.endObject();
+    }
+    json.endObject();
+}
+
+void StatusSnapshot::deviceToJson(const DeviceStatus& status, const bool isLock, JsonWriter& json)
+{
+    json.add("paired", status.paired);
+    json.add("bleAddress", status.bleAddress);
+    json.add("firmwareVersion", status.firmwareVersion);
+    json.add("hardwareVersion", status.hardwareVersion);
+    json.add("state", status.lockState);
+    json.add("trigger", status.trigger);
+    if(isLock)
+    {
+        json.add("lastLockAction", status.lastLockAction);
+    }
+    json.add("lastLockActionCompletionStatus", status.lastLockActionCompletionStatus);
+    json.add("doorSensorState", status.doorSensorState);
+    json.add("batteryCritical", status.batteryCritical);
+    if(isLock)
+    {
+        json.add("batteryCharging", status.batteryCharging);
+        json.addInt("batteryChargeState", status.batteryLevel);
+        json.add("keypadBatteryCritical", status.keypadBatteryCritical);
+    }
+    json.addInt("batteryVoltage", status.batteryVoltage);
+    if(status.rssi != 0)
+    {
+        json.addInt("rssi", status.rssi);
+    }
+}
@@ -0,0 +1,70 @@
+#pragma once
+
+#include <Arduino.h>
+#include "JsonWriter.h"
+
+#define STATUS_STRING_LENGTH 50
+#define STATUS_ETAG_LENGTH 24 // quoted, boot id and version
+
+// State of the lock or the opener. The enum values are converted to strings when they change, not when they are served.
+// Fill a memset() copy and pass it to StatusSnapshot, unchanged data is detected with memcmp().
+struct DeviceStatus
+{
+    bool enabled;
+    bool paired;
+    char bleAddress[18];
+    char firmwareVersion[16];
+    char hardwareVersion[8];
+    char lockState[STATUS_STRING_LENGTH];
+    char trigger[STATUS_STRING_LENGTH];
+    char lastLockAction[STATUS_STRING_LENGTH]; // lock only
+    char lastLockActionCompletionStatus[STATUS_STRING_LENGTH];
+    char doorSensorState[STATUS_STRING_LENGTH];
+    bool batteryCritical;
+    bool batteryCharging; // lock only
+    uint8_t batteryLevel; // lock only, percent
+    bool keypadBatteryCritical; // lock only
+    uint16_t batteryVoltage; // mV
+    int rssi; // 0 = not queried
+};
+
+struct NetworkStatus
+{
+    bool networkConnected;
+    bool mqttConnected;
+    char device[32];
+};
+
+// Status served by the REST API (/api/status). The wrappers and the network update their part when it changes, a
+// request only copies the snapshot and serializes the copy. Every change gets a new ETag, combined with a per boot id
+// so an ETag from before a restart never matches.
+class StatusSnapshot
+{
+public:
+    struct Snapshot
+    {
+        DeviceStatus lock;
+        DeviceStatus opener;
+        NetworkStatus network;
+    };
+
+    StatusSnapshot();
+
+    void updateLock(const DeviceStatus& status);
+    void updateOpener(const DeviceStatus& status);
+    void updateNetwork(const NetworkStatus& status);
+
+    // Copies the snapshot and writes its quoted ETag to etag (at least STATUS_ETAG_LENGTH chars)
+    void read(Snapshot& snapshot, char* etag);
+
+    static void toJson(const Snapshot& snapshot, JsonWriter& json);
+
+private:
+    void update(void* section, const void* status, const size_t size);
+    static void deviceToJson(const DeviceStatus& status, const bool isLock, JsonWriter& json);
+
+    Snapshot _snapshot;
+    uint32_t _bootId;
+    uint32_t _version = 0;
+    portMUX_TYPE _mux = portMUX_INITIALIZER_UNLOCKED;
+};
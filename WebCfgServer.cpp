@@ -6,13 +6,16 @@
 #include "Config.h"
 #include "RestartReason.h"
 #include "AccessLevel.h"
+#include "ScratchBuffer.h"
 #include <esp_task_wdt.h>
 
-WebCfgServer::WebCfgServer(NukiWrapper* nuki, NukiOpenerWrapper* nukiOpener, Network* network, Gpio* gpio, EthServer* ethServer, Preferences* preferences, bool allowRestartToPortal)
+WebCfgServer::WebCfgServer(NukiWrapper* nuki, NukiOpenerWrapper* nukiOpener, Network* network, BleScanScheduler* scanScheduler, StatusSnapshot* statusSnapshot, Gpio* gpio, EthServer* ethServer, Preferences* preferences, bool allowRestartToPortal)
 : _server(ethServer),
   _nuki(nuki),
   _nukiOpener(nukiOpener),
   _network(network),
+  _scanScheduler(scanScheduler),
+  _statusSnapshot(statusSnapshot),
   _gpio(gpio),
   _preferences(preferences),
   _allowRestartToPortal(allowRestartToPortal)
@@ -51,13 +54,15 @@ WebCfgServer::WebCfgServer(NukiWrapper* nuki, NukiOpenerWrapper* nukiOpener, Net
 
 void WebCfgServer::initialize()
 {
+    const char* headers[] = { "If-None-Match" };
+    _server.collectHeaders(headers, 1);
+
     _server.on("/", [&]() {
         if (_hasCredentials && !_server.authenticate(_credUser, _credPassword)) {
             return _server.requestAuthentication();
         }
-        String response = "";
+        HtmlResponse response(_server);
         buildHtml(response);
-        _server.send(200, "text/html", response);
     });
     _server.on("/style.css", [&]() {
         if (_hasCredentials && !_server.authenticate(_credUser, _credPassword)) {
@@ -71,45 +76,46 @@ void WebCfgServer::initialize()
         }
         sendFavicon();
     });
+    _server.on("/api/status", HTTP_GET, [&]() {
+        if (_hasCredentials && !_server.authenticate(_credUser, _credPassword)) {
+            return _server.requestAuthentication();
+        }
+        sendStatusJson();
+    });
     _server.on("/cred", [&]() {
         if (_hasCredentials && !_server.authenticate(_credUser, _credPassword)) {
             return _server.requestAuthentication();
         }
-        String response = "";
+        HtmlResponse response(_server);
         buildCredHtml(response);
-        _server.send(200, "text/html", response);
     });
     _server.on("/mqttconfig", [&]() {
         if (_hasCredentials && !_server.authenticate(_credUser, _credPassword)) {
             return _server.requestAuthentication();
         }
-        String response = "";
+        HtmlResponse response(_server);
         buildMqttConfigHtml(response);
-        _server.send(200, "text/html", response);
     });
     _server.on("/nukicfg", [&]() {
         if (_hasCredentials && !_server.authenticate(_credUser, _credPassword)) {
             return _server.requestAuthentication();
         }
-        String response = "";
+        HtmlResponse response(_server);
         buildNukiConfigHtml(response);
-        _server.send(200, "text/html", response);
     });
     _server.on("/gpiocfg", [&]() {
         if (_hasCredentials && !_server.authenticate(_credUser, _credPassword)) {
             return _server.requestAuthentication();
         }
-        String response = "";
+        HtmlResponse response(_server);
         buildGpioConfigHtml(response);
-        _server.send(200, "text/html", response);
     });
     _server.on("/wifi", [&]() {
         if (_hasCredentials && !_server.authenticate(_credUser, _credPassword)) {
             return _server.requestAuthentication();
         }
-        String response = "";
+        HtmlResponse response(_server);
         buildConfigureWifiHtml(response);
-        _server.send(200, "text/html", response);
     });
     _server.on("/unpairlock", [&]() {
         if (_hasCredentials && !_server.authenticate(_credUser, _credPassword)) {
@@ -131,9 +137,9 @@ void WebCfgServer::initialize()
         }
         if(_allowRestartToPortal)
         {
-            String response = "";
+            HtmlResponse response(_server);
             buildConfirmHtml(response, "Restarting. Connect to ESP access point to reconfigure WiFi.", 0);
-            _server.send(200, "text/html", response);
+            response.end();
             waitAndProcess(true, 2000);
             _network->reconfigureDevice();
         }
@@ -147,9 +153,9 @@ void WebCfgServer::initialize()
         bool restart = processArgs(message);
         if(restart)
         {
-            String response = "";
+            HtmlResponse response(_server);
             buildConfirmHtml(response, message);
-            _server.send(200, "text/html", response);
+            response.end();
             Log->println(F("Restarting"));
 
             waitAndProcess(true, 1000);
@@ -157,9 +163,9 @@ void WebCfgServer::initialize()
         }
         else
         {
-            String response = "";
+            HtmlResponse response(_server);
             buildConfirmHtml(response, message, 3);
-            _server.send(200, "text/html", response);
+            response.end();
             waitAndProcess(false, 1000);
         }
     });
@@ -170,9 +176,9 @@ void WebCfgServer::initialize()
         }
         processGpioArgs();
 
-        String response = "";
+        HtmlResponse response(_server);
         buildConfirmHtml(response, "");
-        _server.send(200, "text/html", response);
+        response.end();
         Log->println(F("Restarting"));
 
         waitAndProcess(true, 1000);
@@ -183,9 +189,8 @@ void WebCfgServer::initialize()
         if (_hasCredentials && !_server.authenticate(_credUser, _credPassword)) {
             return _server.requestAuthentication();
         }
-        String response = "";
+        HtmlResponse response(_server);
         buildOtaHtml(response, _server.arg("errored") != "");
-        _server.send(200, "text/html", response);
     });
     _server.on("/uploadota", HTTP_POST, [&]() {
         if (_hasCredentials && !_server.authenticate(_credUser, _credPassword)) {
@@ -193,9 +198,9 @@ void WebCfgServer::initialize()
         }
 
         if (_ota.updateStarted() && _ota.updateCompleted()) {
-            String response = "";
+            HtmlResponse response(_server);
             buildOtaCompletedHtml(response);
-            _server.send(200, "text/html", response);
+            response.end();
             delay(2000);
             restartEsp(RestartReason::OTACompleted);
         } else {
@@ -214,16 +219,15 @@ void WebCfgServer::initialize()
         if (_hasCredentials && !_server.authenticate(_credUser, _credPassword)) {
             return _server.requestAuthentication();
         }
-        String response = "";
+        HtmlResponse response(_server);
         buildInfoHtml(response);
-        _server.send(200, "text/html", response);
     });
     _server.on("/debugon", [&]() {
         _preferences->putBool(preference_publish_debug_info, true);
 
-        String response = "";
+        HtmlResponse response(_server);
         buildConfirmHtml(response, "OK");
-        _server.send(200, "text/html", response);
+        response.end();
         Log->println(F("Restarting"));
 
         waitAndProcess(true, 1000);
@@ -232,9 +236,9 @@ void WebCfgServer::initialize()
     _server.on("/debugoff", [&]() {
         _preferences->putBool(preference_publish_debug_info, false);
 
-        String response = "";
+        HtmlResponse response(_server);
         buildConfirmHtml(response, "OK");
-        _server.send(200, "text/html", response);
+        response.end();
         Log->println(F("Restarting"));
 
         waitAndProcess(true, 1000);
@@ -242,11 +246,6 @@ void WebCfgServer::initialize()
     });
 
     _server.begin();
-
-    _network->setKeepAliveCallback([&]()
-        {
-            update();
-        });
 }
 
 bool WebCfgServer::processArgs(String& message)
@@ -437,6 +436,11 @@ bool WebCfgServer::processArgs(String& message)
             _preferences->putInt(preference_presence_detection_timeout, value.toInt());
             configChanged = true;
         }
+        else if(key == "BLESES")
+        {
+            _preferences->putInt(preference_ble_session_timeout, value.toInt());
+            configChanged = true;
+        }
         else if(key == "RSBC")
         {
             _preferences->putInt(preference_restart_ble_beacon_lost, value.toInt());
@@ -447,6 +451,11 @@ bool WebCfgServer::processArgs(String& message)
             _preferences->putBool(preference_publish_authdata, (value == "1"));
             configChanged = true;
         }
+        else if(key == "PUBJSON")
+        {
+            _preferences->putBool(preference_publish_json_state, (value == "1"));
+            configChanged = true;
+        }
         else if(key == "REGAPP")
         {
             _preferences->putBool(preference_register_as_app, (value == "1"));
@@ -580,7 +589,7 @@ void WebCfgServer::update()
     _server.handleClient();
 }
 
-void WebCfgServer::buildHtml(String& response)
+void WebCfgServer::buildHtml(HtmlResponse& response)
 {
     buildHtmlHeader(response);
 
@@ -592,19 +601,23 @@ void WebCfgServer::buildHtml(String& response)
 
     printParameter(response, "Hostname", _hostname.c_str());
     printParameter(response, "MQTT Connected", _network->mqttConnectionState() > 0 ? "Yes" : "No");
+
+    StatusSnapshot::Snapshot snapshot;
+    char etag[STATUS_ETAG_LENGTH];
+    _statusSnapshot->read(snapshot, etag);
+    char pairedStr[40];
+
     if(_nuki != nullptr)
     {
-        char lockstateArr[20];
-        NukiLock::lockstateToString(_nuki->keyTurnerState().lockState, lockstateArr);
-        printParameter(response, "NUKI Lock paired", _nuki->isPaired() ? ("Yes (BLE Address " + _nuki->getBleAddress().toString() + ")").c_str() : "No");
-        printParameter(response, "NUKI Lock state", lockstateArr);
+        snprintf(pairedStr, sizeof(pairedStr), "Yes (BLE Address %s)", snapshot.lock.bleAddress);
+        printParameter(response, "NUKI Lock paired", snapshot.lock.paired ? pairedStr : "No");
+        printParameter(response, "NUKI Lock state", snapshot.lock.lockState);
     }
     if(_nukiOpener != nullptr)
     {
-        char lockstateArr[20];
-        NukiOpener::lockstateToString(_nukiOpener->keyTurnerState().lockState, lockstateArr);
-        printParameter(response, "NUKI Opener paired", _nukiOpener->isPaired() ? ("Yes (BLE Address " + _nukiOpener->getBleAddress().toString() + ")").c_str() : "No");
-        printParameter(response, "NUKI Opener state", lockstateArr);
+        snprintf(pairedStr, sizeof(pairedStr), "Yes (BLE Address %s)", snapshot.opener.bleAddress);
+        printParameter(response, "NUKI Opener paired", snapshot.opener.paired ? pairedStr : "No");
+        printParameter(response, "NUKI Opener state", snapshot.opener.lockState);
     }
     printParameter(response, "Firmware", version.c_str(), "/info");
     response.concat("</table><br><br>");
@@ -634,7 +647,7 @@ void WebCfgServer::buildHtml(String& response)
 }
 
 
-void WebCfgServer::buildCredHtml(String &response)
+void WebCfgServer::buildCredHtml(HtmlResponse& response)
 {
     buildHtmlHeader(response);
 
@@ -695,7 +708,7 @@ void WebCfgServer::buildCredHtml(String &response)
     response.concat("</BODY></HTML>");
 }
 
-void WebCfgServer::buildOtaHtml(String &response, bool errored)
+void WebCfgServer::buildOtaHtml(HtmlResponse& response, bool errored)
 {
     buildHtmlHeader(response);
 
@@ -726,7 +739,7 @@ void WebCfgServer::buildOtaHtml(String &response, bool errored)
     response.concat("</BODY></HTML>");
 }
 
-void WebCfgServer::buildOtaCompletedHtml(String &response)
+void WebCfgServer::buildOtaCompletedHtml(HtmlResponse& response)
 {
     buildHtmlHeader(response);
 
@@ -739,7 +752,7 @@ void WebCfgServer::buildOtaCompletedHtml(String &response)
     response.concat("</BODY></HTML>");
 }
 
-void WebCfgServer::buildMqttConfigHtml(String &response)
+void WebCfgServer::buildMqttConfigHtml(HtmlResponse& response)
 {
     buildHtmlHeader(response);
     response.concat("<FORM ACTION=savecfg method='POST'>");
@@ -781,7 +794,7 @@ void WebCfgServer::buildMqttConfigHtml(String &response)
 }
 
 
-void WebCfgServer::buildNukiConfigHtml(String &response)
+void WebCfgServer::buildNukiConfigHtml(HtmlResponse& response)
 {
     buildHtmlHeader(response);
 
@@ -816,16 +829,18 @@ void WebCfgServer::buildNukiConfigHtml(String &response)
     printInputField(response, "NRTRY", "Number of retries if command failed", _preferences->getInt(preference_command_nr_of_retries), 10);
     printInputField(response, "TRYDLY", "Delay between retries (milliseconds)", _preferences->getInt(preference_command_retry_delay), 10);
     printCheckBox(response, "PUBAUTH", "Publish auth data (May reduce battery life)", _preferences->getBool(preference_publish_authdata));
+    printCheckBox(response, "PUBJSON", "Publish combined lock state as JSON (lock/json)", _preferences->getBool(preference_publish_json_state));
     printCheckBox(response, "REGAPP", "Register as app (on: register as app, off: register as bridge; needs re-pairing if changed)", _preferences->getBool(preference_register_as_app));
     printInputField(response, "PRDTMO", "Presence detection timeout (seconds; -1 to disable)", _preferences->getInt(preference_presence_detection_timeout), 10);
     printInputField(response, "RSBC", "Restart if bluetooth beacons not received (seconds; -1 to disable)", _preferences->getInt(preference_restart_ble_beacon_lost), 10);
+    printInputField(response, "BLESES", "Keep lock connection open after activity (seconds; 0 to disable, may reduce battery life)", _preferences->getInt(preference_ble_session_timeout), 10);
     response.concat("</table>");
     response.concat("<br><INPUT TYPE=SUBMIT NAME=\"submit\" VALUE=\"Save\">");
     response.concat("</FORM>");
     response.concat("</BODY></HTML>");
 }
 
-void WebCfgServer::buildGpioConfigHtml(String &response)
+void WebCfgServer::buildGpioConfigHtml(HtmlResponse& response)
 {
     buildHtmlHeader(response);
 
@@ -848,7 +863,7 @@ void WebCfgServer::buildGpioConfigHtml(String &response)
     response.concat("</BODY></HTML>");
 }
 
-void WebCfgServer::buildConfirmHtml(String &response, const String &message, uint32_t redirectDelay)
+void WebCfgServer::buildConfirmHtml(HtmlResponse& response, const String &message, uint32_t redirectDelay)
 {
     String delay(redirectDelay);
 
@@ -865,7 +880,7 @@ void WebCfgServer::buildConfirmHtml(String &response, const String &message, uin
     response.concat("</BODY></HTML>");
 }
 
-void WebCfgServer::buildConfigureWifiHtml(String &response)
+void WebCfgServer::buildConfigureWifiHtml(HtmlResponse& response)
 {
     buildHtmlHeader(response);
 
@@ -876,7 +891,7 @@ void WebCfgServer::buildConfigureWifiHtml(String &response)
     response.concat("</BODY></HTML>");
 }
 
-void WebCfgServer::buildInfoHtml(String &response)
+void WebCfgServer::buildInfoHtml(HtmlResponse& response)
 {
     DebugPreferences debugPreferences;
 
@@ -887,7 +902,7 @@ void WebCfgServer::buildInfoHtml(String &response)
     response.concat(NUKI_HUB_VERSION);
     response.concat("\n");
 
-    response.concat(debugPreferences.preferencesToString(_preferences));
+    debugPreferences.appendPreferences(_preferences, response);
 
     response.concat("MQTT connected: ");
     response.concat(_network->mqttConnectionState() > 0 ? "Yes\n" : "No\n");
@@ -936,11 +951,48 @@ void WebCfgServer::buildInfoHtml(String &response)
     response.concat(uxTaskGetStackHighWaterMark(networkTaskHandle));
     response.concat(", nuki: ");
     response.concat(uxTaskGetStackHighWaterMark(nukiTaskHandle));
+    if(webCfgTaskHandle != nullptr)
+    {
+        response.concat(", web: ");
+        response.concat(uxTaskGetStackHighWaterMark(webCfgTaskHandle));
+    }
     response.concat(", pd: ");
     response.concat(uxTaskGetStackHighWaterMark(presenceDetectionTaskHandle));
     response.concat("\n");
 
-    _gpio->getConfigurationText(response, _gpio->pinConfiguration());
+    response.concat("BLE radio: scanning ");
+    response.concat(_scanScheduler->scanTime() / 1000);
+    response.concat(" s (duty cycle ");
+    response.concat(_scanScheduler->dutyCycle());
+    response.concat("%), paused for device communication ");
+    response.concat(_scanScheduler->pausedTime() / 1000);
+    response.concat(" s in ");
+    response.concat(_scanScheduler->pauseCount());
+    response.concat(" pauses\n");
+
+    if(_nuki != nullptr)
+    {
+        String text;
+        _nuki->getBleLatencyText(text);
+        _nuki->getPollingText(text);
+        response.concat(text);
+    }
+
+    response.concat("Scratch buffers: peak ");
+    response.concat(ScratchBufferPool::peakUsage());
+    response.concat(" / ");
+    response.concat(SCRATCH_BUFFER_SIZE);
+    response.concat(" bytes, ");
+    response.concat(ScratchBufferPool::peakLeases());
+    response.concat(" / ");
+    response.concat(SCRATCH_BUFFER_COUNT);
+    response.concat(" in use, contention: ");
+    response.concat(ScratchBufferPool::contentionCount());
+    response.concat("\n");
+
+    String gpioText;
+    _gpio->getConfigurationText(gpioText, _gpio->pinConfiguration());
+    response.concat(gpioText);
 
     response.concat("Restart reason FW: ");
     response.concat(getRestartReason());
@@ -955,11 +1007,10 @@ void WebCfgServer::buildInfoHtml(String &response)
 
 void WebCfgServer::processUnpair(bool opener)
 {
-    String response = "";
+    HtmlResponse response(_server);
     if(_server.args() == 0)
     {
         buildConfirmHtml(response, "Confirm code is invalid.", 3);
-        _server.send(200, "text/html", response);
         return;
     }
     else
@@ -970,13 +1021,12 @@ void WebCfgServer::processUnpair(bool opener)
         if(key != "CONFIRMTOKEN" || value != _confirmCode)
         {
             buildConfirmHtml(response, "Confirm code is invalid.", 3);
-            _server.send(200, "text/html", response);
             return;
         }
     }
 
     buildConfirmHtml(response, opener ? "Unpairing NUKI Opener and restarting." : "Unpairing NUKI Lock and restarting.", 3);
-    _server.send(200, "text/html", response);
+    response.end();
     if(!opener && _nuki != nullptr)
     {
         _nuki->disableHASS();
@@ -991,20 +1041,18 @@ void WebCfgServer::processUnpair(bool opener)
     restartEsp(RestartReason::DeviceUnpaired);
 }
 
-void WebCfgServer::buildHtmlHeader(String &response)
+void WebCfgServer::buildHtmlHeader(HtmlResponse& response)
 {
     response.concat("<HTML><HEAD>");
     response.concat("<meta name='viewport' content='width=device-width, initial-scale=1'>");
-//    response.concat("<style>");
-//    response.concat(stylecss);
-//    response.concat("</style>");
-    response.concat("<link rel='stylesheet' href='/style.css'>");
+    response.concat("<link rel='stylesheet' href='/style.css?v=" STYLE_CSS_HASH "'>");
+    response.concat("<link rel='icon' type='image/png' href='/favicon.ico?v=" FAVICON_HASH "'>");
     response.concat("<TITLE>NUKI Hub</TITLE></HEAD><BODY>");
 
     srand(millis());
 }
 
-void WebCfgServer::printInputField(String& response,
+void WebCfgServer::printInputField(HtmlResponse& response,
                                    const char *token,
                                    const char *description,
                                    const char *value,
@@ -1039,7 +1087,7 @@ void WebCfgServer::printInputField(String& response,
     response.concat("</td></tr>\"");
 }
 
-void WebCfgServer::printInputField(String& response,
+void WebCfgServer::printInputField(HtmlResponse& response,
                                    const char *token,
                                    const char *description,
                                    const int value,
@@ -1050,7 +1098,7 @@ void WebCfgServer::printInputField(String& response,
     printInputField(response, token, description, valueStr, maxLength);
 }
 
-void WebCfgServer::printCheckBox(String &response, const char *token, const char *description, const bool value)
+void WebCfgServer::printCheckBox(HtmlResponse& response, const char *token, const char *description, const bool value)
 {
     response.concat("<tr><td>");
     response.concat(description);
@@ -1068,7 +1116,7 @@ void WebCfgServer::printCheckBox(String &response, const char *token, const char
     response.concat("/></td></tr>");
 }
 
-void WebCfgServer::printTextarea(String& response,
+void WebCfgServer::printTextarea(HtmlResponse& response,
                                    const char *token,
                                    const char *description,
                                    const char *value,
@@ -1104,7 +1152,7 @@ void WebCfgServer::printTextarea(String& response,
     response.concat("</td></tr>");
 }
 
-void WebCfgServer::printDropDown(String &response, const char *token, const char *description, const String preselectedValue, const std::vector<std::pair<String, String>> options)
+void WebCfgServer::printDropDown(HtmlResponse& response, const char *token, const char *description, const String preselectedValue, const std::vector<std::pair<String, String>> options)
 {
     response.concat("<tr><td>");
     response.concat(description);
@@ -1134,7 +1182,7 @@ void WebCfgServer::printDropDown(String &response, const char *token, const char
     response.concat("</td></tr>");
 }
 
-void WebCfgServer::buildNavigationButton(String &response, const char *caption, const char *targetPath, const char* labelText)
+void WebCfgServer::buildNavigationButton(HtmlResponse& response, const char *caption, const char *targetPath, const char* labelText)
 {
     response.concat("<form method=\"get\" action=\"");
     response.concat(targetPath);
@@ -1146,7 +1194,7 @@ void WebCfgServer::buildNavigationButton(String &response, const char *caption,
     response.concat("</form>");
 }
 
-void WebCfgServer::printParameter(String& response, const char *description, const char *value, const char *link)
+void WebCfgServer::printParameter(HtmlResponse& response, const char *description, const char *value, const char *link)
 {
     response.concat("<tr>");
     response.concat("<td>");
@@ -1261,13 +1309,61 @@ void WebCfgServer::handleOtaUpload()
 
 void WebCfgServer::sendCss()
 {
-    // escaped by https://www.cescaper.com/
-    _server.send(200, "text/plain", stylecss, sizeof(stylecss));
+    sendStaticAsset("text/css", stylecss, sizeof(stylecss), STYLE_CSS_HASH, STYLE_CSS_GZIP);
 }
 
 void WebCfgServer::sendFavicon()
 {
-    _server.send(200, "image/png", (const char*)favicon_32x32, sizeof(favicon_32x32));
+    sendStaticAsset("image/png", favicon_32x32, sizeof(favicon_32x32), FAVICON_HASH, FAVICON_GZIP);
+}
+
+void WebCfgServer::sendStaticAsset(const char* contentType, const unsigned char* data, const size_t size, const char* hash, const bool gzip)
+{
+    char etag[12];
+    snprintf(etag, sizeof(etag), "\"%s\"", hash);
+
+    _server.sendHeader("ETag", etag);
+    // Pages link the assets with their hash as version, such a URL never changes its content
+    _server.sendHeader("Cache-Control", _server.arg("v") == hash ? "public, max-age=31536000, immutable" : "no-cache");
+
+    if(_server.header("If-None-Match") == etag)
+    {
+        _server.send(304);
+        return;
+    }
+
+    if(gzip)
+    {
+        _server.sendHeader("Content-Encoding", "gzip");
+    }
+    _server.send(200, contentType, (const char*)data, size);
+}
+
+void WebCfgServer::sendStatusJson()
+{
+    StatusSnapshot::Snapshot snapshot;
+    char etag[STATUS_ETAG_LENGTH];
+    _statusSnapshot->read(snapshot, etag);
+
+    _server.sendHeader("ETag", etag);
+    _server.sendHeader("Cache-Control", "no-cache");
+
+    if(_server.header("If-None-Match") == etag)
+    {
+        _server.send(304);
+        return;
+    }
+
+    ScratchBuffer buffer;
+    JsonWriter json(buffer.data(), buffer.size());
+    StatusSnapshot::toJson(snapshot, json);
+
+    if(!json.ok())
+    {
+        _server.send(500, "text/plain", "Status too large");
+        return;
+    }
+    _server.send(200, "application/json", buffer.data(), json.length());
 }
 
 const std::vector<std::pair<String, String>> WebCfgServer::getNetworkDetectionOptions() const
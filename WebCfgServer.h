@@ -7,9 +7,13 @@
 #include "NukiOpenerWrapper.h"
 #include "Ota.h"
 #include "Gpio.h"
+#include "BleScanScheduler.h"
+#include "HtmlResponse.h"
+#include "StatusSnapshot.h"
 
 extern TaskHandle_t networkTaskHandle;
 extern TaskHandle_t nukiTaskHandle;
+extern TaskHandle_t webCfgTaskHandle;
 extern TaskHandle_t presenceDetectionTaskHandle;
 
 enum class TokenType
@@ -27,7 +31,7 @@ enum class TokenType
 class WebCfgServer
 {
 public:
-    WebCfgServer(NukiWrapper* nuki, NukiOpenerWrapper* nukiOpener, Network* network, Gpio* gpio, EthServer* ethServer, Preferences* preferences, bool allowRestartToPortal);
+    WebCfgServer(NukiWrapper* nuki, NukiOpenerWrapper* nukiOpener, Network* network, BleScanScheduler* scanScheduler, StatusSnapshot* statusSnapshot, Gpio* gpio, EthServer* ethServer, Preferences* preferences, bool allowRestartToPortal);
     ~WebCfgServer() = default;
 
     void initialize();
@@ -36,34 +40,36 @@ public:
 private:
     bool processArgs(String& message);
     void processGpioArgs();
-    void buildHtml(String& response);
-    void buildCredHtml(String& response);
-    void buildOtaHtml(String& response, bool errored);
-    void buildOtaCompletedHtml(String& response);
-    void buildMqttConfigHtml(String& response);
-    void buildNukiConfigHtml(String& response);
-    void buildGpioConfigHtml(String& response);
-    void buildConfirmHtml(String& response, const String &message, uint32_t redirectDelay = 5);
-    void buildConfigureWifiHtml(String& response);
-    void buildInfoHtml(String& response);
+    void buildHtml(HtmlResponse& response);
+    void buildCredHtml(HtmlResponse& response);
+    void buildOtaHtml(HtmlResponse& response, bool errored);
+    void buildOtaCompletedHtml(HtmlResponse& response);
+    void buildMqttConfigHtml(HtmlResponse& response);
+    void buildNukiConfigHtml(HtmlResponse& response);
+    void buildGpioConfigHtml(HtmlResponse& response);
+    void buildConfirmHtml(HtmlResponse& response, const String &message, uint32_t redirectDelay = 5);
+    void buildConfigureWifiHtml(HtmlResponse& response);
+    void buildInfoHtml(HtmlResponse& response);
     void sendCss();
     void sendFavicon();
+    void sendStaticAsset(const char* contentType, const unsigned char* data, const size_t size, const char* hash, const bool gzip);
+    void sendStatusJson();
     void processUnpair(bool opener);
 
-    void buildHtmlHeader(String& response);
-    void printInputField(String& response, const char* token, const char* description, const char* value, const size_t& maxLength, const bool& isPassword = false, const bool& showLengthRestriction = false);
-    void printInputField(String& response, const char* token, const char* description, const int value, size_t maxLength);
-    void printCheckBox(String& response, const char* token, const char* description, const bool value);
-    void printTextarea(String& response, const char *token, const char *description, const char *value, const size_t& maxLength, const bool& enabled = true, const bool& showLengthRestriction = false);
-    void printDropDown(String &response, const char *token, const char *description, const String preselectedValue, std::vector<std::pair<String, String>> options);
-    void buildNavigationButton(String& response, const char* caption, const char* targetPath, const char* labelText = "");
+    void buildHtmlHeader(HtmlResponse& response);
+    void printInputField(HtmlResponse& response, const char* token, const char* description, const char* value, const size_t& maxLength, const bool& isPassword = false, const bool& showLengthRestriction = false);
+    void printInputField(HtmlResponse& response, const char* token, const char* description, const int value, size_t maxLength);
+    void printCheckBox(HtmlResponse& response, const char* token, const char* description, const bool value);
+    void printTextarea(HtmlResponse& response, const char *token, const char *description, const char *value, const size_t& maxLength, const bool& enabled = true, const bool& showLengthRestriction = false);
+    void printDropDown(HtmlResponse& response, const char *token, const char *description, const String preselectedValue, std::vector<std::pair<String, String>> options);
+    void buildNavigationButton(HtmlResponse& response, const char* caption, const char* targetPath, const char* labelText = "");
 
     const std::vector<std::pair<String, String>> getNetworkDetectionOptions() const;
     const std::vector<std::pair<String, String>> getGpioOptions() const;
     const std::vector<std::pair<String, String>> getAccessLevelOptions() const;
     String getPreselectionForGpio(const uint8_t& pin);
 
-    void printParameter(String& response, const char* description, const char* value, const char *link = "");
+    void printParameter(HtmlResponse& response, const char* description, const char* value, const char *link = "");
 
     String generateConfirmCode();
     void waitAndProcess(const bool blocking, const uint32_t duration);
@@ -73,6 +79,8 @@ private:
     NukiWrapper* _nuki = nullptr;
     NukiOpenerWrapper* _nukiOpener = nullptr;
     Network* _network = nullptr;
+    BleScanScheduler* _scanScheduler = nullptr;
+    StatusSnapshot* _statusSnapshot = nullptr;
     Gpio* _gpio = nullptr;
     Preferences* _preferences = nullptr;
     Ota _ota;
@@ -1,12 +1,118 @@
 #pragma once
 
-// escaped by https://www.cescaper.com/
-// source: https://cdn.jsdelivr.net/npm/@exampledev/new.css@1.1.2/new.min.css
+// Generated by webassets/generate_constants.py, do not edit. Sources:
+//   webassets/style.css
+//   icon/favicon-32x32.png
 
-const char stylecss[] = ":root{--nc-font-sans:\\'Inter\\',-apple-system,BlinkMacSystemFont,\\'Segoe UI\\',Roboto,Oxygen,Ubuntu,Cantarell,\\'Open Sans\\',\\'Helvetica Neue\\',sans-serif,\\\"Apple Color Emoji\\\",\\\"Segoe UI Emoji\\\",\\\"Segoe UI Symbol\\\";--nc-font-mono:Consolas,monaco,\\'Ubuntu Mono\\',\\'Liberation Mono\\',\\'Courier New\\',Courier,monospace;--nc-tx-1:#000000;--nc-tx-2:#1A1A1A;--nc-bg-1:#FFFFFF;--nc-bg-2:#F6F8FA;--nc-bg-3:#E5E7EB;--nc-lk-1:#0070F3;--nc-lk-2:#0366D6;--nc-lk-tx:#FFFFFF;--nc-ac-1:#79FFE1;--nc-ac-tx:#0C4047}@media (prefers-color-scheme:dark){:root{--nc-tx-1:#ffffff;--nc-tx-2:#eeeeee;--nc-bg-1:#000000;--nc-bg-2:#111111;--nc-bg-3:#222222;--nc-lk-1:#3291FF;--nc-lk-2:#0070F3;--nc-lk-tx:#FFFFFF;--nc-ac-1:#7928CA;--nc-ac-tx:#FFFFFF}}*{margin:0;padding:0}address,area,article,aside,audio,blockquote,datalist,details,dl,fieldset,figure,form,iframe,img,input,meter,nav,ol,optgroup,option,output,p,pre,progress,ruby,section,table,textarea,ul,video{margin-bottom:1rem}button,html,input,select{font-family:var(--nc-font-sans)}body{margin:0 auto;max-width:750px;padding:2rem;border-radius:6px;overflow-x:hidden;word-break:normal;overflow-wrap:anywhere;background:var(--nc-bg-1);color:var(--nc-tx-2);font-size:1.03rem;line-height:1.5}::selection{background:var(--nc-ac-1);color:var(--nc-ac-tx)}h1,h2,h3,h4,h5,h6{line-height:1;color:var(--nc-tx-1);padding-top:.875rem}h1,h2,h3{color:var(--nc-tx-1);padding-bottom:2px;margin-bottom:8px;border-bottom:1px solid var(--nc-bg-2)}h4,h5,h6{margin-bottom:.3rem}h1{font-size:2.25rem}h2{font-size:1.85rem}h3{font-size:1.55rem}h4{font-size:1.25rem}h5{font-size:1rem}h6{font-size:.875rem}a{color:var(--nc-lk-1)}a:hover{color:var(--nc-lk-2)}abbr:hover{cursor:help}blockquote{padding:1.5rem;background:var(--nc-bg-2);border-left:5px solid var(--nc-bg-3)}abbr{cursor:help}blockquote :last-child{padding-bottom:0;margin-bottom:0}header{background:var(--nc-bg-2);border-bottom:1px solid var(--nc-bg-3);padding:2rem 1.5rem;margin:-2rem calc(0px - (50vw - 50%)) 2rem;padding-left:calc(50vw - 50%);padding-right:calc(50vw - 50%)}header h1,header h2,header h3{padding-bottom:0;border-bottom:0}header>:first-child{margin-top:0;padding-top:0}header>:last-child{margin-bottom:0}a button,button,input[type=button],input[type=reset],input[type=submit]{font-size:1rem;display:inline-block;padding:6px 12px;text-align:center;text-decoration:none;white-space:nowrap;background:var(--nc-lk-1);color:var(--nc-lk-tx);border:0;border-radius:4px;box-sizing:border-box;cursor:pointer;color:var(--nc-lk-tx)}a button[disabled],button[disabled],input[type=button][disabled],input[type=reset][disabled],input[type=submit][disabled]{cursor:default;opacity:.5;cursor:not-allowed}.button:focus,.button:hover,button:focus,button:hover,input[type=button]:focus,input[type=button]:hover,input[type=reset]:focus,input[type=reset]:hover,input[type=submit]:focus,input[type=submit]:hover{background:var(--nc-lk-2)}code,kbd,pre,samp{font-family:var(--nc-font-mono)}code,kbd,pre,samp{background:var(--nc-bg-2);border:1px solid var(--nc-bg-3);border-radius:4px;padding:3px 6px;font-size:.9rem}kbd{border-bottom:3px solid var(--nc-bg-3)}pre{padding:1rem 1.4rem;max-width:100%;overflow:auto}pre code{background:inherit;font-size:inherit;color:inherit;border:0;padding:0;margin:0}code pre{display:inline;background:inherit;font-size:inherit;color:inherit;border:0;padding:0;margin:0}details{padding:.6rem 1rem;background:var(--nc-bg-2);border:1px solid var(--nc-bg-3);border-radius:4px}summary{cursor:pointer;font-weight:700}details[open]{padding-bottom:.75rem}details[open] summary{margin-bottom:6px}details[open]>:last-child{margin-bottom:0}dt{font-weight:700}dd::before{content:\\'→ \\'}hr{border:0;border-bottom:1px solid var(--nc-bg-3);margin:1rem auto}fieldset{margin-top:1rem;padding:2rem;border:1px solid var(--nc-bg-3);border-radius:4px}legend{padding:0.5rem}table{border-collapse:collapse;width:100%}td,th{border:1px solid var(--nc-bg-3);text-align:left;padding:.5rem}th{background:var(--nc-bg-2)}tr:nth-child(even){background:var(--nc-bg-2)}table caption{font-weight:700;margin-bottom:.5rem}textarea{max-width:100%}ol,ul{padding-left:2rem}li{margin-top:.4rem}ol ol,ol ul,ul ol,ul ul{margin-bottom:0}mark{padding:3px 6px;background:var(--nc-ac-1);color:var(--nc-ac-tx)}input,select,textarea{padding:6px 12px;margin-bottom:.5rem;background:var(--nc-bg-2);color:var(--nc-tx-2);border:1px solid var(--nc-bg-3);border-radius:4px;box-shadow:none;box-sizing:border-box}img{max-width:100%}";
+// webassets/style.css: 4445 bytes, 1573 bytes gzip compressed
+#define STYLE_CSS_HASH "3d2884ca"
+#define STYLE_CSS_GZIP true
+const unsigned char stylecss[] = {
+        0x1f, 0x8b, 0x08, 0x00, 0x00, 0x00, 0x00, 0x00, 0x02, 0x03, 0xad, 0x57, 0xdd, 0x6e, 0xdb, 0x36,
+        0x14, 0xbe, 0xdf, 0x53, 0x08, 0x29, 0x0a, 0xc7, 0x03, 0x65, 0xc8, 0x76, 0xec, 0xa4, 0x34, 0x36,
+        0xac, 0xcd, 0x62, 0xb4, 0xc0, 0xba, 0x02, 0x0b, 0x7a, 0x55, 0xe4, 0x82, 0x92, 0x8e, 0x2d, 0xce,
+        0x94, 0xa8, 0x51, 0x54, 0x6c, 0x4f, 0xd0, 0xed, 0x1e, 0x60, 0x8f, 0xb8, 0x27, 0xd9, 0x21, 0xf5,
+        0x63, 0xc9, 0x76, 0x92, 0x05, 0x98, 0x82, 0x24, 0xd2, 0xe1, 0x21, 0xf9, 0x9d, 0x8f, 0xe7, 0x8f,
+        0x54, 0x49, 0xa9, 0x0b, 0xd7, 0x4d, 0x02, 0x77, 0x25, 0x13, 0xed, 0x66, 0x2c, 0xc9, 0xe8, 0xe0,
+        0x53, 0xa2, 0x41, 0x0d, 0x88, 0xcb, 0xd2, 0x54, 0x80, 0x9b, 0xed, 0x33, 0x0d, 0x31, 0xf9, 0x20,
+        0x78, 0xb2, 0xf9, 0xcc, 0x82, 0x7b, 0xfb, 0xb9, 0x44, 0x6d, 0x32, 0xb8, 0x87, 0xb5, 0x04, 0xe7,
+        0xeb, 0xa7, 0x01, 0xf9, 0x4d, 0xfa, 0x52, 0x4b, 0xf2, 0x65, 0xb7, 0x5f, 0x43, 0x42, 0xbe, 0xfa,
+        0x79, 0xa2, 0x73, 0x72, 0xcb, 0x12, 0xcd, 0x14, 0x08, 0x41, 0x06, 0x5f, 0x52, 0x48, 0x9c, 0x7b,
+        0x5c, 0x7d, 0x40, 0x06, 0x1f, 0x41, 0x3c, 0x82, 0xe6, 0x01, 0x73, 0x7e, 0x85, 0x1c, 0x06, 0xc4,
+        0x6c, 0xea, 0x66, 0xa0, 0xf8, 0x8a, 0x5c, 0xbc, 0x37, 0x5b, 0x3a, 0xb7, 0x52, 0x48, 0xe5, 0xdc,
+        0xc5, 0xf2, 0x77, 0x7e, 0x41, 0x2e, 0x9a, 0x5d, 0x4e, 0x05, 0xf7, 0xfb, 0xd8, 0x97, 0xe2, 0x62,
+        0x71, 0x30, 0x20, 0x96, 0x89, 0xa4, 0xb7, 0x32, 0xc9, 0xa4, 0x60, 0x19, 0xc1, 0x2f, 0x16, 0x48,
+        0x32, 0xa8, 0xf0, 0x38, 0x9f, 0x71, 0x10, 0xf7, 0xff, 0x85, 0xfb, 0xa0, 0x98, 0xe6, 0x32, 0x69,
+        0x24, 0xb7, 0x32, 0x57, 0x1c, 0x14, 0xe2, 0xd9, 0x0e, 0x48, 0xfd, 0x61, 0x26, 0xcb, 0x2c, 0x65,
+        0x01, 0x54, 0xcb, 0xeb, 0x9d, 0x3b, 0xa6, 0x6f, 0x3c, 0xfb, 0xb4, 0x92, 0x09, 0x7d, 0x33, 0x7e,
+        0x6f, 0x7e, 0x2a, 0x89, 0xbf, 0x36, 0x3a, 0x4b, 0xfb, 0xb4, 0x12, 0xd4, 0x59, 0xce, 0x97, 0x37,
+        0xcb, 0x83, 0xce, 0x94, 0xbe, 0xb9, 0x9b, 0xdd, 0x5d, 0xdf, 0x7d, 0xa8, 0x24, 0x62, 0x53, 0xad,
+        0x7c, 0xed, 0x2d, 0xa7, 0xad, 0x04, 0x67, 0x79, 0xd3, 0xf9, 0xfc, 0xe7, 0x79, 0x2b, 0xd1, 0xbb,
+        0xfe, 0xd2, 0x2c, 0x30, 0xd3, 0xae, 0xdf, 0x2d, 0x97, 0x77, 0xe3, 0x56, 0x62, 0x94, 0xbc, 0xdb,
+        0x2b, 0xef, 0xea, 0xba, 0xfc, 0x29, 0x86, 0x90, 0x33, 0xe7, 0x32, 0x55, 0xb0, 0x02, 0x95, 0xb9,
+        0x81, 0x21, 0xd5, 0xcd, 0x82, 0x08, 0x62, 0xa0, 0x21, 0x53, 0x9b, 0x61, 0x41, 0x0f, 0xc7, 0x5f,
+        0x99, 0xb7, 0xb2, 0x4f, 0xd7, 0x3c, 0xb0, 0x4f, 0xd7, 0xbc, 0x2e, 0x05, 0x95, 0x79, 0x63, 0xfb,
+        0x74, 0xcd, 0x9b, 0xd8, 0xa7, 0x6b, 0xde, 0x74, 0xf2, 0x6e, 0xdc, 0x20, 0xaf, 0xcd, 0xeb, 0x1b,
+        0xfc, 0x94, 0x79, 0x93, 0x9b, 0xdb, 0xf7, 0x3d, 0xf3, 0x2a, 0xa5, 0xb2, 0xfc, 0xbe, 0x88, 0x99,
+        0x5a, 0xf3, 0x84, 0x7a, 0x8b, 0x94, 0x85, 0x21, 0x4f, 0xd6, 0xd4, 0x2b, 0xf1, 0x45, 0x41, 0x96,
+        0x11, 0x74, 0x3b, 0x86, 0x7f, 0xd0, 0xcb, 0x04, 0x10, 0x96, 0xf1, 0x10, 0xff, 0xe6, 0x21, 0x97,
+        0xc4, 0x17, 0x32, 0xd8, 0xfc, 0x91, 0x4b, 0x0d, 0x24, 0x64, 0x9a, 0x09, 0x9e, 0x69, 0x12, 0x82,
+        0x66, 0x5c, 0x64, 0x24, 0x14, 0x64, 0xc5, 0x41, 0x84, 0x19, 0x68, 0x7c, 0x59, 0xe7, 0x0a, 0xc8,
+        0x4a, 0xaa, 0x98, 0xf0, 0x95, 0x62, 0x31, 0x10, 0x1e, 0xaf, 0x09, 0x4f, 0xd2, 0x5c, 0x93, 0x18,
+        0x30, 0x40, 0x48, 0xc2, 0x1e, 0x89, 0x14, 0x44, 0xa6, 0x7a, 0xad, 0x64, 0x9e, 0x9a, 0x17, 0xf4,
+        0x29, 0x22, 0x73, 0x6d, 0x74, 0x52, 0x82, 0xc4, 0xe3, 0xaf, 0x5c, 0x5b, 0x40, 0x2a, 0xf7, 0xf7,
+        0x24, 0x83, 0xc0, 0xaa, 0x68, 0xe6, 0x23, 0x2c, 0x0d, 0x3b, 0x6d, 0x71, 0xe6, 0x82, 0x3c, 0x22,
+        0x42, 0x59, 0x1b, 0xe4, 0x62, 0x28, 0x69, 0x19, 0xd3, 0xb1, 0x82, 0xb8, 0xf4, 0x73, 0x7c, 0x4f,
+        0x48, 0xa4, 0x63, 0x51, 0x6f, 0x9e, 0x81, 0xc0, 0x65, 0x0a, 0xeb, 0xee, 0x2b, 0x16, 0x73, 0xb1,
+        0xa7, 0x8f, 0x4c, 0x5d, 0xf6, 0x83, 0x78, 0x58, 0xfa, 0x32, 0xdc, 0xb7, 0x0c, 0x39, 0x2c, 0xd7,
+        0x72, 0x11, 0xb3, 0x9d, 0xbb, 0xe5, 0xa1, 0x8e, 0xe8, 0xf5, 0xcc, 0x4b, 0x77, 0x2d, 0x6d, 0x13,
+        0xdc, 0x68, 0xe1, 0x4b, 0x15, 0x82, 0x72, 0x15, 0x0b, 0x79, 0x9e, 0xd1, 0x39, 0x0e, 0xcb, 0x47,
+        0x50, 0x2b, 0x21, 0xb7, 0xee, 0x8e, 0x46, 0x3c, 0x0c, 0x21, 0x59, 0x6c, 0x51, 0xc7, 0xf5, 0x11,
+        0xf2, 0x86, 0x26, 0x48, 0x0c, 0x13, 0x07, 0x9d, 0xad, 0x62, 0x29, 0x65, 0xc9, 0x7e, 0x1b, 0x81,
+        0x82, 0x85, 0xcf, 0x82, 0x8d, 0x21, 0x25, 0x09, 0x0f, 0xd8, 0x8c, 0xf7, 0x0c, 0x17, 0xd6, 0x0b,
+        0x0f, 0x42, 0xe3, 0x64, 0xc3, 0x45, 0x05, 0x9b, 0xff, 0x09, 0x74, 0x3c, 0xf2, 0xa6, 0x06, 0x0d,
+        0x26, 0x1b, 0x70, 0x23, 0xe0, 0xeb, 0x48, 0xa3, 0x6c, 0x56, 0x52, 0x5a, 0x99, 0x8d, 0xec, 0x15,
+        0xe7, 0x16, 0x37, 0xde, 0x72, 0xb2, 0xb8, 0x75, 0x98, 0x61, 0x19, 0x8d, 0x49, 0x34, 0x21, 0xd1,
+        0x94, 0x44, 0x57, 0x24, 0x9a, 0x91, 0x68, 0x5e, 0xf4, 0x56, 0x3f, 0x03, 0x09, 0x97, 0xaa, 0xb9,
+        0x71, 0xb5, 0x4c, 0xe9, 0xe8, 0xe6, 0x7a, 0x66, 0xce, 0xa2, 0x59, 0xa8, 0x78, 0x76, 0x46, 0x7d,
+        0x7a, 0x13, 0x64, 0xb0, 0x7f, 0x9e, 0x37, 0x28, 0xa9, 0x59, 0x6e, 0x4e, 0x38, 0xdd, 0x39, 0x98,
+        0xa9, 0x78, 0xe8, 0x74, 0x59, 0x9a, 0x20, 0xe4, 0x06, 0x69, 0x7f, 0x85, 0xd1, 0xb4, 0x82, 0x51,
+        0x1c, 0x08, 0x9b, 0x8c, 0x26, 0x15, 0xb6, 0x49, 0xd1, 0x65, 0xf1, 0xa6, 0x12, 0x4e, 0x7b, 0xc2,
+        0x59, 0x25, 0xbc, 0xea, 0x09, 0xeb, 0xe9, 0xb3, 0xae, 0xd0, 0x4a, 0xe6, 0x1d, 0x49, 0xc3, 0x00,
+        0x3b, 0x36, 0xdd, 0x04, 0xf7, 0xb0, 0x64, 0x34, 0x32, 0x8e, 0x70, 0x66, 0x10, 0x6d, 0x61, 0xbe,
+        0xaf, 0x9a, 0xf1, 0x5c, 0x65, 0xa8, 0x10, 0x81, 0x48, 0xcb, 0x43, 0x20, 0x16, 0x8d, 0x1f, 0x22,
+        0x42, 0xeb, 0x89, 0xe7, 0x9d, 0x07, 0xfd, 0xa4, 0x66, 0x4f, 0xc0, 0x4a, 0xd3, 0xd9, 0x59, 0xee,
+        0xa6, 0xd5, 0x7e, 0x4f, 0xec, 0xe4, 0x50, 0xac, 0x0a, 0xda, 0x0d, 0x22, 0x2e, 0xc2, 0xe2, 0xe8,
+        0xbc, 0xbc, 0xa3, 0xd3, 0xf2, 0xca, 0x08, 0x18, 0xee, 0x56, 0xbc, 0x08, 0xe7, 0xd9, 0xc3, 0x9c,
+        0x0e, 0x7b, 0x61, 0xe6, 0xd4, 0x36, 0xd6, 0x81, 0xe9, 0x5a, 0x59, 0xc0, 0x44, 0x70, 0x89, 0x01,
+        0xe9, 0xb8, 0xce, 0xe5, 0xcc, 0x7b, 0xdc, 0xe2, 0xff, 0x99, 0xf7, 0x76, 0x38, 0x74, 0x6c, 0x60,
+        0x36, 0x38, 0xad, 0xd5, 0x56, 0xb5, 0xa3, 0xd3, 0x8e, 0x2a, 0xeb, 0xcc, 0xc7, 0xc3, 0xb5, 0x0d,
+        0x8e, 0xf1, 0xdc, 0xfa, 0x6d, 0xd2, 0xbe, 0x4d, 0x4f, 0x29, 0xe8, 0x5b, 0xd4, 0x50, 0xf0, 0x23,
+        0x5d, 0x71, 0xd5, 0xf2, 0x56, 0xd3, 0x64, 0x02, 0xc3, 0xeb, 0x85, 0xc9, 0x41, 0xbd, 0xc3, 0xf2,
+        0x31, 0xa9, 0xcc, 0xa9, 0x33, 0x5a, 0xfd, 0xcf, 0xe6, 0xb4, 0x6f, 0x7a, 0x9f, 0xc2, 0x0f, 0x95,
+        0xe4, 0xa1, 0x2b, 0xc2, 0xd4, 0x09, 0xba, 0x27, 0xc9, 0x72, 0x3f, 0xe6, 0xfa, 0xe1, 0xc8, 0x5b,
+        0x17, 0x21, 0xcf, 0x52, 0xc1, 0xf6, 0x94, 0x27, 0x36, 0xb6, 0xed, 0x91, 0xb7, 0xc4, 0x63, 0x32,
+        0x73, 0xc6, 0x26, 0x1e, 0x4d, 0xc6, 0x75, 0x31, 0xe7, 0xaf, 0x13, 0x1a, 0x80, 0x69, 0x72, 0x2a,
+        0x49, 0x08, 0x81, 0xac, 0x1a, 0x02, 0x4c, 0x6b, 0x09, 0x2c, 0xb6, 0x11, 0xd7, 0xd8, 0xf7, 0x98,
+        0xda, 0x8f, 0x02, 0x93, 0xd9, 0xce, 0xfa, 0xa4, 0xf5, 0xfd, 0xc5, 0xa9, 0xcf, 0x63, 0xce, 0xa9,
+        0x89, 0x3c, 0x30, 0x5a, 0xa7, 0xd5, 0x2b, 0x9b, 0x02, 0x76, 0x06, 0xb8, 0x01, 0xd6, 0xd2, 0xbd,
+        0x5b, 0xd4, 0x0e, 0x9b, 0x4a, 0x6e, 0x71, 0x9d, 0x5d, 0xb5, 0x25, 0xef, 0x1b, 0x9a, 0x6b, 0x4a,
+        0x48, 0xf8, 0x40, 0x4e, 0x04, 0xa7, 0x84, 0x9e, 0x1f, 0xac, 0xa8, 0x3d, 0x3f, 0x56, 0x93, 0x7c,
+        0x18, 0x6c, 0xe2, 0x29, 0x84, 0x15, 0xcb, 0x85, 0x5e, 0x48, 0xe4, 0x86, 0xeb, 0x3d, 0x1d, 0xcd,
+        0x1a, 0xe0, 0x89, 0x34, 0xcc, 0x62, 0x25, 0x80, 0xb0, 0x1c, 0x55, 0x1b, 0xd3, 0x95, 0x0c, 0xf2,
+        0x8c, 0x34, 0x5f, 0x36, 0x05, 0x90, 0xde, 0x50, 0x6f, 0xe4, 0x14, 0x78, 0xad, 0x75, 0x66, 0xe0,
+        0x64, 0x46, 0x65, 0xcd, 0xe9, 0x84, 0x5a, 0x7e, 0xa2, 0x5f, 0x5b, 0x78, 0x3a, 0xa1, 0x19, 0xa8,
+        0x12, 0xd6, 0x13, 0xc7, 0x8e, 0x59, 0x2d, 0x90, 0xd8, 0x52, 0x6c, 0xfc, 0xd0, 0x56, 0xf9, 0x8c,
+        0xc5, 0xe9, 0x33, 0x05, 0xd9, 0x74, 0x92, 0xe7, 0x66, 0xbc, 0x94, 0x59, 0x9e, 0x4e, 0x29, 0xa7,
+        0x5e, 0xd5, 0xf8, 0xfa, 0x14, 0xa7, 0x98, 0xe2, 0xdd, 0xc9, 0xdd, 0xef, 0x4c, 0xe6, 0xc6, 0x8d,
+        0x8b, 0x7e, 0x74, 0x4f, 0x9f, 0x4a, 0xa0, 0x88, 0xef, 0x90, 0x92, 0xab, 0x9c, 0x75, 0x55, 0xe5,
+        0xac, 0xa6, 0x7d, 0x18, 0x7b, 0xde, 0xdb, 0xb6, 0xf4, 0x53, 0xd3, 0x5b, 0x98, 0x49, 0x8e, 0xb1,
+        0xb0, 0x6b, 0x14, 0x4f, 0xb0, 0x19, 0xe0, 0xba, 0x83, 0xa5, 0x91, 0x54, 0xee, 0xdd, 0x7c, 0xb5,
+        0xc1, 0xd2, 0xf6, 0x71, 0x4d, 0x7e, 0xf4, 0x2c, 0x6b, 0x8e, 0x41, 0xd4, 0x8f, 0xf0, 0xc5, 0xff,
+        0xbc, 0x4d, 0xdd, 0x02, 0xb6, 0x76, 0x8f, 0xe6, 0xd6, 0xf0, 0xff, 0x52, 0x8e, 0x5e, 0x71, 0x4a,
+        0x65, 0x96, 0xc7, 0xb8, 0xe5, 0xbe, 0x38, 0x8a, 0x76, 0x8b, 0x7c, 0x5b, 0xf5, 0x23, 0xd7, 0x5e,
+        0x8b, 0xe6, 0x9b, 0xc4, 0x5b, 0xd3, 0xc3, 0x71, 0x96, 0x1e, 0x55, 0xa5, 0xb8, 0xa7, 0xe3, 0x34,
+        0x0b, 0xf7, 0xd3, 0x2d, 0x3a, 0x42, 0x5f, 0xef, 0xd9, 0xd4, 0x1c, 0xd6, 0x4d, 0x65, 0x17, 0x48,
+        0x48, 0xa9, 0x0f, 0xd8, 0x04, 0x03, 0xd6, 0x76, 0x84, 0x9a, 0x68, 0x3a, 0xf8, 0xe7, 0xaf, 0xbf,
+        0x9d, 0x41, 0x19, 0xa9, 0xe2, 0x38, 0xc7, 0xbd, 0x54, 0x07, 0x6b, 0xb2, 0xad, 0x4b, 0x59, 0x9f,
+        0x69, 0x9a, 0xed, 0x6e, 0x49, 0x19, 0x77, 0x4a, 0x5e, 0xb7, 0x31, 0x7d, 0x0d, 0xcb, 0x02, 0xf0,
+        0x12, 0xda, 0x16, 0x78, 0xea, 0xd9, 0x92, 0x5b, 0xda, 0xa6, 0xbb, 0x89, 0x01, 0xf4, 0x0c, 0xc1,
+        0xd2, 0x0c, 0x68, 0xf3, 0xb2, 0x38, 0x78, 0x76, 0xa9, 0x43, 0xa2, 0xa3, 0xe2, 0xa5, 0x7d, 0x3b,
+        0xc5, 0xc4, 0x94, 0xe6, 0x16, 0x74, 0xbd, 0x5b, 0xf4, 0x74, 0x78, 0x97, 0x1a, 0xf3, 0xa5, 0x8e,
+        0xaa, 0x63, 0xb8, 0x84, 0x47, 0x48, 0x86, 0xcf, 0x29, 0x1b, 0xdc, 0xd8, 0x23, 0xd8, 0xdb, 0xc5,
+        0xf1, 0x09, 0x1d, 0x35, 0x2d, 0xf5, 0xde, 0xf5, 0xc5, 0xa2, 0xe8, 0x47, 0x6c, 0x89, 0x97, 0x95,
+        0x5c, 0x14, 0xbd, 0x7e, 0xc2, 0x30, 0x5c, 0x0a, 0xde, 0x3d, 0x01, 0x1b, 0xec, 0xa8, 0xeb, 0x98,
+        0xbb, 0x8d, 0x70, 0x72, 0x33, 0xc9, 0xb1, 0x53, 0xf1, 0xfd, 0xc4, 0x69, 0xf0, 0x7b, 0x53, 0x1c,
+        0x27, 0x9f, 0xd7, 0x76, 0xe8, 0xdd, 0x8b, 0x4d, 0x7b, 0x2d, 0x2a, 0x4e, 0xca, 0xf7, 0x19, 0x5b,
+        0x9f, 0x89, 0xce, 0xb3, 0x37, 0x8d, 0xd7, 0x27, 0x56, 0x5b, 0xae, 0x23, 0x16, 0x62, 0xa2, 0xb3,
+        0xcd, 0xc1, 0xd9, 0xf2, 0x5d, 0xe2, 0xdd, 0xf0, 0x98, 0xed, 0xef, 0xfe, 0x05, 0x40, 0xc9, 0x16,
+        0x60, 0x5d, 0x11, 0x00, 0x00,
+};
 
-// converted to char array by https://notisrac.github.io/FileToCArray/
-const unsigned char favicon_32x32[]  = {
+// icon/favicon-32x32.png: 820 bytes, stored uncompressed
+#define FAVICON_HASH "a0ad2247"
+#define FAVICON_GZIP false
+const unsigned char favicon_32x32[] = {
         0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
         0x00, 0x00, 0x00, 0x20, 0x00, 0x00, 0x00, 0x20, 0x08, 0x06, 0x00, 0x00, 0x00, 0x73, 0x7a, 0x7a,
         0xf4, 0x00, 0x00, 0x02, 0xfb, 0x49, 0x44, 0x41, 0x54, 0x58, 0x47, 0xcd, 0x97, 0x4b, 0x4c, 0x53,
@@ -58,5 +164,5 @@ const unsigned char favicon_32x32[]  = {
         0x66, 0xd7, 0x31, 0xc5, 0xa9, 0x33, 0x30, 0xc5, 0x29, 0xa1, 0xc5, 0xa9, 0xab, 0x3c, 0x3f, 0xa9,
         0x2e, 0x66, 0x20, 0x0a, 0x56, 0x51, 0x09, 0x33, 0x93, 0xfc, 0x01, 0xf3, 0x6f, 0x2d, 0xfb, 0x03,
         0xed, 0x06, 0xb0, 0xce, 0xb5, 0xc4, 0xb4, 0x59, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44,
-        0xae, 0x42, 0x60, 0x82
-};
\ No newline at end of file
+        0xae, 0x42, 0x60, 0x82,
+};
@@ -0,0 +1,49 @@
+#pragma once
+
+// Stand-in for NukiLockConstants.h of the nuki_ble library, only the types used by the components in the host build
+
+#include <Arduino.h>
+
+namespace NukiLock
+{
+
+struct __attribute__((packed)) KeypadEntry
+{
+    uint16_t codeId;
+    uint32_t code;
+    uint8_t name[20];
+    uint8_t enabled;
+    uint16_t dateCreatedYear;
+    uint8_t dateCreatedMonth;
+    uint8_t dateCreatedDay;
+    uint8_t dateCreatedHour;
+    uint8_t dateCreatedMin;
+    uint8_t dateCreatedSec;
+    uint16_t dateLastActiveYear;
+    uint8_t dateLastActiveMonth;
+    uint8_t dateLastActiveDay;
+    uint8_t dateLastActiveHour;
+    uint8_t dateLastActiveMin;
+    uint8_t dateLastActiveSec;
+    uint16_t lockCount;
+    uint8_t timeLimited;
+    uint16_t allowedFromDateYear;
+    uint8_t allowedFromDateMonth;
+    uint8_t allowedFromDateDay;
+    uint8_t allowedFromDateHour;
+    uint8_t allowedFromDateMin;
+    uint8_t allowedFromDateSec;
+    uint16_t allowedUntilDateYear;
+    uint8_t allowedUntilDateMonth;
+    uint8_t allowedUntilDateDay;
+    uint8_t allowedUntilDateHour;
+    uint8_t allowedUntilDateMin;
+    uint8_t allowedUntilDateSec;
+    uint8_t allowedWeekdays;
+    uint8_t allowedFromTimeHour;
+    uint8_t allowedFromTimeMin;
+    uint8_t allowedUntilTimeHour;
+    uint8_t allowedUntilTimeMin;
+};
+
+}
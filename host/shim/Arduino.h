@@ -0,0 +1,100 @@
+#pragma once
+
+// Minimal Arduino core for the host build: fixed width types, millis() driven by the tests, String and Print.
+
+#include <cstdint>
+#include <cstddef>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <sys/types.h>
+#include <algorithm>
+
+typedef uint8_t byte;
+
+#define F(string_literal) (string_literal)
+
+#define ARDUHAL_LOG_LEVEL_NONE 0
+#define ARDUHAL_LOG_LEVEL_ERROR 1
+#define ARDUHAL_LOG_LEVEL_WARN 2
+#define ARDUHAL_LOG_LEVEL_INFO 3
+#define ARDUHAL_LOG_LEVEL_DEBUG 4
+#define ARDUHAL_LOG_LEVEL_VERBOSE 5
+
+// Not part of glibc, provided by the ESP32 core
+inline char* ltoa(long value, char* str, int base)
+{
+    char* out = str;
+    unsigned long magnitude = value < 0 && base == 10 ? -(unsigned long)value : (unsigned long)value;
+    if(value < 0 && base == 10)
+    {
+        *out++ = '-';
+    }
+    char* digits = out;
+    do
+    {
+        int digit = magnitude % base;
+        *out++ = digit < 10 ? '0' + digit : 'a' + digit - 10;
+        magnitude /= base;
+    } while(magnitude > 0);
+    *out = 0;
+    std::reverse(digits, out);
+    return str;
+}
+
+// Simulated clock, only advanced by hostSetMillis() / hostAdvanceMillis()
+unsigned long millis();
+void hostSetMillis(const unsigned long ts);
+void hostAdvanceMillis(const unsigned long ms);
+
+class String
+{
+public:
+    String() = default;
+    String(const char* str) : _str(str != nullptr ? str : "") {}
+
+    void concat(const char* str) { _str += str; }
+    void concat(const String& str) { _str += str._str; }
+    void concat(const char c) { _str += c; }
+    void concat(const int value) { _str += std::to_string(value); }
+    void concat(const unsigned int value) { _str += std::to_string(value); }
+    void concat(const long value) { _str += std::to_string(value); }
+    void concat(const unsigned long value) { _str += std::to_string(value); }
+
+    const char* c_str() const { return _str.c_str(); }
+    unsigned int length() const { return _str.length(); }
+    bool operator==(const char* str) const { return _str == str; }
+    bool operator!=(const char* str) const { return _str != str; }
+
+private:
+    std::string _str;
+};
+
+class Print
+{
+public:
+    virtual ~Print() = default;
+
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t* buffer, size_t size)
+    {
+        size_t n = 0;
+        while(size-- > 0)
+        {
+            n += write(*buffer++);
+        }
+        return n;
+    }
+
+    size_t print(const char* str) { return write((const uint8_t*)str, strlen(str)); }
+    size_t print(const String& str) { return print(str.c_str()); }
+    size_t print(const long value) { return print(std::to_string(value).c_str()); }
+    size_t print(const unsigned long value) { return print(std::to_string(value).c_str()); }
+    size_t print(const int value) { return print((long)value); }
+    size_t print(const unsigned int value) { return print((unsigned long)value); }
+
+    size_t println() { return print("\r\n"); }
+    template<typename T>
+    size_t println(const T& value) { return print(value) + println(); }
+};
@@ -0,0 +1,41 @@
+#include <Arduino.h>
+#include "Logger.h"
+#include <stdarg.h>
+
+static unsigned long hostMillis = 0;
+
+unsigned long millis()
+{
+    return hostMillis;
+}
+
+void hostSetMillis(const unsigned long ts)
+{
+    hostMillis = ts;
+}
+
+void hostAdvanceMillis(const unsigned long ms)
+{
+    hostMillis += ms;
+}
+
+class StdoutPrint : public Print
+{
+public:
+    size_t write(uint8_t c) override
+    {
+        return fputc(c, stdout) == EOF ? 0 : 1;
+    }
+};
+
+static StdoutPrint stdoutPrint;
+Print* Log = &stdoutPrint;
+
+void logRecord(const char* format, ...)
+{
+    va_list args;
+    va_start(args, format);
+    vprintf(format, args);
+    va_end(args);
+    printf("\n");
+}
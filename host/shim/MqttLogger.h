@@ -0,0 +1,5 @@
+#pragma once
+
+// Logger.h includes MqttLogger.h for the Print interface, the host build logs through a plain Print (see HostShim.cpp)
+
+#include <Arduino.h>
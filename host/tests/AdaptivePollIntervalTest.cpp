@@ -0,0 +1,58 @@
+#include "HostTest.h"
+#include "AdaptivePollInterval.h"
+#include "Config.h"
+
+static void testBackoff()
+{
+    AdaptivePollInterval poll;
+    poll.setBaseInterval(1000);
+    CHECK_EQ(poll.interval(), 1000ul);
+
+    poll.onPoll(false);
+    CHECK_EQ(poll.interval(), 2000ul);
+
+    for(int i = 0; i < 10; i++)
+    {
+        poll.onPoll(false);
+    }
+    CHECK_EQ(poll.interval(), 1000ul * NUKI_POLL_BACKOFF_MAX_FACTOR);
+
+    poll.onPoll(true);
+    CHECK_EQ(poll.interval(), 1000ul);
+
+    CHECK_EQ(poll.pollCount(), 12u);
+    CHECK_EQ(poll.changedCount(), 1u);
+}
+
+static void testTighten()
+{
+    AdaptivePollInterval poll;
+    poll.setBaseInterval(500);
+    poll.onPoll(false);
+    poll.onPoll(false);
+    CHECK(poll.interval() > 500ul);
+
+    poll.tighten();
+    CHECK_EQ(poll.interval(), 500ul);
+    CHECK_EQ(poll.pollCount(), 2u);
+}
+
+static void testText()
+{
+    AdaptivePollInterval poll;
+    poll.setBaseInterval(4000);
+    poll.onPoll(true);
+    poll.onPoll(false);
+
+    String text;
+    poll.getText(text);
+    CHECK(text == "1 of 2 polls returned new data, interval 8 s");
+}
+
+int main()
+{
+    testBackoff();
+    testTighten();
+    testText();
+    return HOST_TEST_RESULT();
+}
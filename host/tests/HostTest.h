@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdio>
+
+// Tiny assertion helpers for the host tests, a test executable returns the number of failed checks
+
+static int hostTestFailures = 0;
+
+#define CHECK(condition) \
+    do \
+    { \
+        if(!(condition)) \
+        { \
+            printf("%s:%d: CHECK failed: %s\n", __FILE__, __LINE__, #condition); \
+            ++hostTestFailures; \
+        } \
+    } while(0)
+
+#define CHECK_EQ(actual, expected) CHECK((actual) == (expected))
+
+#define HOST_TEST_RESULT() (hostTestFailures == 0 ? 0 : 1)
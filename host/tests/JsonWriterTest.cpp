@@ -0,0 +1,56 @@
+#include "HostTest.h"
+#include "JsonWriter.h"
+
+static void testDocument()
+{
+    char buffer[128];
+    JsonWriter json(buffer, sizeof(buffer));
+
+    json.beginObject();
+    json.add("name", "lock");
+    json.add("paired", true);
+    json.addInt("rssi", -67);
+    json.beginArray("topics");
+    json.addValue("a");
+    json.addValue("b");
+    json.endArray();
+    json.addConcat("path", { "nuki", "/", "lock" });
+    json.endObject();
+
+    CHECK(json.ok());
+    CHECK_EQ(strcmp(buffer, "{\"name\":\"lock\",\"paired\":true,\"rssi\":-67,\"topics\":[\"a\",\"b\"],\"path\":\"nuki/lock\"}"), 0);
+    CHECK_EQ(json.length(), strlen(buffer));
+}
+
+static void testEscaping()
+{
+    char buffer[64];
+    JsonWriter json(buffer, sizeof(buffer));
+
+    json.addValue("q\"b\\n\nt\t\x01\x1f");
+
+    CHECK(json.ok());
+    CHECK_EQ(strcmp(buffer, "\"q\\\"b\\\\n\\nt\\t\\u0001\\u001f\""), 0);
+}
+
+static void testOverflow()
+{
+    char buffer[8];
+    JsonWriter json(buffer, sizeof(buffer));
+
+    json.beginObject();
+    json.add("key", "value");
+    json.endObject();
+
+    CHECK(!json.ok());
+    CHECK_EQ(strlen(buffer), sizeof(buffer) - 1);
+    CHECK_EQ(json.length(), sizeof(buffer) - 1);
+}
+
+int main()
+{
+    testDocument();
+    testEscaping();
+    testOverflow();
+    return HOST_TEST_RESULT();
+}
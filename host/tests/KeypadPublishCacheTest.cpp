@@ -0,0 +1,69 @@
+#include "HostTest.h"
+#include "KeypadPublishCache.h"
+
+static NukiLock::KeypadEntry makeEntry(const uint16_t codeId, const char* name)
+{
+    NukiLock::KeypadEntry entry;
+    memset(&entry, 0, sizeof(entry));
+    entry.codeId = codeId;
+    entry.enabled = 1;
+    strncpy((char*)entry.name, name, sizeof(entry.name));
+    return entry;
+}
+
+static void testOnlyChangedSlots()
+{
+    KeypadPublishCache cache;
+    NukiLock::KeypadEntry entry = makeEntry(1, "front door");
+
+    CHECK(cache.update(0, entry));
+    CHECK(!cache.update(0, entry));
+
+    entry.enabled = 0;
+    CHECK(cache.update(0, entry));
+    CHECK(!cache.update(0, entry));
+
+    // Fields that aren't published don't count as a change
+    entry.dateLastActiveYear = 2024;
+    CHECK(!cache.update(0, entry));
+
+    CHECK(cache.update(3, makeEntry(2, "garage")));
+    CHECK(!cache.update(3, makeEntry(2, "garage")));
+}
+
+static void testClear()
+{
+    KeypadPublishCache cache;
+    NukiLock::KeypadEntry entry = makeEntry(7, "guest");
+
+    CHECK(cache.update(0, entry));
+    cache.clear();
+    CHECK(cache.update(0, entry));
+}
+
+static void testRevisionFollowsContent()
+{
+    KeypadPublishCache cache;
+    NukiLock::KeypadEntry entry = makeEntry(1, "front door");
+    cache.update(0, entry);
+    cache.update(1, makeEntry(2, "garage"));
+    uint32_t revision = cache.revision();
+
+    entry.enabled = 0;
+    cache.update(0, entry);
+    CHECK(cache.revision() != revision);
+
+    // A restart rebuilds the same revision from the same codes
+    KeypadPublishCache restarted;
+    restarted.update(0, entry);
+    restarted.update(1, makeEntry(2, "garage"));
+    CHECK_EQ(restarted.revision(), cache.revision());
+}
+
+int main()
+{
+    testOnlyChangedSlots();
+    testClear();
+    testRevisionFollowsContent();
+    return HOST_TEST_RESULT();
+}
@@ -0,0 +1,86 @@
+#include "HostTest.h"
+#include "MqttTopicDispatcher.h"
+
+class RecordingReceiver : public MqttReceiver
+{
+public:
+    void onMqttDataReceived(const MqttTopic& topic, byte* payload, const unsigned int length) override
+    {
+        lastTopic = topic;
+        lastLength = length;
+        ++count;
+    }
+
+    MqttTopic lastTopic = MqttTopic::Count;
+    unsigned int lastLength = 0;
+    int count = 0;
+};
+
+static void testDispatch()
+{
+    MqttTopicDispatcher dispatcher;
+    RecordingReceiver receiver;
+    byte payload[] = "1";
+
+    CHECK(dispatcher.add("nuki/lock/action", &receiver, MqttTopic::LockAction));
+    CHECK(dispatcher.add("nuki/query/lockstate", &receiver, MqttTopic::QueryLockstate));
+
+    CHECK(dispatcher.dispatch("nuki/query/lockstate", payload, 1));
+    CHECK(receiver.lastTopic == MqttTopic::QueryLockstate);
+    CHECK_EQ(receiver.lastLength, 1u);
+
+    CHECK(dispatcher.dispatch("nuki/lock/action", payload, 1));
+    CHECK(receiver.lastTopic == MqttTopic::LockAction);
+
+    CHECK(!dispatcher.dispatch("nuki/lock/unknown", payload, 1));
+    CHECK_EQ(receiver.count, 2);
+}
+
+static void testDuplicatePath()
+{
+    MqttTopicDispatcher dispatcher;
+    RecordingReceiver first;
+    RecordingReceiver second;
+    byte payload[] = "1";
+
+    CHECK(dispatcher.add("nuki/lock/action", &first, MqttTopic::LockAction));
+    CHECK(!dispatcher.add("nuki/lock/action", &second, MqttTopic::LockAction));
+
+    CHECK(dispatcher.dispatch("nuki/lock/action", payload, 1));
+    CHECK_EQ(first.count, 1);
+    CHECK_EQ(second.count, 0);
+}
+
+static void testCapacity()
+{
+    MqttTopicDispatcher dispatcher;
+    RecordingReceiver receiver;
+    static char paths[MQTT_DISPATCHER_MAX_ENTRIES + 1][16];
+
+    for(int i = 0; i <= MQTT_DISPATCHER_MAX_ENTRIES; i++)
+    {
+        snprintf(paths[i], sizeof(paths[i]), "topic/%d", i);
+    }
+    for(int i = 0; i < MQTT_DISPATCHER_MAX_ENTRIES; i++)
+    {
+        CHECK(dispatcher.add(paths[i], &receiver, MqttTopic::LockAction));
+    }
+    CHECK(!dispatcher.add(paths[MQTT_DISPATCHER_MAX_ENTRIES], &receiver, MqttTopic::LockAction));
+    // A full table still reports duplicates as such
+    CHECK(!dispatcher.add(paths[0], &receiver, MqttTopic::LockAction));
+
+    byte payload[] = "";
+    for(int i = 0; i < MQTT_DISPATCHER_MAX_ENTRIES; i++)
+    {
+        CHECK(dispatcher.dispatch(paths[i], payload, 0));
+    }
+    CHECK(!dispatcher.dispatch(paths[MQTT_DISPATCHER_MAX_ENTRIES], payload, 0));
+}
+
+int main()
+{
+    testDispatch();
+    testDuplicatePath();
+    testCapacity();
+    return HOST_TEST_RESULT();
+}
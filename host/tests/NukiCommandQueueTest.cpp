@@ -0,0 +1,71 @@
+#include "HostTest.h"
+#include "NukiCommandQueue.h"
+
+static void testFifoOrder()
+{
+    NukiCommandQueue queue;
+    CHECK(queue.empty());
+
+    NukiCommand command;
+    command.lockAction = 1;
+    uint32_t first = queue.push(command);
+    command.lockAction = 2;
+    uint32_t second = queue.push(command);
+
+    CHECK(first != 0);
+    CHECK(second != 0);
+    CHECK(first != second);
+    CHECK(!queue.empty());
+
+    CHECK_EQ(queue.front()->id, first);
+    CHECK_EQ(queue.front()->lockAction, 1);
+    queue.pop();
+    CHECK_EQ(queue.front()->id, second);
+    CHECK_EQ(queue.front()->lockAction, 2);
+    queue.pop();
+
+    CHECK(queue.empty());
+    CHECK(queue.front() == nullptr);
+}
+
+static void testFullQueueDrops()
+{
+    NukiCommandQueue queue;
+    NukiCommand command;
+
+    for(int i = 0; i < NUKI_COMMAND_QUEUE_SIZE; i++)
+    {
+        CHECK(queue.push(command) != 0);
+    }
+    CHECK_EQ(queue.push(command), 0u);
+    CHECK_EQ(queue.droppedCount(), 1u);
+
+    // A popped slot can be reused, also after the positions wrapped around
+    for(int round = 0; round < 3; round++)
+    {
+        queue.pop();
+        CHECK(queue.push(command) != 0);
+    }
+    CHECK_EQ(queue.droppedCount(), 1u);
+}
+
+static void testFrontStaysUntilPopped()
+{
+    NukiCommandQueue queue;
+    NukiCommand command;
+    uint32_t id = queue.push(command);
+
+    // A command that is retried stays at the front
+    CHECK_EQ(queue.front()->id, id);
+    CHECK_EQ(queue.front()->id, id);
+    queue.pop();
+    CHECK(queue.empty());
+}
+
+int main()
+{
+    testFifoOrder();
+    testFullQueueDrops();
+    testFrontStaysUntilPopped();
+    return HOST_TEST_RESULT();
+}
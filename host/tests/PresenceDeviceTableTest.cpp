@@ -0,0 +1,110 @@
+#include "HostTest.h"
+#include "PresenceDeviceTable.h"
+
+static size_t occupiedSlots(const PresenceDeviceTable& table)
+{
+    size_t count = 0;
+    for(size_t i = 0; i < PRESENCE_TABLE_SIZE; i++)
+    {
+        if(table.slot(i).address != 0)
+        {
+            ++count;
+        }
+    }
+    return count;
+}
+
+static size_t slotIndex(PresenceDeviceTable& table, const PdDevice* device)
+{
+    return device - &table.slot(0);
+}
+
+static void testInsertFind()
+{
+    PresenceDeviceTable table;
+
+    CHECK(table.insert(0) == nullptr);
+    CHECK(table.find(0x112233445566ull) == nullptr);
+
+    PdDevice* device = table.insert(0x112233445566ull);
+    CHECK(device != nullptr);
+    CHECK_EQ(device->address, 0x112233445566ull);
+    CHECK(table.find(0x112233445566ull) == device);
+    CHECK(table.insert(0x112233445566ull) == device);
+    CHECK_EQ(table.size(), 1u);
+}
+
+static void testRemoveKeepsClustersReachable()
+{
+    PresenceDeviceTable table;
+    const size_t count = 60;
+
+    for(uint64_t address = 1; address <= count; address++)
+    {
+        CHECK(table.insert(address) != nullptr);
+    }
+
+    // Remove every third device, the backward shift must keep all others reachable
+    for(uint64_t address = 1; address <= count; address += 3)
+    {
+        PdDevice* device = table.find(address);
+        CHECK(device != nullptr);
+        if(device != nullptr)
+        {
+            table.removeSlot(slotIndex(table, device));
+        }
+    }
+
+    for(uint64_t address = 1; address <= count; address++)
+    {
+        bool removed = (address - 1) % 3 == 0;
+        CHECK((table.find(address) == nullptr) == removed);
+    }
+    CHECK_EQ(table.size(), occupiedSlots(table));
+    CHECK_EQ(table.size(), count - 20);
+}
+
+static void testEvictsOldestUnannounced()
+{
+    PresenceDeviceTable table;
+
+    for(uint64_t address = 1; address <= PRESENCE_TABLE_MAX_DEVICES; address++)
+    {
+        hostSetMillis(1000 + address);
+        PdDevice* device = table.insert(address);
+        device->timestamp = millis();
+        device->announced = address != 5; // the oldest devices are announced except 5
+    }
+    CHECK_EQ(table.size(), (size_t)PRESENCE_TABLE_MAX_DEVICES);
+
+    hostSetMillis(100000);
+    PdDevice* device = table.insert(1000);
+    CHECK(device != nullptr);
+    CHECK(table.find(5) == nullptr);
+    CHECK(table.find(1) != nullptr);
+    CHECK_EQ(table.size(), (size_t)PRESENCE_TABLE_MAX_DEVICES);
+}
+
+static void testFullOfAnnouncedDevices()
+{
+    PresenceDeviceTable table;
+
+    for(uint64_t address = 1; address <= PRESENCE_TABLE_MAX_DEVICES; address++)
+    {
+        table.insert(address)->announced = true;
+    }
+
+    // Announced devices only leave through the presence detection, which publishes their leave event
+    CHECK(table.insert(1000) == nullptr);
+    CHECK_EQ(table.size(), (size_t)PRESENCE_TABLE_MAX_DEVICES);
+    CHECK(table.find(1) != nullptr);
+}
+
+int main()
+{
+    testInsertFind();
+    testRemoveKeepsClustersReachable();
+    testEvictsOldestUnannounced();
+    testFullOfAnnouncedDevices();
+    return HOST_TEST_RESULT();
+}
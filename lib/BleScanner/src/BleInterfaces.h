@@ -13,8 +13,38 @@
 
 #include <NimBLEDevice.h>
 
+#define BLE_SCANNER_FILTER_MAX_ADDRESSES 4
+#define BLE_SCANNER_FILTER_NAME_PREFIX_SIZE 16
+
 namespace BleScanner {
 
+/**
+ * @brief Advertisement filter of a subscriber, evaluated by the scanner before onResult is called
+ *
+ * All criteria that are set must match, an empty filter passes every advertisement
+ */
+struct AdvertisementFilter {
+  uint64_t addresses[BLE_SCANNER_FILTER_MAX_ADDRESSES] = {0}; // any of, compared as NimBLEAddress -> uint64_t
+  uint8_t addressCount = 0;
+  uint16_t manufacturerId = 0; // company id of the manufacturer specific data
+  bool matchManufacturerId = false;
+  uint8_t beaconUuid[16] = {0}; // iBeacon proximity uuid, as transmitted
+  bool matchBeaconUuid = false;
+  char namePrefix[BLE_SCANNER_FILTER_NAME_PREFIX_SIZE] = {0}; // complete or shortened local name
+  int8_t minRssi = -128;
+
+  bool addAddress(const uint64_t address) {
+    if (addressCount >= BLE_SCANNER_FILTER_MAX_ADDRESSES) {
+      return false;
+    }
+    addresses[addressCount++] = address;
+    return true;
+  }
+
+  bool needsPayload() const {
+    return matchManufacturerId || matchBeaconUuid || namePrefix[0] != 0;
+  }
+};
 
 class Subscriber {
   public:
@@ -16,10 +16,6 @@
 
 namespace BleScanner {
 
-Scanner::Scanner(int reservedSubscribers) {
-  subscribers.reserve(reservedSubscribers);
-}
-
 void Scanner::initialize(const std::string& deviceName, const bool wantDuplicates, const uint16_t interval, const uint16_t window) {
   if (!BLEDevice::getInitialized()) {
     BLEDevice::init(deviceName);
@@ -58,24 +54,181 @@ void Scanner::setScanDuration(const uint32_t value) {
   scanDuration = value;
 }
 
+void Scanner::setScanParameters(const uint16_t interval, const uint16_t window) {
+  bleScan->setInterval(interval);
+  bleScan->setWindow(window);
+  if (bleScan->isScanning()) {
+    bleScan->stop();
+  }
+}
+
+bool Scanner::isScanning() const {
+  return bleScan != nullptr && bleScan->isScanning();
+}
+
 void Scanner::subscribe(Subscriber* subscriber) {
-  if (std::find(subscribers.begin(), subscribers.end(), subscriber) != subscribers.end()) {
-    return;
+  subscribe(subscriber, AdvertisementFilter());
+}
+
+void Scanner::subscribe(Subscriber* subscriber, const AdvertisementFilter& filter) {
+  bool added = true;
+
+  portENTER_CRITICAL(&filterMux);
+  int index = indexOf(subscriber);
+  if (index < 0 && subscriberCount < BLE_SCANNER_MAX_SUBSCRIBERS) {
+    index = subscriberCount++;
+    subscribers[index] = subscriber;
+    filters[index] = AdvertisementFilter();
   }
-  subscribers.push_back(subscriber);
+  if (index >= 0) {
+    if (filters[index].needsPayload()) {
+      payloadFilters--;
+    }
+    filters[index] = filter;
+    if (filter.needsPayload()) {
+      payloadFilters++;
+    }
+  } else {
+    added = false;
+  }
+  portEXIT_CRITICAL(&filterMux);
+
+  if (!added) {
+    log_w("BLE Scanner subscriber limit (%d) reached", BLE_SCANNER_MAX_SUBSCRIBERS);
+  }
+}
+
+void Scanner::setFilter(Subscriber* subscriber, const AdvertisementFilter& filter) {
+  portENTER_CRITICAL(&filterMux);
+  int index = indexOf(subscriber);
+  if (index >= 0) {
+    if (filters[index].needsPayload()) {
+      payloadFilters--;
+    }
+    filters[index] = filter;
+    if (filter.needsPayload()) {
+      payloadFilters++;
+    }
+  }
+  portEXIT_CRITICAL(&filterMux);
 }
 
 void Scanner::unsubscribe(Subscriber* subscriber) {
-  auto it = std::find(subscribers.begin(), subscribers.end(), subscriber);
-  if (it != subscribers.end()) {
-    subscribers.erase(it);
+  portENTER_CRITICAL(&filterMux);
+  int index = indexOf(subscriber);
+  if (index >= 0) {
+    if (filters[index].needsPayload()) {
+      payloadFilters--;
+    }
+    for (uint8_t i = index + 1; i < subscriberCount; i++) {
+      subscribers[i - 1] = subscribers[i];
+      filters[i - 1] = filters[i];
+    }
+    subscriberCount--;
+    subscribers[subscriberCount] = nullptr;
   }
+  portEXIT_CRITICAL(&filterMux);
+}
+
+int Scanner::indexOf(const Subscriber* subscriber) const {
+  for (uint8_t i = 0; i < subscriberCount; i++) {
+    if (subscribers[i] == subscriber) {
+      return i;
+    }
+  }
+  return -1;
 }
 
 void Scanner::onResult(NimBLEAdvertisedDevice* advertisedDevice) {
-  for (const auto& subscriber : subscribers) {
-    subscriber->onResult(advertisedDevice);
+  AdvertisementFields fields;
+  fields.address = advertisedDevice->getAddress();
+  if (advertisedDevice->haveRSSI()) {
+    fields.rssi = advertisedDevice->getRSSI();
+  }
+  if (payloadFilters > 0) {
+    parsePayload(advertisedDevice, fields);
   }
+
+  // Evaluate all filters in one pass, the subscribers are called outside of the critical section
+  Subscriber* matched[BLE_SCANNER_MAX_SUBSCRIBERS];
+  size_t matchedCount = 0;
+
+  portENTER_CRITICAL(&filterMux);
+  for (size_t i = 0; i < subscriberCount; i++) {
+    if (matches(filters[i], fields)) {
+      matched[matchedCount++] = subscribers[i];
+    }
+  }
+  portEXIT_CRITICAL(&filterMux);
+
+  for (size_t i = 0; i < matchedCount; i++) {
+    matched[i]->onResult(advertisedDevice);
+  }
+}
+
+void Scanner::parsePayload(NimBLEAdvertisedDevice* advertisedDevice, AdvertisementFields& fields) {
+  // Walk the advertisement structures (length, type, data) once for all filters
+  const uint8_t* payload = advertisedDevice->getPayload();
+  size_t length = advertisedDevice->getPayloadLength();
+  size_t index = 0;
+
+  while (index + 1 < length && payload[index] != 0) {
+    uint8_t fieldLength = payload[index];
+    uint8_t type = payload[index + 1];
+    if (index + 1 + fieldLength > length) {
+      break;
+    }
+
+    if (type == BLE_HS_ADV_TYPE_COMP_NAME || (type == BLE_HS_ADV_TYPE_INCOMP_NAME && fields.name == nullptr)) {
+      fields.name = &payload[index + 2];
+      fields.nameLength = fieldLength - 1;
+    } else if (type == BLE_HS_ADV_TYPE_MFG_DATA && fields.manufacturerData == nullptr) {
+      fields.manufacturerData = &payload[index + 2];
+      fields.manufacturerDataLength = fieldLength - 1;
+    }
+
+    index += fieldLength + 1;
+  }
+}
+
+bool Scanner::matches(const AdvertisementFilter& filter, const AdvertisementFields& fields) {
+  if (fields.rssi < filter.minRssi) {
+    return false;
+  }
+
+  if (filter.addressCount > 0) {
+    bool found = false;
+    for (uint8_t i = 0; i < filter.addressCount && !found; i++) {
+      found = filter.addresses[i] == fields.address;
+    }
+    if (!found) {
+      return false;
+    }
+  }
+
+  if (filter.matchManufacturerId) {
+    if (fields.manufacturerDataLength < 2 ||
+        (fields.manufacturerData[0] | (fields.manufacturerData[1] << 8)) != filter.manufacturerId) {
+      return false;
+    }
+  }
+
+  if (filter.matchBeaconUuid) {
+    // company id (2), beacon type 0x02, length 0x15, uuid (16), major, minor, tx power
+    if (fields.manufacturerDataLength < 25 || fields.manufacturerData[2] != 0x02 || fields.manufacturerData[3] != 0x15 ||
+        memcmp(&fields.manufacturerData[4], filter.beaconUuid, sizeof(filter.beaconUuid)) != 0) {
+      return false;
+    }
+  }
+
+  if (filter.namePrefix[0] != 0) {
+    size_t prefixLength = strnlen(filter.namePrefix, sizeof(filter.namePrefix));
+    if (fields.nameLength < prefixLength || memcmp(fields.name, filter.namePrefix, prefixLength) != 0) {
+      return false;
+    }
+  }
+
+  return true;
 }
 
 } // namespace BleScanner
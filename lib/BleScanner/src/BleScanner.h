@@ -16,11 +16,13 @@
 #include <NimBLEDevice.h>
 #include "BleInterfaces.h"
 
+#define BLE_SCANNER_MAX_SUBSCRIBERS 10
+
 namespace BleScanner {
 
 class Scanner : public Publisher, BLEAdvertisedDeviceCallbacks {
   public:
-    Scanner(int reservedSubscribers = 10);
+    Scanner() = default;
     ~Scanner() = default;
 
     /**
@@ -48,6 +50,20 @@ class Scanner : public Publisher, BLEAdvertisedDeviceCallbacks {
      */
     void setScanDuration(const uint32_t value);
 
+    /**
+     * @brief Set the scan interval and window, a running scan is restarted with the new values on the next update()
+     *
+     * @param interval Time in ms from the start of a window until the start of the next window
+     * @param window time in ms to scan
+     */
+    void setScanParameters(const uint16_t interval, const uint16_t window);
+
+    /**
+     * @brief true if a scan is currently running
+     *
+     */
+    bool isScanning() const;
+
     /**
      * @brief enable/disable scanning
      *
@@ -56,12 +72,28 @@ class Scanner : public Publisher, BLEAdvertisedDeviceCallbacks {
     void enableScanning(bool enable);
 
     /**
-     * @brief Subscribe to the scanner and receive results
+     * @brief Subscribe to the scanner and receive results, at most BLE_SCANNER_MAX_SUBSCRIBERS subscribers are accepted
      *
      * @param subscriber
      */
     void subscribe(Subscriber* subscriber) override;
 
+    /**
+     * @brief Subscribe to the scanner and only receive advertisements matching the filter
+     *
+     * @param subscriber
+     * @param filter
+     */
+    void subscribe(Subscriber* subscriber, const AdvertisementFilter& filter);
+
+    /**
+     * @brief Replace the filter of a subscriber, an empty filter passes every advertisement
+     *
+     * @param subscriber
+     * @param filter
+     */
+    void setFilter(Subscriber* subscriber, const AdvertisementFilter& filter);
+
     /**
      * @brief Un-Subscribe the scanner
      *
@@ -77,9 +109,34 @@ class Scanner : public Publisher, BLEAdvertisedDeviceCallbacks {
     void onResult(NimBLEAdvertisedDevice* advertisedDevice) override;
 
   private:
+    /**
+     * @brief Fields of an advertisement the filters are matched against, the payload is only parsed if a filter needs it
+     */
+    struct AdvertisementFields {
+      uint64_t address = 0;
+      int rssi = -128;
+      const uint8_t* name = nullptr;
+      uint8_t nameLength = 0;
+      const uint8_t* manufacturerData = nullptr;
+      uint8_t manufacturerDataLength = 0;
+    };
+
+    static void parsePayload(NimBLEAdvertisedDevice* advertisedDevice, AdvertisementFields& fields);
+    static bool matches(const AdvertisementFilter& filter, const AdvertisementFields& fields);
+
+    /**
+     * @brief Index of the subscriber or -1, must be called with filterMux held
+     */
+    int indexOf(const Subscriber* subscriber) const;
+
     uint32_t scanDuration = 3;
     BLEScan* bleScan = nullptr;
-    std::vector<Subscriber*> subscribers;
+    // Fixed size so (un)subscribing never allocates while filterMux is held
+    Subscriber* subscribers[BLE_SCANNER_MAX_SUBSCRIBERS] = {};
+    AdvertisementFilter filters[BLE_SCANNER_MAX_SUBSCRIBERS]; // same index as subscribers
+    uint8_t subscriberCount = 0;
+    uint8_t payloadFilters = 0; // number of filters that need the parsed payload
+    portMUX_TYPE filterMux = portMUX_INITIALIZER_UNLOCKED;
     uint16_t scanErrors = 0;
     bool scanningEnabled = true;
 };
@@ -1,18 +1,27 @@
 #include "MqttLogger.h"
 #include "Arduino.h"
+#include <new>
+#include <esp_heap_caps.h>
 
 MqttLogger::MqttLogger(MqttLoggerMode mode)
+: enqueuePos(0),
+  dequeuePos(0),
+  droppedCount(0)
 {
     this->setMode(mode);
     this->setBufferSize(MQTT_MAX_PACKET_SIZE);
 }
 
 MqttLogger::MqttLogger(NetworkDevice* client, const char* topic, MqttLoggerMode mode)
+: enqueuePos(0),
+  dequeuePos(0),
+  droppedCount(0)
 {
     this->setClient(client);
     this->setTopic(topic);
     this->setMode(mode);
     this->setBufferSize(MQTT_MAX_PACKET_SIZE);
+    this->begin();
 }
 
 MqttLogger::~MqttLogger()
@@ -68,49 +77,199 @@ boolean MqttLogger::setBufferSize(uint16_t size)
     return (this->buffer != NULL);
 }
 
+// allocate the ring (PSRAM if available) and start the task publishing it
+void MqttLogger::begin()
+{
+    if (this->mode == MqttLoggerMode::SerialOnly || this->ring != NULL)
+    {
+        return;
+    }
+
+    void* mem = heap_caps_malloc(MQTT_LOG_RING_SIZE, MALLOC_CAP_SPIRAM | MALLOC_CAP_8BIT);
+    if (mem == NULL)
+    {
+        mem = malloc(MQTT_LOG_RING_SIZE);
+    }
+    if (mem == NULL)
+    {
+        return;
+    }
+
+    memset(mem, 0, MQTT_LOG_RING_SIZE);
+    this->ring = (uint8_t*)mem;
+
+    xTaskCreatePinnedToCore(MqttLogger::flushTask, "mqlog", MQTT_LOG_TASK_STACK_SIZE, this, MQTT_LOG_TASK_PRIORITY, &this->taskHandle, 1);
+}
+
+void MqttLogger::flushTask(void* param)
+{
+    MqttLogger* logger = (MqttLogger*)param;
+    while (true)
+    {
+        vTaskDelay(MQTT_LOG_FLUSH_INTERVAL / portTICK_PERIOD_MS);
+        logger->publishQueued();
+    }
+}
+
+// multi-producer enqueue. a record (header + data, padded to 4 bytes) is reserved with a single CAS, so records of
+// different tasks never interleave. the header holds the length and is stored last to commit the record. never blocks,
+// a record that doesn't fit is dropped as a whole and counted
+bool MqttLogger::enqueue(const uint8_t* data, size_t size)
+{
+    if (size == 0)
+    {
+        return true;
+    }
+
+    uint32_t recordSize = (MQTT_LOG_RECORD_HEADER_SIZE + size + 3) & ~3u;
+    if (recordSize > MQTT_LOG_RING_SIZE)
+    {
+        this->droppedCount.fetch_add(1, std::memory_order_relaxed);
+        return false;
+    }
+
+    uint32_t pos = this->enqueuePos.load(std::memory_order_relaxed);
+    do
+    {
+        if (recordSize > MQTT_LOG_RING_SIZE - (pos - this->dequeuePos.load(std::memory_order_acquire)))
+        {
+            this->droppedCount.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        }
+    } while (!this->enqueuePos.compare_exchange_weak(pos, pos + recordSize, std::memory_order_relaxed));
+
+    this->copyToRing(pos + MQTT_LOG_RECORD_HEADER_SIZE, data, size);
+    __atomic_store_n((uint32_t*)&this->ring[pos & (MQTT_LOG_RING_SIZE - 1)], (uint32_t)size, __ATOMIC_RELEASE);
+    return true;
+}
+
+void MqttLogger::copyToRing(uint32_t pos, const uint8_t* data, size_t size)
+{
+    uint32_t index = pos & (MQTT_LOG_RING_SIZE - 1);
+    size_t first = MQTT_LOG_RING_SIZE - index;
+    if (first > size)
+    {
+        first = size;
+    }
+    memcpy(&this->ring[index], data, first);
+    memcpy(this->ring, data + first, size - first);
+}
+
+void MqttLogger::appendToBuffer(const uint8_t* data, size_t size)
+{
+    for (size_t i = 0; i < size; i++)
+    {
+        if (data[i] == '\r')
+        {
+            continue;
+        }
+        if (this->bufferCnt >= this->bufferSize)
+        {
+            this->sendBuffer();
+        }
+        *(this->bufferEnd++) = data[i];
+        this->bufferCnt++;
+    }
+}
+
+// single consumer, only called from the logger task
+void MqttLogger::publishQueued()
+{
+    if (this->ring == NULL)
+    {
+        return;
+    }
+
+    uint32_t dropped = this->droppedCount.load(std::memory_order_relaxed);
+    if (dropped != this->reportedDroppedCount)
+    {
+        char str[48];
+        int len = snprintf(str, sizeof(str), "[%u log messages dropped]\n", (unsigned int)(dropped - this->reportedDroppedCount));
+        this->appendToBuffer((const uint8_t*)str, len);
+        this->reportedDroppedCount = dropped;
+    }
+
+    uint32_t pos = this->dequeuePos.load(std::memory_order_relaxed);
+    while (true)
+    {
+        uint32_t index = pos & (MQTT_LOG_RING_SIZE - 1);
+        uint32_t size = __atomic_load_n((uint32_t*)&this->ring[index], __ATOMIC_ACQUIRE);
+        if (size == 0)
+        {
+            break;
+        }
+
+        uint32_t recordSize = (MQTT_LOG_RECORD_HEADER_SIZE + size + 3) & ~3u;
+        uint32_t dataIndex = (index + MQTT_LOG_RECORD_HEADER_SIZE) & (MQTT_LOG_RING_SIZE - 1);
+        size_t first = MQTT_LOG_RING_SIZE - dataIndex;
+        if (first > size)
+        {
+            first = size;
+        }
+        this->appendToBuffer(&this->ring[dataIndex], first);
+        this->appendToBuffer(this->ring, size - first);
+
+        // cleared before the space is handed back, so every header a producer reserves later reads 0 until committed
+        size_t clear = MQTT_LOG_RING_SIZE - index;
+        if (clear > recordSize)
+        {
+            clear = recordSize;
+        }
+        memset(&this->ring[index], 0, clear);
+        memset(this->ring, 0, recordSize - clear);
+
+        pos += recordSize;
+        this->dequeuePos.store(pos, std::memory_order_release);
+    }
+
+    this->sendBuffer();
+}
+
+uint32_t MqttLogger::getDroppedCount() const
+{
+    return this->droppedCount.load(std::memory_order_relaxed);
+}
+
 // send & reset current buffer
 void MqttLogger::sendBuffer() 
 {
     if (this->bufferCnt > 0)
     {
-        bool doSerial = this->mode==MqttLoggerMode::SerialOnly || this->mode==MqttLoggerMode::MqttAndSerial;
-        if (this->mode!=MqttLoggerMode::SerialOnly && this->client != NULL && this->client->mqttConnected())
+        if (this->client != NULL && this->client->mqttConnected())
         {
             this->client->mqttPublish(topic, 0, true, (uint8_t*)this->buffer, this->bufferCnt);
         } else if (this->mode == MqttLoggerMode::MqttAndSerialFallback)
-        {
-            doSerial = true;
-        }
-        if (doSerial) 
         {
             Serial.write(this->buffer, this->bufferCnt);
-            Serial.println();
         }
         this->bufferCnt=0;
     }
     this->bufferEnd=this->buffer;
 }
 
-// implement Print::write(uint8_t c): store into a buffer until \n or buffer full
+// implement Print::write(uint8_t c)
 size_t MqttLogger::write(uint8_t character)
 {
-    if (character == '\n') // when newline is printed we send the buffer
+    return this->write(&character, 1);
+}
+
+// serial output stays synchronous, mqtt output is queued for the logger task
+size_t MqttLogger::write(const uint8_t* buffer, size_t size)
+{
+    if (this->mode == MqttLoggerMode::SerialOnly || this->mode == MqttLoggerMode::MqttAndSerial)
     {
-        this->sendBuffer();
+        Serial.write(buffer, size);
     }
-    else
+    if (this->mode != MqttLoggerMode::SerialOnly)
     {
-        if (this->bufferCnt < this->bufferSize) // add char to end of buffer
+        if (this->ring != NULL)
         {
-            *(this->bufferEnd++) = character;
-            this->bufferCnt++;
+            this->enqueue(buffer, size);
         }
-        else // buffer is full, first send&reset buffer and then add char to buffer
+        else if (this->mode == MqttLoggerMode::MqttAndSerialFallback)
         {
-            this->sendBuffer();
-            *(this->bufferEnd++) = character;
-            this->bufferCnt++;
+            Serial.write(buffer, size);
         }
     }
-    return 1;
-}
\ No newline at end of file
+    return size;
+}
@@ -11,10 +11,19 @@
 
 #include <Arduino.h>
 #include <Print.h>
+#include <atomic>
 #include "../../../networkDevices/NetworkDevice.h"
 
 #define MQTT_MAX_PACKET_SIZE 1024
 
+// Log output is queued as variable length records (length header + bytes) in a byte ring and published by a low
+// priority task once per flush interval
+#define MQTT_LOG_RING_SIZE 4096 // bytes, must be a power of two
+#define MQTT_LOG_RECORD_HEADER_SIZE 4
+#define MQTT_LOG_FLUSH_INTERVAL 1000 // ms
+#define MQTT_LOG_TASK_STACK_SIZE 2048
+#define MQTT_LOG_TASK_PRIORITY 1
+
 enum MqttLoggerMode {
     MqttAndSerialFallback = 0,
     SerialOnly = 1,
@@ -25,13 +34,28 @@ enum MqttLoggerMode {
 class MqttLogger : public Print
 {
 private:
+    static_assert((MQTT_LOG_RING_SIZE & (MQTT_LOG_RING_SIZE - 1)) == 0, "MQTT_LOG_RING_SIZE must be a power of two");
+
     const char* topic;
     uint8_t* buffer;
     uint8_t* bufferEnd;
     uint16_t bufferCnt = 0, bufferSize = 0;
     NetworkDevice* client;
     MqttLoggerMode mode;
+
+    uint8_t* ring = NULL; // records start 4 byte aligned, a header of 0 marks a record that isn't committed yet
+    std::atomic<uint32_t> enqueuePos;
+    std::atomic<uint32_t> dequeuePos;
+    std::atomic<uint32_t> droppedCount;
+    uint32_t reportedDroppedCount = 0;
+    TaskHandle_t taskHandle = NULL;
+
+    void begin();
+    bool enqueue(const uint8_t* data, size_t size);
+    void copyToRing(uint32_t pos, const uint8_t* data, size_t size);
+    void appendToBuffer(const uint8_t* data, size_t size);
     void sendBuffer();
+    static void flushTask(void* param);
 
 public:
     MqttLogger(MqttLoggerMode mode=MqttLoggerMode::MqttAndSerialFallback);
@@ -44,7 +68,12 @@ public:
     void setRetained(boolean retained);
     
     virtual size_t write(uint8_t);
+    virtual size_t write(const uint8_t* buffer, size_t size);
     using Print::write;
+
+    // Publishes everything queued so far, only called by the logger task
+    void publishQueued();
+    uint32_t getDroppedCount() const;
     
     uint16_t getBufferSize();
     boolean setBufferSize(uint16_t size);
@@ -41,10 +41,18 @@ enum HTTPAuthMethod { BASIC_AUTH, DIGEST_AUTH };
 #define HTTP_UPLOAD_BUFLEN 1436
 #endif
 
+#ifndef HTTP_MAX_DATA_WAIT
 #define HTTP_MAX_DATA_WAIT 5000 //ms to wait for the client to send the request
+#endif
+#ifndef HTTP_MAX_POST_WAIT
 #define HTTP_MAX_POST_WAIT 5000 //ms to wait for POST data to arrive
+#endif
+#ifndef HTTP_MAX_SEND_WAIT
 #define HTTP_MAX_SEND_WAIT 5000 //ms to wait for data chunk to be ACKed
+#endif
+#ifndef HTTP_MAX_CLOSE_WAIT
 #define HTTP_MAX_CLOSE_WAIT 2000 //ms to wait for the client to close the connection
+#endif
 
 #define CONTENT_LENGTH_UNKNOWN ((size_t) -1)
 #define CONTENT_LENGTH_NOT_SET ((size_t) -2)
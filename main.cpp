@@ -5,6 +5,7 @@
 #include <RTOS.h>
 #include "PreferencesKeys.h"
 #include "PresenceDetection.h"
+#include "BleScanScheduler.h"
 #include "hardware/W5500EthServer.h"
 #include "hardware/WifiEthServer.h"
 #include "NukiOpenerWrapper.h"
@@ -12,14 +13,17 @@
 #include "Logger.h"
 #include "Config.h"
 #include "RestartReason.h"
-#include "CharBuffer.h"
+#include "ScratchBuffer.h"
+#include "StatusSnapshot.h"
 #include "NukiDeviceId.h"
+#include "NukiTask.h"
 
 Network* network = nullptr;
 NetworkLock* networkLock = nullptr;
 NetworkOpener* networkOpener = nullptr;
 WebCfgServer* webCfgServer = nullptr;
 BleScanner::Scanner* bleScanner = nullptr;
+BleScanScheduler* scanScheduler = nullptr;
 NukiWrapper* nuki = nullptr;
 NukiOpenerWrapper* nukiOpener = nullptr;
 PresenceDetection* presenceDetection = nullptr;
@@ -28,9 +32,12 @@ NukiDeviceId* deviceIdOpener = nullptr;
 Preferences* preferences = nullptr;
 EthServer* ethServer = nullptr;
 Gpio* gpio = nullptr;
+StatusSnapshot* statusSnapshot = nullptr;
 
 bool lockEnabled = false;
 bool openerEnabled = false;
+// The W5500 is driven through the (not thread safe) Ethernet library, its web server is served from the network task
+bool webCfgInNetworkTask = false;
 unsigned long restartTs = (2^32) - 5 * 60000;
 
 RTC_NOINIT_ATTR int restartReason;
@@ -41,8 +48,28 @@ RestartReason currentRestartReason = RestartReason::NotApplicable;
 
 TaskHandle_t networkTaskHandle = nullptr;
 TaskHandle_t nukiTaskHandle = nullptr;
+TaskHandle_t webCfgTaskHandle = nullptr;
 TaskHandle_t presenceDetectionTaskHandle = nullptr;
 
+void wakeNukiTask()
+{
+    if(nukiTaskHandle == nullptr) return;
+
+    if(xPortInIsrContext())
+    {
+        BaseType_t higherPriorityTaskWoken = pdFALSE;
+        vTaskNotifyGiveFromISR(nukiTaskHandle, &higherPriorityTaskWoken);
+        if(higherPriorityTaskWoken == pdTRUE)
+        {
+            portYIELD_FROM_ISR();
+        }
+    }
+    else
+    {
+        xTaskNotifyGive(nukiTaskHandle);
+    }
+}
+
 void networkTask(void *pvParameters)
 {
     while(true)
@@ -52,7 +79,10 @@ void networkTask(void *pvParameters)
         {
             networkOpener->update();
         }
-        webCfgServer->update();
+        if(webCfgInNetworkTask)
+        {
+            webCfgServer->update();
+        }
 
         // millis() is about to overflow. Restart device to prevent problems with overflow
         if(millis() > restartTs)
@@ -73,29 +103,58 @@ void networkTask(void *pvParameters)
     }
 }
 
-void nukiTask(void *pvParameters)
+void webCfgTask(void *pvParameters)
 {
     while(true)
     {
-        bleScanner->update();
-        delay(20);
+        webCfgServer->update();
+        delay(WEB_CFG_TASK_INTERVAL);
+    }
+}
 
+void nukiTask(void *pvParameters)
+{
+    while(true)
+    {
         bool needsPairing = (lockEnabled && !nuki->isPaired()) || (openerEnabled && !nukiOpener->isPaired());
 
+        unsigned long ts = millis();
+        bool bleWorkDue = (lockEnabled && nuki->bleWorkPending(ts)) || (openerEnabled && nukiOpener->bleWorkPending(ts));
+
+        // Keep the radio free while talking to the lock or opener, pairing relies on the scan to find the device
+        if(bleWorkDue && !needsPairing)
+        {
+            scanScheduler->pause();
+        }
+        else
+        {
+            scanScheduler->resume();
+        }
+
         if (needsPairing)
         {
             delay(5000);
         }
 
+        unsigned long nextUpdateTs = millis() + NUKI_TASK_MAX_IDLE_TIME;
+
         if(lockEnabled)
         {
             nuki->update();
+            nextUpdateTs = std::min(nextUpdateTs, nuki->nextUpdateTs());
         }
         if(openerEnabled)
         {
             nukiOpener->update();
+            nextUpdateTs = std::min(nextUpdateTs, nukiOpener->nextUpdateTs());
         }
 
+        scanScheduler->resume();
+
+        // Sleep until the next scheduled refresh, or until a command, GPIO event or beacon wakes the task
+        ts = millis();
+        TickType_t waitTicks = nextUpdateTs > ts ? pdMS_TO_TICKS(nextUpdateTs - ts) : 0;
+        ulTaskNotifyTake(pdTRUE, waitTicks);
     }
 }
 
@@ -114,7 +173,11 @@ void setupTasks()
 
     xTaskCreatePinnedToCore(networkTask, "ntw", 8192, NULL, 3, &networkTaskHandle, 1);
     xTaskCreatePinnedToCore(nukiTask, "nuki", 3328, NULL, 2, &nukiTaskHandle, 1);
-    xTaskCreatePinnedToCore(presenceDetectionTask, "prdet", 896, NULL, 5, &presenceDetectionTaskHandle, 1);
+    xTaskCreatePinnedToCore(presenceDetectionTask, "prdet", 1280, NULL, 5, &presenceDetectionTaskHandle, 1);
+    if(!webCfgInNetworkTask)
+    {
+        xTaskCreatePinnedToCore(webCfgTask, "web", 4096, NULL, 1, &webCfgTaskHandle, 1);
+    }
 }
 
 void initEthServer(const NetworkDeviceType device)
@@ -171,7 +234,7 @@ void setup()
         deviceIdOpener->assignId(deviceIdLock->get());
     }
 
-    CharBuffer::initialize();
+    ScratchBufferPool::initialize();
 
     if(preferences->getInt(preference_restart_timer) != 0)
     {
@@ -186,16 +249,18 @@ void setup()
     lockEnabled = preferences->getBool(preference_lock_enabled);
     openerEnabled = preferences->getBool(preference_opener_enabled);
 
+    statusSnapshot = new StatusSnapshot();
+
     const String mqttLockPath = preferences->getString(preference_mqtt_lock_path);
-    network = new Network(preferences, gpio, mqttLockPath, CharBuffer::get(), CHAR_BUFFER_SIZE);
+    network = new Network(preferences, gpio, statusSnapshot, mqttLockPath);
     network->initialize();
 
-    networkLock = new NetworkLock(network, preferences, CharBuffer::get(), CHAR_BUFFER_SIZE);
+    networkLock = new NetworkLock(network, preferences);
     networkLock->initialize();
 
     if(openerEnabled)
     {
-        networkOpener = new NetworkOpener(network, preferences, CharBuffer::get(), CHAR_BUFFER_SIZE);
+        networkOpener = new NetworkOpener(network, preferences);
         networkOpener->initialize();
     }
 
@@ -204,26 +269,37 @@ void setup()
     bleScanner = new BleScanner::Scanner();
     bleScanner->initialize("NukiHub");
     bleScanner->setScanDuration(10);
+    scanScheduler = new BleScanScheduler(bleScanner);
 
     Log->println(lockEnabled ? F("NUKI Lock enabled") : F("NUKI Lock disabled"));
     if(lockEnabled)
     {
-        nuki = new NukiWrapper("NukiHub", deviceIdLock, bleScanner, networkLock, gpio, preferences);
+        nuki = new NukiWrapper("NukiHub", deviceIdLock, bleScanner, networkLock, gpio, statusSnapshot, preferences);
         nuki->initialize(firstStart);
     }
 
     Log->println(openerEnabled ? F("NUKI Opener enabled") : F("NUKI Opener disabled"));
     if(openerEnabled)
     {
-        nukiOpener = new NukiOpenerWrapper("NukiHub", deviceIdOpener, bleScanner, networkOpener, gpio, preferences);
+        nukiOpener = new NukiOpenerWrapper("NukiHub", deviceIdOpener, bleScanner, networkOpener, gpio, statusSnapshot, preferences);
         nukiOpener->initialize();
     }
 
-    webCfgServer = new WebCfgServer(nuki, nukiOpener, network, gpio, ethServer, preferences, network->networkDeviceType() == NetworkDeviceType::WiFi);
+    webCfgServer = new WebCfgServer(nuki, nukiOpener, network, scanScheduler, statusSnapshot, gpio, ethServer, preferences, network->networkDeviceType() == NetworkDeviceType::WiFi);
     webCfgServer->initialize();
+    webCfgInNetworkTask = network->networkDeviceType() == NetworkDeviceType::W5500;
+    if(webCfgInNetworkTask)
+    {
+        // Keep the web server responsive while the network task waits for the MQTT broker, the web task does that otherwise
+        network->setKeepAliveCallback([]()
+            {
+                webCfgServer->update();
+            });
+    }
 
-    presenceDetection = new PresenceDetection(preferences, bleScanner, network, CharBuffer::get(), CHAR_BUFFER_SIZE);
+    presenceDetection = new PresenceDetection(preferences, bleScanner, network);
     presenceDetection->initialize();
+    scanScheduler->initialize(presenceDetection->enabled());
 
     setupTasks();
 }
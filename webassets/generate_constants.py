@@ -0,0 +1,61 @@
+#!/usr/bin/env python3
+# Generates WebCfgServerConstants.h from the static web assets. Run after changing an asset:
+#   python3 webassets/generate_constants.py
+#
+# Assets are stored gzip compressed when that makes them smaller (the PNG icon is already deflate compressed) and
+# served as is with Content-Encoding: gzip. The FNV-1a hash of the uncompressed content is used as ETag and as
+# version parameter in the asset URL, so browsers can cache the assets until the next firmware changes them.
+
+import gzip
+import os
+
+ROOT = os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# (array name, define prefix, source file)
+ASSETS = [
+    ("stylecss", "STYLE_CSS", "webassets/style.css"),
+    ("favicon_32x32", "FAVICON", "icon/favicon-32x32.png"),
+]
+
+
+def fnv1a(data):
+    h = 2166136261
+    for b in data:
+        h ^= b
+        h = (h * 16777619) & 0xffffffff
+    return h
+
+
+def to_array(name, data):
+    lines = []
+    for i in range(0, len(data), 16):
+        lines.append("        " + ", ".join("0x%02x" % b for b in data[i:i + 16]) + ",")
+    return "const unsigned char %s[] = {\n%s\n};\n" % (name, "\n".join(lines))
+
+
+def main():
+    out = [
+        "#pragma once\n",
+        "// Generated by webassets/generate_constants.py, do not edit. Sources:",
+    ]
+    out += ["//   %s" % source for _, _, source in ASSETS]
+    out.append("")
+
+    for name, prefix, source in ASSETS:
+        with open(os.path.join(ROOT, source), "rb") as f:
+            data = f.read()
+
+        compressed = gzip.compress(data, compresslevel=9, mtime=0)
+        useGzip = len(compressed) < len(data)
+
+        out.append("// %s: %d bytes, %s" % (source, len(data), "%d bytes gzip compressed" % len(compressed) if useGzip else "stored uncompressed"))
+        out.append("#define %s_HASH \"%08x\"" % (prefix, fnv1a(data)))
+        out.append("#define %s_GZIP %s" % (prefix, "true" if useGzip else "false"))
+        out.append(to_array(name, compressed if useGzip else data))
+
+    with open(os.path.join(ROOT, "WebCfgServerConstants.h"), "w", newline="\n") as f:
+        f.write("\n".join(out))
+
+
+if __name__ == "__main__":
+    main()